@@ -0,0 +1,131 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "logger.h"
+
+/* Allocations are aligned to the strictest of the types the assembler stores */
+typedef union ArenaAlign
+{
+    long    l;
+    double  d;
+    void*   p;
+} ArenaAlign;
+
+#define ARENA_ALIGN(size) (((size) + sizeof(ArenaAlign) - 1) / sizeof(ArenaAlign) * sizeof(ArenaAlign))
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(ArenaBlock))
+#define ARENA_BLOCK_DATA(block) ((char*)(block) + ARENA_HEADER_SIZE)
+
+/* Allocates a block of at least 'size' bytes and links it after the last block */
+static ArenaBlock* arena_add_block(Arena* arena, size_t size)
+{
+    ArenaBlock* block;
+
+    if (size < arena->block_size)
+        size = arena->block_size;
+
+    block = malloc(ARENA_HEADER_SIZE + size);
+    if (block == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate an arena block of %lu bytes\n", (unsigned long)size);
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+
+    if (arena->current != NULL)
+        arena->current->next = block;
+    else
+        arena->first = block;
+    arena->blocks++;
+    return block;
+}
+
+void arena_init(Arena* arena, size_t block_size)
+{
+    arena->first        = NULL;
+    arena->current      = NULL;
+    arena->used         = 0;
+    arena->block_size   = (block_size > 0) ? block_size : DEFAULT_ARENA_BLOCK_SIZE;
+    arena->bytes_used   = 0;
+    arena->allocations  = 0;
+    arena->blocks       = 0;
+}
+
+void* arena_alloc(Arena* arena, size_t size)
+{
+    void* memory;
+
+    size = ARENA_ALIGN(size > 0 ? size : 1);
+    if (arena->current == NULL || arena->used + size > arena->current->size)
+    {
+        /* reuse the blocks kept by a reset before allocating a new one */
+        while (arena->current != NULL && arena->current->next != NULL)
+        {
+            arena->current  = arena->current->next;
+            arena->used     = 0;
+            if (size <= arena->current->size)
+                break;
+        }
+        if (arena->current == NULL || arena->used + size > arena->current->size)
+        {
+            ArenaBlock* block = arena_add_block(arena, size);
+            if (block == NULL)
+                return NULL;
+            arena->current  = block;
+            arena->used     = 0;
+        }
+    }
+
+    memory = ARENA_BLOCK_DATA(arena->current) + arena->used;
+    arena->used         += size;
+    arena->bytes_used   += size;
+    arena->allocations++;
+    return memory;
+}
+
+void* arena_calloc(Arena* arena, size_t count, size_t element_size)
+{
+    void* memory = arena_alloc(arena, count * element_size);
+    if (memory != NULL)
+        memset(memory, 0, count * element_size);
+    return memory;
+}
+
+char* arena_strdup(Arena* arena, const char* str)
+{
+    if (str == NULL)
+        return NULL;
+    return arena_strndup(arena, str, strlen(str));
+}
+
+char* arena_strndup(Arena* arena, const char* str, size_t length)
+{
+    char* copy = arena_alloc(arena, length + 1);
+    if (copy == NULL)
+        return NULL;
+    memcpy(copy, str, length);
+    copy[length] = NULL_TERMINATOR;
+    return copy;
+}
+
+void arena_reset(Arena* arena)
+{
+    arena->current      = arena->first;
+    arena->used         = 0;
+    arena->bytes_used   = 0;
+    arena->allocations  = 0;
+}
+
+void arena_destroy(Arena* arena)
+{
+    ArenaBlock* block = arena->first;
+
+    while (block != NULL)
+    {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena_init(arena, arena->block_size);
+}
@@ -0,0 +1,90 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/** @brief Default size of an arena block. */
+#define DEFAULT_ARENA_BLOCK_SIZE 16384
+
+/**
+ * @brief A block of arena memory, the allocations follow the header.
+ */
+typedef struct ArenaBlock
+{
+    struct ArenaBlock* next;    /* Next block, the blocks are kept for reuse after a reset. */
+    size_t size;                /* Number of bytes that follow the header. */
+} ArenaBlock;
+
+/**
+ * @brief A bump allocator for objects that live as long as one assembly job.
+ *
+ * Allocating advances a pointer in the current block, and a new block is only
+ * allocated when the current one is full. Objects are never freed one by one:
+ * arena_reset releases all of them at once in O(1), keeping the blocks for the
+ * next job, and arena_destroy returns the blocks to the heap.
+ */
+typedef struct Arena
+{
+    ArenaBlock* first;      /* First block, allocations restart from it after a reset. */
+    ArenaBlock* current;    /* Block allocations are currently made from. */
+    size_t used;            /* Bytes used in the current block. */
+    size_t block_size;      /* Size of a new block, larger allocations get a block of their own. */
+    size_t bytes_used;      /* Bytes handed out since the last reset, including alignment. */
+    size_t allocations;     /* Allocations since the last reset. */
+    size_t blocks;          /* Blocks owned by the arena, each one is a single malloc. */
+} Arena;
+
+/**
+ * @brief Initializes an empty Arena, no memory is allocated until the first allocation.
+ * @param arena         Pointer to the Arena.
+ * @param block_size    Size of a block (DEFAULT_ARENA_BLOCK_SIZE if 0).
+ */
+void arena_init(Arena* arena, size_t block_size);
+
+/**
+ * @brief Allocates memory from an Arena, aligned for any type.
+ * @param arena Pointer to the Arena.
+ * @param size  Number of bytes to allocate.
+ * @return The memory, or NULL if a new block could not be allocated.
+ */
+void* arena_alloc(Arena* arena, size_t size);
+
+/**
+ * @brief Allocates zeroed memory from an Arena, like calloc.
+ * @param arena         Pointer to the Arena.
+ * @param count         Number of elements.
+ * @param element_size  Size of an element.
+ * @return The memory, or NULL if a new block could not be allocated.
+ */
+void* arena_calloc(Arena* arena, size_t count, size_t element_size);
+
+/**
+ * @brief Copies a string into an Arena.
+ * @param arena Pointer to the Arena.
+ * @param str   The string to copy, may be NULL.
+ * @return The copy, or NULL if @p str is NULL or the allocation failed.
+ */
+char* arena_strdup(Arena* arena, const char* str);
+
+/**
+ * @brief Copies @p length characters into a null terminated string in an Arena.
+ * @param arena     Pointer to the Arena.
+ * @param str       The characters to copy, don't need to be null terminated.
+ * @param length    Number of characters to copy.
+ * @return The copy, or NULL if the allocation failed.
+ */
+char* arena_strndup(Arena* arena, const char* str, size_t length);
+
+/**
+ * @brief Releases every allocation of an Arena at once, keeping its blocks for reuse.
+ * @param arena Pointer to the Arena.
+ */
+void arena_reset(Arena* arena);
+
+/**
+ * @brief Frees every block of an Arena.
+ * @param arena Pointer to the Arena.
+ */
+void arena_destroy(Arena* arena);
+
+#endif /* ARENA_H */
@@ -0,0 +1,500 @@
+#define _POSIX_C_SOURCE 200809L /* st_mtim */
+#include "asm_cache.h"
+#include "common.h"
+#include "logger.h"
+#include "output_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <utime.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* Size of the buffer files are copied through */
+#define COPY_BUFFER_SIZE 65536
+/* Characters of a path in the cache directory past the directory itself */
+#define ENTRY_PATH_EXTRA (ASM_CACHE_KEY_LENGTH + 64)
+
+/* FNV-1a, 64 bits wide where an unsigned long is */
+#if ULONG_MAX > 0xFFFFFFFFUL
+#define HASH_OFFSET_BASIS   0xcbf29ce484222325UL
+#define HASH_PRIME          0x100000001b3UL
+#else
+#define HASH_OFFSET_BASIS   0x811c9dc5UL
+#define HASH_PRIME          0x01000193UL
+#endif
+
+/* Percentage of the size limit an eviction brings the cache down to, so a full cache doesn't evict on every store */
+#define CACHE_LOW_WATER_PERCENT 90
+/* Seconds after which a file of an unfinished store is taken as abandoned, a younger one may be a store in progress */
+#define STRAY_FILE_AGE 60
+/* Suffix of the files a store writes before renaming them */
+#define TEMPORARY_SUFFIX ".tmp"
+
+/* An entry of the cache */
+typedef struct CacheEntry
+{
+    char            key[ASM_CACHE_KEY_LENGTH + 1];
+    struct timespec used;           /* the .ob mtime, touched by every hit, read when entries are evicted */
+    unsigned long   size;           /* bytes of the files of the entry */
+} CacheEntry;
+
+struct AsmCache
+{
+    char*           directory;
+    unsigned long   size_limit;     /* 0 for no limit */
+    pthread_mutex_t lock;           /* guards the fields below */
+    CacheEntry*     entries;        /* the entries found when the cache was opened and the ones stored since */
+    size_t          entry_count;
+    size_t          entry_capacity;
+    unsigned long   size;           /* bytes of the entries, and of the files of unfinished stores */
+    unsigned long   temporary;      /* numbers the temporary files of the stores */
+    AsmCacheStats   stats;
+};
+
+/* The path of a file of an entry, 'path' holds the directory and ENTRY_PATH_EXTRA characters */
+static void entry_path(const AsmCache* cache, const char* key, OutputFileKind kind, char* path)
+{
+    sprintf(path, "%s/%s%s", cache->directory, key, output_file_extensions[kind]);
+}
+
+/* Copies a file, returns the number of bytes copied or -1 if 'from' couldn't be read or 'to' written */
+static long copy_file(const char* from, const char* to)
+{
+    char buffer[COPY_BUFFER_SIZE];
+    FILE* in = fopen(from, "rb");
+    FILE* out;
+    long total = 0;
+    size_t count;
+
+    if (in == NULL)
+        return -1;
+    if ((out = fopen(to, "wb")) == NULL)
+    {
+        fclose(in);
+        return -1;
+    }
+    while ((count = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    {
+        if (fwrite(buffer, 1, count, out) != count)
+        {
+            total = -1;
+            break;
+        }
+        total += (long)count;
+    }
+    if (ferror(in))
+        total = -1;
+    fclose(in);
+    if (fclose(out) != 0)
+        total = -1;
+    return total;
+}
+
+static int file_exists(const char* path)
+{
+    struct stat info;
+    return stat(path, &info) == 0;
+}
+
+/* The size of a file, 0 when it doesn't exist */
+static unsigned long file_size(const char* path)
+{
+    struct stat info;
+    return (stat(path, &info) == 0) ? (unsigned long)info.st_size : 0;
+}
+
+/* Adds an entry, or replaces the size of an entry stored again, called with the lock held */
+static void add_entry(AsmCache* cache, const char* key, unsigned long size, const struct timespec* used)
+{
+    size_t i;
+
+    for (i = 0; i < cache->entry_count; i++)
+    {
+        if (strcmp(cache->entries[i].key, key) == 0)
+        {
+            cache->size = cache->size - cache->entries[i].size + size;
+            cache->entries[i].size = size;
+            cache->entries[i].used = *used;
+            return;
+        }
+    }
+    if (cache->entry_count == cache->entry_capacity)
+    {
+        size_t capacity = (cache->entry_capacity == 0) ? 64 : 2 * cache->entry_capacity;
+        CacheEntry* grown = realloc(cache->entries, capacity * sizeof(CacheEntry));
+        if (grown == NULL)
+        {
+            /* an entry that isn't listed is never evicted, but it's still restored */
+            log_error(__FILE__,__LINE__,"Failed to grow the build cache entries.\n");
+            return;
+        }
+        cache->entries = grown;
+        cache->entry_capacity = capacity;
+    }
+    strcpy(cache->entries[cache->entry_count].key, key);
+    cache->entries[cache->entry_count].size = size;
+    cache->entries[cache->entry_count].used = *used;
+    cache->entry_count++;
+    cache->size += size;
+}
+
+/* Whether a file name starts with a key and an extension, as the files a store writes, other files are left alone */
+static int is_cache_file(const char* name)
+{
+    int i;
+
+    if (strlen(name) <= ASM_CACHE_KEY_LENGTH || name[ASM_CACHE_KEY_LENGTH] != '.')
+        return 0;
+    for (i = 0; i < ASM_CACHE_KEY_LENGTH; i++)
+    {
+        /* "%016lx-%016lx", see asm_cache_key */
+        int valid = (i == ASM_CACHE_KEY_LENGTH / 2) ? name[i] == DASH : strchr("0123456789abcdef", name[i]) != NULL;
+        if (!valid)
+            return 0;
+    }
+    return 1;
+}
+
+/* Whether a file name is the .ob file of an entry, the name of the entry's key */
+static int is_entry_name(const char* name)
+{
+    return is_cache_file(name) && strcmp(name + ASM_CACHE_KEY_LENGTH, output_file_extensions[OUTPUT_FILE_OB]) == 0;
+}
+
+/*
+ * Lists the entries of the directory, the key of an entry is the name of its .ob file.
+ * The other files are the .ent, .ext and .am files of an entry, or were left by a store
+ * that didn't finish: a temporary file, or files of an entry whose .ob was never written.
+ * Those are removed once they are old enough not to belong to a store in progress, and
+ * counted in the size until then.
+ */
+static void scan_entries(AsmCache* cache)
+{
+    char* path = malloc(strlen(cache->directory) + FILENAME_MAX + 2);
+    time_t now = time(NULL);
+    struct dirent* file;
+    DIR* directory;
+    int pass;
+
+    if (path == NULL)
+        return;
+    for (pass = 0; pass < 2; pass++)
+    {
+        if ((directory = opendir(cache->directory)) == NULL)
+            break;
+        while ((file = readdir(directory)) != NULL)
+        {
+            const char* name = file->d_name;
+            struct stat info;
+
+            if (!is_cache_file(name) || (pass == 0) != is_entry_name(name))
+                continue;
+            sprintf(path, "%s/%s", cache->directory, name);
+            if (stat(path, &info) != 0 || !S_ISREG(info.st_mode))
+                continue;
+
+            if (pass == 0)
+            {
+                char key[ASM_CACHE_KEY_LENGTH + 1];
+                unsigned long size = 0;
+                int kind;
+
+                memcpy(key, name, ASM_CACHE_KEY_LENGTH);
+                key[ASM_CACHE_KEY_LENGTH] = NULL_TERMINATOR;
+                for (kind = 0; kind < OUTPUT_FILE_COUNT; kind++)
+                {
+                    entry_path(cache, key, (OutputFileKind)kind, path);
+                    size += file_size(path);
+                }
+                add_entry(cache, key, size, &info.st_mtim);
+                continue;
+            }
+
+            /* a file of an entry listed by the first pass is counted already */
+            if (strstr(name, TEMPORARY_SUFFIX) == NULL)
+            {
+                char key[ASM_CACHE_KEY_LENGTH + 1];
+                memcpy(key, name, ASM_CACHE_KEY_LENGTH);
+                key[ASM_CACHE_KEY_LENGTH] = NULL_TERMINATOR;
+                entry_path(cache, key, OUTPUT_FILE_OB, path);
+                if (file_exists(path))
+                    continue;
+                sprintf(path, "%s/%s", cache->directory, name);
+            }
+            if (now - info.st_mtime >= STRAY_FILE_AGE && remove(path) == 0)
+                continue;
+            cache->size += (unsigned long)info.st_size;
+        }
+        closedir(directory);
+    }
+    free(path);
+}
+
+static int compare_entry_use(const void* a, const void* b)
+{
+    const struct timespec* first = &((const CacheEntry*)a)->used;
+    const struct timespec* second = &((const CacheEntry*)b)->used;
+    if (first->tv_sec != second->tv_sec)
+        return (first->tv_sec < second->tv_sec) ? -1 : 1;
+    return (first->tv_nsec < second->tv_nsec) ? -1 : (first->tv_nsec > second->tv_nsec);
+}
+
+/*
+ * Removes the least recently used entries until the cache is down to its low-water
+ * mark, called with the lock held. The hits since the entries were listed only
+ * touched the .ob files, so their times are read again first.
+ */
+static void evict_entries(AsmCache* cache)
+{
+    unsigned long low_water = cache->size_limit / 100 * CACHE_LOW_WATER_PERCENT;
+    char* path = malloc(strlen(cache->directory) + ENTRY_PATH_EXTRA);
+    size_t i, kept = 0, evicted;
+    int kind;
+
+    if (path == NULL)
+        return;
+    for (i = 0; i < cache->entry_count; i++)
+    {
+        struct stat info;
+        entry_path(cache, cache->entries[i].key, OUTPUT_FILE_OB, path);
+        if (stat(path, &info) != 0)
+        {
+            /* another process evicted the entry */
+            cache->size -= cache->entries[i].size;
+            continue;
+        }
+        cache->entries[i].used = info.st_mtim;
+        cache->entries[kept++] = cache->entries[i];
+    }
+    cache->entry_count = kept;
+
+    qsort(cache->entries, cache->entry_count, sizeof(CacheEntry), compare_entry_use);
+    for (evicted = 0; evicted < cache->entry_count && cache->size > low_water; evicted++)
+    {
+        /* the .ob file goes first, without it the entry is a miss */
+        for (kind = 0; kind < OUTPUT_FILE_COUNT; kind++)
+        {
+            entry_path(cache, cache->entries[evicted].key, (OutputFileKind)kind, path);
+            remove(path);
+        }
+        cache->size -= cache->entries[evicted].size;
+        cache->stats.evictions++;
+    }
+    memmove(cache->entries, cache->entries + evicted, (cache->entry_count - evicted) * sizeof(CacheEntry));
+    cache->entry_count -= evicted;
+    free(path);
+}
+
+AsmCache* asm_cache_open(const char* directory, unsigned long size_limit)
+{
+    AsmCache* cache;
+
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST)
+    {
+        log_error(__FILE__,__LINE__,"Failed to create the cache directory [%s]\n", directory);
+        return NULL;
+    }
+    cache = malloc(sizeof(AsmCache));
+    if (cache == NULL || (cache->directory = malloc(strlen(directory) + 1)) == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate a build cache.\n");
+        free(cache);
+        return NULL;
+    }
+    strcpy(cache->directory, directory);
+    cache->size_limit = size_limit;
+    cache->entries = NULL;
+    cache->entry_count = 0;
+    cache->entry_capacity = 0;
+    cache->size = 0;
+    cache->temporary = 0;
+    cache->stats.hits = 0;
+    cache->stats.misses = 0;
+    cache->stats.stores = 0;
+    cache->stats.evictions = 0;
+    pthread_mutex_init(&cache->lock, NULL);
+
+    scan_entries(cache);
+    if (cache->size_limit > 0 && cache->size > cache->size_limit)
+        evict_entries(cache);
+    return cache;
+}
+
+void asm_cache_close(AsmCache* cache)
+{
+    if (cache == NULL)
+        return;
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->entries);
+    free(cache->directory);
+    free(cache);
+}
+
+void asm_cache_key(char* key, const char* source, size_t length, int emit_am)
+{
+    const unsigned char* bytes = (const unsigned char*)source;
+    const char* version = ASSEMBLER_VERSION;
+    unsigned long hash = HASH_OFFSET_BASIS;
+    size_t i;
+
+    /* the version and the options come first, so they change the key of every source */
+    for (; *version != NULL_TERMINATOR; version++)
+        hash = (hash ^ (unsigned char)*version) * HASH_PRIME;
+    hash = (hash ^ (emit_am ? 1UL : 0UL)) * HASH_PRIME;
+    for (i = 0; i < length; i++)
+        hash = (hash ^ bytes[i]) * HASH_PRIME;
+    sprintf(key, "%016lx-%016lx", hash, (unsigned long)length);
+}
+
+/* Whether an entry holds a copy of the output file */
+static int cached_kind(OutputFileKind kind, int emit_am)
+{
+    return kind != OUTPUT_FILE_AM || emit_am;
+}
+
+int asm_cache_restore(AsmCache* cache, const char* key, const char* output_base, int emit_am)
+{
+    char* path = malloc(strlen(cache->directory) + ENTRY_PATH_EXTRA);
+    char* output = malloc(strlen(output_base) + ENTRY_PATH_EXTRA);
+    int flag = INVALID_RETURN;
+    int kind;
+
+    if (path == NULL || output == NULL)
+    {
+        free(path);
+        free(output);
+        return INVALID_RETURN;
+    }
+
+    entry_path(cache, key, OUTPUT_FILE_OB, path);
+    if (file_exists(path))
+    {
+        flag = VALID_RETURN;
+        for (kind = 0; kind < OUTPUT_FILE_COUNT && flag == VALID_RETURN; kind++)
+        {
+            if (!cached_kind((OutputFileKind)kind, emit_am))
+                continue;
+            entry_path(cache, key, (OutputFileKind)kind, path);
+            sprintf(output, "%s%s", output_base, output_file_extensions[kind]);
+            if (file_exists(path))
+                flag = (copy_file(path, output) < 0) ? INVALID_RETURN : VALID_RETURN;
+            else
+                remove(output);
+        }
+        /* an entry evicted while it was copied may have lost files, the source is assembled instead */
+        entry_path(cache, key, OUTPUT_FILE_OB, path);
+        if (flag == VALID_RETURN && utime(path, NULL) != 0)
+            flag = INVALID_RETURN;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    if (flag == VALID_RETURN)
+        cache->stats.hits++;
+    else
+        cache->stats.misses++;
+    pthread_mutex_unlock(&cache->lock);
+    free(path);
+    free(output);
+    return flag;
+}
+
+void asm_cache_store(AsmCache* cache, const char* key, const char* output_base, int emit_am)
+{
+    /* the .ob file marks a complete entry, so it's stored last */
+    static const OutputFileKind order[OUTPUT_FILE_COUNT] = { OUTPUT_FILE_ENT, OUTPUT_FILE_EXT, OUTPUT_FILE_AM, OUTPUT_FILE_OB };
+    char* path = malloc(strlen(cache->directory) + ENTRY_PATH_EXTRA);
+    char* temporary = malloc(strlen(cache->directory) + 2 * ENTRY_PATH_EXTRA);
+    char* output = malloc(strlen(output_base) + ENTRY_PATH_EXTRA);
+    unsigned long size = 0, number;
+    int i;
+
+    if (path == NULL || temporary == NULL || output == NULL)
+    {
+        free(path);
+        free(temporary);
+        free(output);
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    number = cache->temporary++;
+    pthread_mutex_unlock(&cache->lock);
+
+    for (i = 0; i < OUTPUT_FILE_COUNT; i++)
+    {
+        OutputFileKind kind = order[i];
+        long copied;
+
+        if (!cached_kind(kind, emit_am))
+            continue;
+        entry_path(cache, key, kind, path);
+        sprintf(output, "%s%s", output_base, output_file_extensions[kind]);
+        if (!file_exists(output))
+        {
+            remove(path);
+            continue;
+        }
+        /* copied aside and renamed, another process never restores half a file */
+        sprintf(temporary, "%s.%ld.%lu" TEMPORARY_SUFFIX, path, (long)getpid(), number);
+        copied = copy_file(output, temporary);
+        if (copied < 0 || rename(temporary, path) != 0)
+        {
+            log_error(__FILE__,__LINE__,"Failed to store [%s] in the build cache\n", output);
+            remove(temporary);
+            /* the files stored already would never be restored without the .ob file */
+            while (i-- > 0)
+            {
+                entry_path(cache, key, order[i], path);
+                remove(path);
+            }
+            break;
+        }
+        size += (unsigned long)copied;
+    }
+
+    if (i == OUTPUT_FILE_COUNT)
+    {
+        struct timespec now;
+        struct stat info;
+
+        entry_path(cache, key, OUTPUT_FILE_OB, path);
+        if (stat(path, &info) == 0)
+        {
+            now = info.st_mtim;
+        }
+        else
+        {
+            now.tv_sec = time(NULL);
+            now.tv_nsec = 0;
+        }
+        pthread_mutex_lock(&cache->lock);
+        cache->stats.stores++;
+        add_entry(cache, key, size, &now);
+        if (cache->size_limit > 0 && cache->size > cache->size_limit)
+            evict_entries(cache);
+        pthread_mutex_unlock(&cache->lock);
+    }
+    free(path);
+    free(temporary);
+    free(output);
+}
+
+void asm_cache_stats(AsmCache* cache, AsmCacheStats* stats)
+{
+    pthread_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+const char* asm_cache_directory(const AsmCache* cache)
+{
+    return cache->directory;
+}
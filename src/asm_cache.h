@@ -0,0 +1,95 @@
+#ifndef ASM_CACHE_H
+#define ASM_CACHE_H
+
+#include <stddef.h>
+
+/** @brief Default size limit of a build cache, in bytes. */
+#define DEFAULT_CACHE_SIZE_LIMIT (64UL * 1024 * 1024)
+
+/** @brief Number of characters of a cache key, not including the null terminator. */
+#define ASM_CACHE_KEY_LENGTH 33
+
+/**
+ * @brief A directory of output files, keyed by a hash of the source they were assembled from.
+ *
+ * An entry holds the .ob, .ent and .ext files (and the .am file with --emit-am) of
+ * a source that was assembled without errors. The key is a hash of the source
+ * bytes and ASSEMBLER_VERSION, so a source assembled again by the same version is
+ * restored from the entry instead. Entries are evicted least recently used first
+ * once the cache grows past its size limit. A cache is shared by the jobs of a run,
+ * and several runs may use the same directory.
+ */
+typedef struct AsmCache AsmCache;
+
+/**
+ * @brief Counters of a cache, since it was opened.
+ */
+typedef struct AsmCacheStats
+{
+    unsigned long hits;         /* sources restored from an entry */
+    unsigned long misses;       /* sources that had no entry */
+    unsigned long stores;       /* entries added */
+    unsigned long evictions;    /* entries removed for the size limit */
+} AsmCacheStats;
+
+/**
+ * @brief Opens a cache directory, creating it if needed.
+ * @param directory     The cache directory.
+ * @param size_limit    The size of the entries the cache keeps, in bytes, 0 for no limit.
+ * @return The cache, or NULL if the directory couldn't be created.
+ */
+AsmCache* asm_cache_open(const char* directory, unsigned long size_limit);
+
+/**
+ * @brief Closes a cache, the entries stay in the directory.
+ * @param cache The cache, may be NULL.
+ */
+void asm_cache_close(AsmCache* cache);
+
+/**
+ * @brief Computes the key of a source.
+ * @param key       Receives ASM_CACHE_KEY_LENGTH characters and a null terminator.
+ * @param source    The source bytes.
+ * @param length    Number of bytes in the source.
+ * @param emit_am   Non-zero when the .am file is an output file as well.
+ */
+void asm_cache_key(char* key, const char* source, size_t length, int emit_am);
+
+/**
+ * @brief Restores the output files of a source from its entry.
+ *
+ * The output files the entry doesn't have are removed, as an assembly of the
+ * source would remove them.
+ *
+ * @param cache         The cache.
+ * @param key           The key of the source, see asm_cache_key.
+ * @param output_base   The output files without their extension, I.E: "build/output_files/ps".
+ * @param emit_am       Non-zero to restore the .am file as well, as in the key.
+ * @return VALID_RETURN on a hit, INVALID_RETURN if the source has to be assembled.
+ */
+int asm_cache_restore(AsmCache* cache, const char* key, const char* output_base, int emit_am);
+
+/**
+ * @brief Adds the output files of a source assembled without errors, evicting entries past the size limit.
+ * @param cache         The cache.
+ * @param key           The key of the source, see asm_cache_key.
+ * @param output_base   The output files without their extension, I.E: "build/output_files/ps".
+ * @param emit_am       Non-zero to store the .am file as well, as in the key.
+ */
+void asm_cache_store(AsmCache* cache, const char* key, const char* output_base, int emit_am);
+
+/**
+ * @brief Returns the counters of a cache.
+ * @param cache The cache.
+ * @param stats Receives the counters.
+ */
+void asm_cache_stats(AsmCache* cache, AsmCacheStats* stats);
+
+/**
+ * @brief Returns the directory of a cache.
+ * @param cache The cache.
+ * @return The directory, as given to asm_cache_open.
+ */
+const char* asm_cache_directory(const AsmCache* cache);
+
+#endif /* ASM_CACHE_H */
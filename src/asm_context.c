@@ -0,0 +1,238 @@
+#include "asm_context.h"
+#include "common.h"
+#include "logger.h"
+#include "pre_asm.h"
+#include "source_reader.h"
+#include "first_pass.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+AsmContext* asm_context_create(const AsmOptions* options, FILE* out, FILE* err)
+{
+    AsmContext* context = malloc(sizeof(AsmContext));
+    if(context == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate an assembly context.\n");
+        return NULL;
+    }
+
+    context->options.emit_am = 0;
+    context->options.single_pass = 0;
+    context->options.max_errors = 0;
+    if(options != NULL)
+        context->options = *options;
+
+    context->macro_table = macro_table_create(DEFAULT_MACRO_TABLE_SIZE);
+    if(context->macro_table == NULL)
+    {
+        free(context);
+        return NULL;
+    }
+    if(string_buffer_init(&context->expanded, DEFAULT_STRING_BUFFER_SIZE) == INVALID_RETURN)
+    {
+        macro_table_destroy(context->macro_table);
+        free(context);
+        return NULL;
+    }
+    arena_init(&context->arena, DEFAULT_ARENA_BLOCK_SIZE);
+
+    error_list_init(&context->errors);
+    asm_context_set_options(context, &context->options);
+    asm_context_set_streams(context, out, err);
+    context->job.errors = &context->errors;
+    context->job.sink = NULL;
+    context->cache = NULL;
+    context->copy_sources = 0;
+    return context;
+}
+
+void asm_context_set_options(AsmContext* context, const AsmOptions* options)
+{
+    context->options = *options;
+    context->errors.limit = (options->max_errors > 0) ? options->max_errors : 0;
+}
+
+void asm_context_set_streams(AsmContext* context, FILE* out, FILE* err)
+{
+    context->job.out = out;
+    context->job.err = err;
+}
+
+void asm_context_set_cache(AsmContext* context, AsmCache* cache)
+{
+    context->cache = cache;
+}
+
+void asm_context_copy_sources(AsmContext* context, int copy)
+{
+    context->copy_sources = copy;
+}
+
+/* The output files of 'name' without their extension, I.E: "build/output_files/ps" */
+static void output_base_name(const char* name, char* output_base)
+{
+    const char* base = strrchr(name, '/');
+    sprintf(output_base, "%s%s", OUTPUT_PATH, (base != NULL) ? base + 1 : name);
+}
+
+/* Assembles a single input file from macro expansion through the second pass, 'data' is NULL to read the file */
+static int assemble_file(AsmContext* context, const char* name, const char* data, size_t length)
+{
+    SourceReader source;
+    char current_file[MAX_FILENAME];
+    char output_file[MAX_FILENAME];
+    char output_base[MAX_FILENAME + sizeof(OUTPUT_PATH)];
+    char cache_key[ASM_CACHE_KEY_LENGTH + 1];
+    AsmCache* cache = (context->job.sink == NULL) ? context->cache : NULL;
+    int flag;
+
+    if(strlen(name) + strlen(".as") >= MAX_FILENAME)
+    {
+        log_error(__FILE__,__LINE__,"The file name %s is too long.\n", name);
+        return INVALID_RETURN;
+    }
+    strcpy(current_file,name);
+    strcat(current_file, ".as");
+    log_out(__FILE__, __LINE__,"opening filename: %s\n",current_file);
+    if(data != NULL)
+    {
+        source_reader_open_buffer(&source,data,length);
+    }
+    else if((context->copy_sources ? source_reader_open_copy(&source,current_file) :
+        source_reader_open(&source,current_file)) == INVALID_RETURN)
+    {
+        log_error(__FILE__,__LINE__,"Failed to open %s, file doesn't exists.\n", current_file);
+        return INVALID_RETURN;
+    }
+
+    if(cache != NULL)
+    {
+        output_base_name(name, output_base);
+        asm_cache_key(cache_key, source.data, source.length, context->options.emit_am);
+        if(asm_cache_restore(cache, cache_key, output_base, context->options.emit_am) == VALID_RETURN)
+        {
+            log_out(__FILE__,__LINE__,"Restored the output files of %s from the build cache\n", current_file);
+            source_reader_close(&source);
+            return VALID_RETURN;
+        }
+    }
+
+    if(parse_macros(&source, current_file,output_file,context->macro_table,&context->expanded) == INVALID_RETURN)
+    {
+        /* Found error in Pre-Asm -> no .am file is written */
+        log_out(__FILE__,__LINE__,"Error Parsing Macros for - %s\n", output_file);
+        source_reader_close(&source);
+        return INVALID_RETURN;
+    }
+
+    log_out(__FILE__,__LINE__,"Done Parsing Macros for - %s\n", current_file);
+    source_reader_close(&source);
+    if(context->options.emit_am)
+        write_am_file(output_file,&context->expanded);
+    /* 
+        preprares first pass and executes it over the expanded source in memory, 
+        and continues to the 2nd pass     
+    */
+    flag = prepare_first_pass(output_file,context->macro_table,&context->expanded,&context->arena,
+        context->options.single_pass);
+    if(cache != NULL && flag == VALID_RETURN)
+        asm_cache_store(cache, cache_key, output_base, context->options.emit_am);
+    return flag;
+}
+
+/* Assembles a file with the context bound to the calling thread */
+static int assemble_bound(AsmContext* context, const char* name, const char* data, size_t length)
+{
+    JobContext* previous = job_context_current();
+    int flag;
+
+    job_context_bind(&context->job);
+    reset_error_limit();
+    flag = assemble_file(context, name, data, length);
+
+    /* the macros, labels and binary nodes of a file never carry over to the next one */
+    macro_table_reset(&context->macro_table);
+    arena_reset(&context->arena);
+    job_context_bind(previous);
+    return flag;
+}
+
+int asm_context_assemble(AsmContext* context, const char* name)
+{
+    return assemble_bound(context, name, NULL, 0);
+}
+
+/* The output sink of an in-memory assembly: every output file is collected in a StringBuffer */
+static int memory_sink_write(void* arg, OutputFileKind kind, const char* data, size_t length)
+{
+    StringBuffer* file = &((StringBuffer*)arg)[kind];
+
+    if(file->data == NULL && string_buffer_init(file, length + 1) == INVALID_RETURN)
+        return INVALID_RETURN;
+    return string_buffer_append(file, data, length);
+}
+
+static void memory_sink_discard(void* arg, OutputFileKind kind)
+{
+    string_buffer_free(&((StringBuffer*)arg)[kind]);
+}
+
+int asm_context_assemble_buffer(AsmContext* context, const char* name, const char* source, size_t length,
+    AsmOutput* output)
+{
+    StringBuffer files[OUTPUT_FILE_COUNT];
+    OutputSink sink;
+    int kind;
+    int flag;
+
+    if(output == NULL)
+        return assemble_bound(context, name, source, length);
+
+    for(kind = 0; kind < OUTPUT_FILE_COUNT; kind++)
+    {
+        files[kind].data = NULL;
+        files[kind].length = 0;
+        files[kind].capacity = 0;
+    }
+    sink.write = memory_sink_write;
+    sink.discard = memory_sink_discard;
+    sink.arg = files;
+
+    context->job.sink = &sink;
+    flag = assemble_bound(context, name, source, length);
+    context->job.sink = NULL;
+
+    /* the buffers go to the caller as they are */
+    for(kind = 0; kind < OUTPUT_FILE_COUNT; kind++)
+    {
+        if(files[kind].length == 0)
+            string_buffer_free(&files[kind]);
+        output->files[kind].data = files[kind].data;
+        output->files[kind].length = files[kind].length;
+    }
+    return flag;
+}
+
+void asm_output_free(AsmOutput* output)
+{
+    int kind;
+
+    for(kind = 0; kind < OUTPUT_FILE_COUNT; kind++)
+    {
+        free(output->files[kind].data);
+        output->files[kind].data = NULL;
+        output->files[kind].length = 0;
+    }
+}
+
+void asm_context_destroy(AsmContext* context)
+{
+    if(context == NULL)
+        return;
+    arena_destroy(&context->arena);
+    string_buffer_free(&context->expanded);
+    macro_table_destroy(context->macro_table);
+    error_list_destroy(&context->errors);
+    free(context);
+}
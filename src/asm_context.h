@@ -0,0 +1,155 @@
+#ifndef ASM_CONTEXT_H
+#define ASM_CONTEXT_H
+
+#include <stdio.h>
+#include "macro_table.h"
+#include "string_buffer.h"
+#include "arena.h"
+#include "error_manager.h"
+#include "job_context.h"
+#include "output_writer.h"
+#include "asm_cache.h"
+
+/**
+ * @brief Options of an assembly, they apply to every file assembled by a context.
+ */
+typedef struct AsmOptions
+{
+    int emit_am;        /* write the .am file as well */
+    int single_pass;    /* backpatch the labels in the first pass, see single_pass.h */
+    int max_errors;     /* errors recorded for a file before it's no longer read, 0 for no limit */
+} AsmOptions;
+
+/**
+ * @brief An output file assembled in memory.
+ */
+typedef struct AsmBuffer
+{
+    char*   data;       /* the contents, null terminated, NULL when the file has no records */
+    size_t  length;     /* number of characters, not including the null terminator */
+} AsmBuffer;
+
+/**
+ * @brief The output files of a source assembled in memory, owned by the caller.
+ *
+ * A file is present exactly when a run of the assembler executable leaves it in
+ * build/output_files/, the .am file only with the emit_am option.
+ */
+typedef struct AsmOutput
+{
+    AsmBuffer files[OUTPUT_FILE_COUNT];     /* indexed by OutputFileKind */
+} AsmOutput;
+
+/**
+ * @brief Everything an assembly changes while it runs.
+ *
+ * A context owns the macro table, the expanded source buffer, the arena of the
+ * labels and binary nodes, the error list and the output streams, and keeps them
+ * between the files it assembles. The ISA and keyword tables are constant and
+ * shared. Contexts don't share anything else, so one process can assemble on many
+ * threads at once, one context per thread. A context must not be used by two
+ * threads at the same time.
+ *
+ * This is the interface of libasm.a, the assembler executable is a front end over it.
+ */
+typedef struct AsmContext
+{
+    AsmOptions      options;
+    MacroTable*     macro_table;
+    StringBuffer    expanded;   /* the expanded source of the current file */
+    Arena           arena;      /* the labels and binary nodes of the current file */
+    ErrorList       errors;
+    JobContext      job;        /* bound to the calling thread while a file is assembled */
+    AsmCache*       cache;      /* the build cache of the files written to build/output_files/, NULL for none */
+    int             copy_sources;   /* read the source files into memory instead of mapping them */
+} AsmContext;
+
+/**
+ * @brief Creates an assembly context.
+ * @param options   The options of the assembly, NULL for the defaults (all off, no error limit).
+ * @param out       Stream for the informational output, NULL for stdout.
+ * @param err       Stream for the diagnostics, NULL for stderr.
+ * @return The new context, or NULL if it couldn't be allocated.
+ */
+AsmContext* asm_context_create(const AsmOptions* options, FILE* out, FILE* err);
+
+/**
+ * @brief Changes the options of the next files a context assembles, its tables and buffers are kept.
+ * @param context   The context.
+ * @param options   The new options.
+ */
+void asm_context_set_options(AsmContext* context, const AsmOptions* options);
+
+/**
+ * @brief Changes the streams the next files a context assembles report to.
+ * @param context   The context.
+ * @param out       Stream for the informational output, NULL for stdout.
+ * @param err       Stream for the diagnostics, NULL for stderr.
+ */
+void asm_context_set_streams(AsmContext* context, FILE* out, FILE* err);
+
+/**
+ * @brief Makes a context restore the output files of unchanged sources from a build cache.
+ *
+ * A source whose key is in the cache isn't assembled, its output files are copied
+ * from the cache. A source assembled without errors is added to it. Only the files
+ * written to build/output_files/ are cached, an assembly into an AsmOutput isn't.
+ *
+ * @param context   The context.
+ * @param cache     The cache, shared with other contexts and owned by the caller, NULL for none.
+ */
+void asm_context_set_cache(AsmContext* context, AsmCache* cache);
+
+/**
+ * @brief Makes a context read its source files into memory instead of mapping them.
+ *
+ * A mapped source that is truncated or rewritten while it's assembled raises SIGBUS
+ * and ends the process. A long-lived process assembling files that may change under
+ * it (the daemon, the watch) copies them instead, at the cost of a read.
+ *
+ * @param context   The context.
+ * @param copy      Non-zero to copy the sources, zero to map them (the default).
+ */
+void asm_context_copy_sources(AsmContext* context, int copy);
+
+/**
+ * @brief Assembles a single file from macro expansion through the output files.
+ *
+ * The output files are written to build/output_files/, as the assembler executable does.
+ *
+ * @param context   The context, used by the calling thread only.
+ * @param name      The input file, without the .as extension.
+ * @return VALID_RETURN if the file was assembled without errors, INVALID_RETURN otherwise.
+ */
+int asm_context_assemble(AsmContext* context, const char* name);
+
+/**
+ * @brief Assembles a source that is already in memory, the output files are returned instead of written.
+ *
+ * The source isn't read from a file, and with @p output no output file is written.
+ * The diagnostics name the source as if it were the file name.as.
+ *
+ * @param context   The context, used by the calling thread only.
+ * @param name      The name of the source in the diagnostics, without the .as extension.
+ * @param source    The source, it's not copied.
+ * @param length    Number of characters in the source.
+ * @param output    Receives the output files, free them with asm_output_free.
+ *                  NULL writes them to build/output_files/ as asm_context_assemble does.
+ * @return VALID_RETURN if the source was assembled without errors, INVALID_RETURN otherwise.
+ */
+int asm_context_assemble_buffer(AsmContext* context, const char* name, const char* source, size_t length,
+    AsmOutput* output);
+
+/**
+ * @brief Frees the output files returned by asm_context_assemble_buffer.
+ * @param output The output files.
+ */
+void asm_output_free(AsmOutput* output);
+
+/**
+ * @brief Frees a context and everything it owns, the streams given to it are left open.
+ * @param context The context, may be NULL.
+ */
+void asm_context_destroy(AsmContext* context);
+
+#endif /* ASM_CONTEXT_H */
@@ -0,0 +1,244 @@
+#define _POSIX_C_SOURCE 200809L /* MSG_NOSIGNAL */
+#include "asm_protocol.h"
+#include "common.h"
+#include "logger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* "ASM1 K emit_am single_pass max_errors name_length source_length\n", every number in 10 characters */
+#define REQUEST_HEADER_FORMAT   ASM_PROTOCOL_MAGIC " %c %010ld %010ld %010ld %010lu %010lu\n"
+#define REQUEST_HEADER_SIZE     (sizeof(ASM_PROTOCOL_MAGIC) - 1 + 2 + 5 * 11 + 1)
+/* "ASM1 result out_length err_length files_length\n", every number in 10 characters */
+#define RESPONSE_HEADER_FORMAT  ASM_PROTOCOL_MAGIC " %010ld %010lu %010lu %010lu\n"
+#define RESPONSE_HEADER_SIZE    (sizeof(ASM_PROTOCOL_MAGIC) - 1 + 4 * 11 + 1)
+/* Largest number a header field holds */
+#define MAX_HEADER_NUMBER 999999999L
+
+/* Writes all of 'data', a closed peer is an error instead of a SIGPIPE */
+static int send_all(int fd, const char* data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t count = send(fd, data, length, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return INVALID_RETURN;
+        data    += count;
+        length  -= count;
+    }
+    return VALID_RETURN;
+}
+
+/* Reads exactly 'length' characters */
+static int receive_all(int fd, char* data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t count = recv(fd, data, length, 0);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return INVALID_RETURN;
+        data    += count;
+        length  -= count;
+    }
+    return VALID_RETURN;
+}
+
+/* Reads a payload of 'length' characters into a new null terminated buffer, NULL for an empty one */
+static int receive_payload(int fd, char** data, unsigned long length)
+{
+    *data = NULL;
+    if (length == 0)
+        return VALID_RETURN;
+    if (length > ASM_PROTOCOL_MAX_PAYLOAD || (*data = malloc(length + 1)) == NULL)
+        return INVALID_RETURN;
+    if (receive_all(fd, *data, length) == INVALID_RETURN)
+    {
+        free(*data);
+        *data = NULL;
+        return INVALID_RETURN;
+    }
+    (*data)[length] = NULL_TERMINATOR;
+    return VALID_RETURN;
+}
+
+/* Clamps a number into a header field */
+static long header_number(long value)
+{
+    if (value > MAX_HEADER_NUMBER)
+        return MAX_HEADER_NUMBER;
+    return (value < -MAX_HEADER_NUMBER / 10) ? -MAX_HEADER_NUMBER / 10 : value;
+}
+
+int asm_protocol_connect(const char* socket_path)
+{
+    struct sockaddr_un address;
+    int fd;
+
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        log_error(__FILE__,__LINE__,"The socket path [%s] is too long.\n", socket_path);
+        return INVALID_RETURN;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return INVALID_RETURN;
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0)
+    {
+        close(fd);
+        return INVALID_RETURN;
+    }
+    return fd;
+}
+
+int asm_protocol_send_request(int fd, const AsmRequest* request)
+{
+    char header[REQUEST_HEADER_SIZE + 1];
+    size_t name_length = (request->name != NULL) ? strlen(request->name) : 0;
+    size_t source_length = (request->source != NULL) ? request->source_length : 0;
+
+    if (name_length > ASM_PROTOCOL_MAX_PAYLOAD || source_length > ASM_PROTOCOL_MAX_PAYLOAD)
+        return INVALID_RETURN;
+    sprintf(header, REQUEST_HEADER_FORMAT, (char)request->kind, header_number(request->options.emit_am),
+        header_number(request->options.single_pass), header_number(request->options.max_errors),
+        (unsigned long)name_length, (unsigned long)source_length);
+
+    if (send_all(fd, header, REQUEST_HEADER_SIZE) == INVALID_RETURN ||
+        send_all(fd, request->name, name_length) == INVALID_RETURN ||
+        send_all(fd, request->source, source_length) == INVALID_RETURN)
+        return INVALID_RETURN;
+    return VALID_RETURN;
+}
+
+int asm_protocol_receive_request(int fd, AsmRequest* request)
+{
+    char header[REQUEST_HEADER_SIZE + 1];
+    char kind;
+    long emit_am, single_pass, max_errors;
+    unsigned long name_length, source_length;
+
+    request->name   = NULL;
+    request->source = NULL;
+    request->source_length = 0;
+    if (receive_all(fd, header, REQUEST_HEADER_SIZE) == INVALID_RETURN)
+        return INVALID_RETURN;
+    header[REQUEST_HEADER_SIZE] = NULL_TERMINATOR;
+    if (strncmp(header, ASM_PROTOCOL_MAGIC, strlen(ASM_PROTOCOL_MAGIC)) != 0 ||
+        sscanf(header + strlen(ASM_PROTOCOL_MAGIC), " %c %ld %ld %ld %lu %lu", &kind, &emit_am, &single_pass,
+            &max_errors, &name_length, &source_length) != 6)
+    {
+        log_error(__FILE__,__LINE__,"Received a malformed request.\n");
+        return INVALID_RETURN;
+    }
+    if (kind != ASM_REQUEST_PATH && kind != ASM_REQUEST_SOURCE && kind != ASM_REQUEST_STOP)
+    {
+        log_error(__FILE__,__LINE__,"Received a request of an unknown kind [%c].\n", kind);
+        return INVALID_RETURN;
+    }
+
+    request->kind                   = (AsmRequestKind)kind;
+    request->options.emit_am        = (int)emit_am;
+    request->options.single_pass    = (int)single_pass;
+    request->options.max_errors     = (int)max_errors;
+    if (receive_payload(fd, &request->name, name_length) == INVALID_RETURN ||
+        receive_payload(fd, &request->source, source_length) == INVALID_RETURN)
+    {
+        asm_protocol_free_request(request);
+        return INVALID_RETURN;
+    }
+    request->source_length = source_length;
+    return VALID_RETURN;
+}
+
+void asm_protocol_free_request(AsmRequest* request)
+{
+    free(request->name);
+    free(request->source);
+    request->name   = NULL;
+    request->source = NULL;
+    request->source_length = 0;
+}
+
+int asm_protocol_send_response(int fd, const AsmResponse* response)
+{
+    char header[RESPONSE_HEADER_SIZE + 1];
+
+    if (response->out_length > ASM_PROTOCOL_MAX_PAYLOAD || response->err_length > ASM_PROTOCOL_MAX_PAYLOAD ||
+        response->files_length > ASM_PROTOCOL_MAX_PAYLOAD)
+        return INVALID_RETURN;
+    sprintf(header, RESPONSE_HEADER_FORMAT, header_number(response->result), (unsigned long)response->out_length,
+        (unsigned long)response->err_length, (unsigned long)response->files_length);
+
+    if (send_all(fd, header, RESPONSE_HEADER_SIZE) == INVALID_RETURN ||
+        send_all(fd, response->out, response->out_length) == INVALID_RETURN ||
+        send_all(fd, response->err, response->err_length) == INVALID_RETURN ||
+        send_all(fd, response->files, response->files_length) == INVALID_RETURN)
+        return INVALID_RETURN;
+    return VALID_RETURN;
+}
+
+int asm_protocol_receive_response(int fd, AsmResponse* response)
+{
+    char header[RESPONSE_HEADER_SIZE + 1];
+    long result;
+    unsigned long out_length, err_length, files_length;
+
+    response->out   = NULL;
+    response->err   = NULL;
+    response->files = NULL;
+    response->out_length = response->err_length = response->files_length = 0;
+    if (receive_all(fd, header, RESPONSE_HEADER_SIZE) == INVALID_RETURN)
+        return INVALID_RETURN;
+    header[RESPONSE_HEADER_SIZE] = NULL_TERMINATOR;
+    if (strncmp(header, ASM_PROTOCOL_MAGIC, strlen(ASM_PROTOCOL_MAGIC)) != 0 ||
+        sscanf(header + strlen(ASM_PROTOCOL_MAGIC), " %ld %lu %lu %lu", &result, &out_length, &err_length,
+            &files_length) != 4)
+    {
+        log_error(__FILE__,__LINE__,"Received a malformed response.\n");
+        return INVALID_RETURN;
+    }
+
+    response->result = (int)result;
+    if (receive_payload(fd, &response->out, out_length) == INVALID_RETURN ||
+        receive_payload(fd, &response->err, err_length) == INVALID_RETURN ||
+        receive_payload(fd, &response->files, files_length) == INVALID_RETURN)
+    {
+        asm_protocol_free_response(response);
+        return INVALID_RETURN;
+    }
+    response->out_length    = out_length;
+    response->err_length    = err_length;
+    response->files_length  = files_length;
+    return VALID_RETURN;
+}
+
+void asm_protocol_free_response(AsmResponse* response)
+{
+    free(response->out);
+    free(response->err);
+    free(response->files);
+    response->out   = NULL;
+    response->err   = NULL;
+    response->files = NULL;
+    response->out_length = response->err_length = response->files_length = 0;
+}
+
+int asm_protocol_call(int fd, const AsmRequest* request, AsmResponse* response)
+{
+    if (asm_protocol_send_request(fd, request) == INVALID_RETURN)
+        return INVALID_RETURN;
+    return asm_protocol_receive_response(fd, response);
+}
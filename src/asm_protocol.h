@@ -0,0 +1,112 @@
+#ifndef ASM_PROTOCOL_H
+#define ASM_PROTOCOL_H
+
+#include <stddef.h>
+#include "asm_context.h"
+
+/** @brief First characters of every message, changes whenever the messages do. */
+#define ASM_PROTOCOL_MAGIC "ASM1"
+
+/** @brief Upper bound on a name, a source or a captured stream in a message. */
+#define ASM_PROTOCOL_MAX_PAYLOAD (256UL * 1024 * 1024)
+
+/**
+ * @brief What a request asks the assembler daemon to do.
+ */
+typedef enum
+{
+    ASM_REQUEST_PATH    = 'P',  /* assemble the file name.as, as the daemon sees the path */
+    ASM_REQUEST_SOURCE  = 'S',  /* assemble the source sent with the request, named name.as */
+    ASM_REQUEST_STOP    = 'Q'   /* stop the daemon once the requests in progress are done */
+} AsmRequestKind;
+
+/**
+ * @brief A request to the assembler daemon (see asm_server.h).
+ *
+ * A message is a fixed size text header with the kind and the sizes, followed
+ * by the name and the source as they are.
+ */
+typedef struct AsmRequest
+{
+    AsmRequestKind  kind;
+    AsmOptions      options;
+    char*           name;           /* the file without the .as extension, or the name of the source */
+    char*           source;         /* the source of ASM_REQUEST_SOURCE, NULL otherwise */
+    size_t          source_length;
+} AsmRequest;
+
+/**
+ * @brief The reply of the assembler daemon to a request.
+ */
+typedef struct AsmResponse
+{
+    int     result;         /* VALID_RETURN if the file was assembled without errors, INVALID_RETURN otherwise */
+    char*   out;            /* the informational output of the assembly, as the assembler prints to stdout */
+    size_t  out_length;
+    char*   err;            /* the diagnostics of the assembly, as the assembler prints to stderr */
+    size_t  err_length;
+    char*   files;          /* absolute paths of the output files the assembly left, one per line */
+    size_t  files_length;
+} AsmResponse;
+
+/**
+ * @brief Connects to an assembler daemon.
+ * @param socket_path The UNIX socket the daemon listens on.
+ * @return The connected socket, or INVALID_RETURN if the daemon can't be reached.
+ */
+int asm_protocol_connect(const char* socket_path);
+
+/**
+ * @brief Sends a request.
+ * @param fd        The connected socket.
+ * @param request   The request, its buffers stay with the caller.
+ * @return VALID_RETURN on success, INVALID_RETURN if the connection failed.
+ */
+int asm_protocol_send_request(int fd, const AsmRequest* request);
+
+/**
+ * @brief Receives a request, its name and source are allocated.
+ * @param fd        The connected socket.
+ * @param request   Receives the request, free it with asm_protocol_free_request.
+ * @return VALID_RETURN on success, INVALID_RETURN at the end of the connection or on a malformed request.
+ */
+int asm_protocol_receive_request(int fd, AsmRequest* request);
+
+/**
+ * @brief Frees the buffers of a received request.
+ * @param request The request.
+ */
+void asm_protocol_free_request(AsmRequest* request);
+
+/**
+ * @brief Sends a response.
+ * @param fd        The connected socket.
+ * @param response  The response, its buffers stay with the caller.
+ * @return VALID_RETURN on success, INVALID_RETURN if the connection failed.
+ */
+int asm_protocol_send_response(int fd, const AsmResponse* response);
+
+/**
+ * @brief Receives a response, its buffers are allocated and null terminated.
+ * @param fd        The connected socket.
+ * @param response  Receives the response, free it with asm_protocol_free_response.
+ * @return VALID_RETURN on success, INVALID_RETURN if the connection failed or the response is malformed.
+ */
+int asm_protocol_receive_response(int fd, AsmResponse* response);
+
+/**
+ * @brief Frees the buffers of a received response.
+ * @param response The response.
+ */
+void asm_protocol_free_response(AsmResponse* response);
+
+/**
+ * @brief Sends a request and waits for its response.
+ * @param fd        The connected socket.
+ * @param request   The request.
+ * @param response  Receives the response, free it with asm_protocol_free_response.
+ * @return VALID_RETURN on success, INVALID_RETURN if the connection failed.
+ */
+int asm_protocol_call(int fd, const AsmRequest* request, AsmResponse* response);
+
+#endif /* ASM_PROTOCOL_H */
@@ -0,0 +1,347 @@
+#define _POSIX_C_SOURCE 200809L /* open_memstream */
+#include "asm_server.h"
+#include "asm_protocol.h"
+#include "asm_context.h"
+#include "context_pool.h"
+#include "common.h"
+#include "logger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+struct AsmConnection;
+
+typedef struct AsmServer
+{
+    int             listen_fd;
+    char            directory[MAX_FILENAME]; /* the working directory, the output files are under it */
+    ContextPool*    pool;       /* contexts of closed connections, their tables are warm */
+    pthread_mutex_t lock;       /* guards the fields below */
+    int             stopping;   /* set by a stop request, no more connections are accepted */
+    pthread_cond_t  closed;     /* signaled whenever a connection closes */
+    int             connections;            /* number of connections being served */
+    struct AsmConnection* open;             /* the connections being served */
+} AsmServer;
+
+/* A connection served by a thread of its own */
+typedef struct AsmConnection
+{
+    AsmServer*  server;
+    int         fd;
+    int         waiting;    /* set while the connection waits for a request, guarded by the server's lock */
+    struct AsmConnection* previous;
+    struct AsmConnection* next;
+} AsmConnection;
+
+/* Appends the absolute paths of the output files the assembly of 'name' left, one per line */
+static void list_output_files(const AsmServer* server, const char* name, int emit_am, FILE* files)
+{
+    const char* base = strrchr(name, '/');
+    struct stat info;
+    char path[3 * MAX_FILENAME];
+    int kind;
+
+    base = (base != NULL) ? base + 1 : name;
+    for (kind = 0; kind < OUTPUT_FILE_COUNT; kind++)
+    {
+        if (kind == OUTPUT_FILE_AM && !emit_am)
+            continue;
+        if (strlen(server->directory) + strlen(OUTPUT_PATH) + strlen(base) + 6 > sizeof(path))
+            continue;
+        sprintf(path, "%s/%s%s%s", server->directory, OUTPUT_PATH, base, output_file_extensions[kind]);
+        if (stat(path, &info) == 0)
+            fprintf(files, "%s\n", path);
+    }
+}
+
+/* Assembles the file or source of a request with the worker's context, and sends the response */
+static int serve_request(const AsmServer* server, AsmContext* context, int fd, const AsmRequest* request)
+{
+    AsmResponse response;
+    FILE* out   = open_memstream(&response.out, &response.out_length);
+    FILE* err   = open_memstream(&response.err, &response.err_length);
+    FILE* files = open_memstream(&response.files, &response.files_length);
+    int flag;
+
+    if (out == NULL || err == NULL || files == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to capture the output of a request.\n");
+        if (out != NULL)
+            fclose(out);
+        if (err != NULL)
+            fclose(err);
+        if (files != NULL)
+            fclose(files);
+        return INVALID_RETURN;
+    }
+
+    asm_context_set_options(context, &request->options);
+    asm_context_set_streams(context, out, err);
+    if (request->kind == ASM_REQUEST_SOURCE)
+        response.result = asm_context_assemble_buffer(context, request->name,
+            (request->source != NULL) ? request->source : "", request->source_length, NULL);
+    else
+        response.result = asm_context_assemble(context, request->name);
+    asm_context_set_streams(context, NULL, NULL);
+    list_output_files(server, request->name, request->options.emit_am, files);
+
+    fclose(out);
+    fclose(err);
+    fclose(files);
+    flag = asm_protocol_send_response(fd, &response);
+    free(response.out);
+    free(response.err);
+    free(response.files);
+    return flag;
+}
+
+/* Marks a connection as waiting for a request, returns 0 once the daemon is stopping */
+static int wait_for_request(AsmServer* server, AsmConnection* connection, int waiting)
+{
+    int stopping;
+
+    pthread_mutex_lock(&server->lock);
+    connection->waiting = waiting;
+    stopping = server->stopping;
+    pthread_mutex_unlock(&server->lock);
+    return !stopping;
+}
+
+/* Stops accepting connections and ends the ones waiting for a request, the others end after their request */
+static void stop_server(AsmServer* server)
+{
+    AsmConnection* connection;
+
+    pthread_mutex_lock(&server->lock);
+    server->stopping = 1;
+    /* the next read of an idle client returns end of file */
+    for (connection = server->open; connection != NULL; connection = connection->next)
+    {
+        if (connection->waiting)
+            shutdown(connection->fd, SHUT_RD);
+    }
+    pthread_mutex_unlock(&server->lock);
+    /* wakes up the accept loop */
+    shutdown(server->listen_fd, SHUT_RDWR);
+}
+
+/* Answers the requests of a connection until the client closes it or asks to stop, or the daemon stops */
+static void serve_connection(AsmServer* server, AsmContext* context, AsmConnection* connection)
+{
+    AsmRequest request;
+    int fd = connection->fd;
+
+    while (wait_for_request(server, connection, 1) && asm_protocol_receive_request(fd, &request) != INVALID_RETURN)
+    {
+        int flag;
+
+        wait_for_request(server, connection, 0);
+        if (request.kind == ASM_REQUEST_STOP)
+        {
+            AsmResponse response;
+
+            memset(&response, 0, sizeof(response));
+            response.result = VALID_RETURN;
+            stop_server(server);
+            asm_protocol_send_response(fd, &response);
+            asm_protocol_free_request(&request);
+            return;
+        }
+        if (request.name == NULL)
+        {
+            log_error(__FILE__,__LINE__,"Received a request without a name.\n");
+            asm_protocol_free_request(&request);
+            return;
+        }
+        flag = serve_request(server, context, fd, &request);
+        asm_protocol_free_request(&request);
+        if (flag == INVALID_RETURN)
+            return;
+    }
+}
+
+/* Keeps the context of a closed connection for the next one, and closes the connection */
+static void release_connection(AsmServer* server, AsmConnection* connection, AsmContext* context)
+{
+    context_pool_release(server->pool, context);
+    pthread_mutex_lock(&server->lock);
+    /* unlinked before its fd is closed, so a stop never shuts down a reused fd */
+    if (connection->previous != NULL)
+        connection->previous->next = connection->next;
+    else
+        server->open = connection->next;
+    if (connection->next != NULL)
+        connection->next->previous = connection->previous;
+    server->connections--;
+    pthread_cond_signal(&server->closed);
+    pthread_mutex_unlock(&server->lock);
+    close(connection->fd);
+    free(connection);
+}
+
+/* Runs on the thread of a connection */
+static void* run_connection(void* arg)
+{
+    AsmConnection* connection = (AsmConnection*)arg;
+    AsmServer* server = connection->server;
+    AsmContext* context = context_pool_take(server->pool);
+
+    if (context != NULL)
+        serve_connection(server, context, connection);
+    release_connection(server, connection, context);
+    return NULL;
+}
+
+/* Starts a detached thread for an accepted connection */
+static void start_connection(AsmServer* server, int fd)
+{
+    AsmConnection* connection = malloc(sizeof(AsmConnection));
+    pthread_attr_t attributes;
+    pthread_t thread;
+    int started = 0;
+
+    if (connection != NULL)
+    {
+        connection->server = server;
+        connection->fd = fd;
+        connection->waiting = 0;
+        connection->previous = NULL;
+        pthread_mutex_lock(&server->lock);
+        connection->next = server->open;
+        if (server->open != NULL)
+            server->open->previous = connection;
+        server->open = connection;
+        server->connections++;
+        pthread_mutex_unlock(&server->lock);
+
+        pthread_attr_init(&attributes);
+        pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+        started = pthread_create(&thread, &attributes, run_connection, connection) == 0;
+        pthread_attr_destroy(&attributes);
+    }
+    if (!started)
+    {
+        log_error(__FILE__,__LINE__,"Failed to start a thread for a connection.\n");
+        if (connection != NULL)
+            release_connection(server, connection, NULL);
+        else
+            close(fd);
+    }
+}
+
+/* Checks a socket left at the path, returns VALID_RETURN if it's stale and was removed, INVALID_RETURN if a daemon answers on it */
+static int remove_stale_socket(const struct sockaddr_un* address)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    int refused;
+
+    if (fd < 0)
+        return INVALID_RETURN;
+    refused = connect(fd, (const struct sockaddr*)address, sizeof(*address)) < 0 && errno == ECONNREFUSED;
+    close(fd);
+    if (!refused)
+    {
+        log_error(__FILE__,__LINE__,"A daemon is already serving on [%s].\n", address->sun_path);
+        return INVALID_RETURN;
+    }
+    unlink(address->sun_path);
+    return VALID_RETURN;
+}
+
+/* Creates the listening socket, replacing a socket an earlier daemon left at the path */
+static int open_listen_socket(const char* socket_path)
+{
+    struct sockaddr_un address;
+    struct stat info;
+    int fd;
+
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        log_error(__FILE__,__LINE__,"The socket path [%s] is too long.\n", socket_path);
+        return INVALID_RETURN;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    if (stat(socket_path, &info) == 0 && S_ISSOCK(info.st_mode) && remove_stale_socket(&address) == INVALID_RETURN)
+        return INVALID_RETURN;
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0)
+    {
+        log_error(__FILE__,__LINE__,"Failed to listen on [%s]: %s\n", socket_path, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return INVALID_RETURN;
+    }
+    return fd;
+}
+
+int asm_server_run(const char* socket_path, AsmCache* cache)
+{
+    AsmServer server;
+    int result;
+    int accept_error;
+
+    if (getcwd(server.directory, sizeof(server.directory)) == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to get the working directory.\n");
+        return INVALID_RETURN;
+    }
+    server.listen_fd = open_listen_socket(socket_path);
+    if (server.listen_fd == INVALID_RETURN)
+        return INVALID_RETURN;
+    /* a client may rewrite its source while it's assembled, a mapped file would bring the daemon down */
+    server.pool = context_pool_create(NULL, cache, 1);
+    if (server.pool == NULL)
+    {
+        close(server.listen_fd);
+        unlink(socket_path);
+        return INVALID_RETURN;
+    }
+    server.stopping = 0;
+    server.connections = 0;
+    server.open = NULL;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.closed, NULL);
+
+    /* a client that goes away mid response is an error on its connection only */
+    signal(SIGPIPE, SIG_IGN);
+    log_out(__FILE__,__LINE__,"Serving on [%s]\n", socket_path);
+
+    for (;;)
+    {
+        int fd = accept(server.listen_fd, NULL, NULL);
+        if (fd >= 0)
+            start_connection(&server, fd);
+        else if (errno != EINTR && errno != ECONNABORTED)
+            break;
+    }
+    accept_error = errno;
+
+    /* the requests in progress are answered before the contexts go, the idle connections were ended */
+    pthread_mutex_lock(&server.lock);
+    while (server.connections > 0)
+        pthread_cond_wait(&server.closed, &server.lock);
+    result = server.stopping ? VALID_RETURN : INVALID_RETURN;
+    pthread_mutex_unlock(&server.lock);
+    if (result == INVALID_RETURN)
+        log_error(__FILE__,__LINE__,"Failed to accept connections on [%s]: %s\n", socket_path, strerror(accept_error));
+    context_pool_destroy(server.pool);
+
+    pthread_cond_destroy(&server.closed);
+    pthread_mutex_destroy(&server.lock);
+    close(server.listen_fd);
+    unlink(socket_path);
+    log_out(__FILE__,__LINE__,"Stopped serving on [%s]\n", socket_path);
+    return result;
+}
@@ -0,0 +1,25 @@
+#ifndef ASM_SERVER_H
+#define ASM_SERVER_H
+
+#include "asm_cache.h"
+
+/**
+ * @brief Runs the assembler daemon on a UNIX socket until a stop request (see asm_protocol.h).
+ *
+ * Every connection is served by a thread of its own and sends any number of
+ * requests, each answered with the result, the captured output and diagnostics,
+ * and the absolute paths of the output files. The AsmContext of a closed
+ * connection is kept for the next one, so the tables and buffers stay warm
+ * across requests and connections. The output files are written to
+ * build/output_files/ under the directory the daemon was started in, as the
+ * assembler executable does. After a stop request the daemon ends the
+ * connections waiting for a request, answers the requests in progress and exits.
+ *
+ * @param socket_path The socket to create, a socket left by a daemon that exited is replaced.
+ *                    It fails when a daemon still answers on the socket.
+ * @param cache       The build cache of the files the daemon writes (see asm_cache.h), NULL for none.
+ * @return VALID_RETURN once stopped, INVALID_RETURN if the socket couldn't be created, is taken, or accepting failed.
+ */
+int asm_server_run(const char* socket_path, AsmCache* cache);
+
+#endif /* ASM_SERVER_H */
@@ -0,0 +1,344 @@
+#define _POSIX_C_SOURCE 200112L
+#include "asm_watch.h"
+#include "common.h"
+#include "logger.h"
+#include "worker_pool.h"
+#include "context_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <dirent.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+/* Milliseconds a wait for changes lasts before the interrupt flag is checked again */
+#define WATCH_POLL_MS 250
+/* Size of the buffer inotify events are read into */
+#define WATCH_EVENT_BUFFER_SIZE 65536
+#define SOURCE_EXTENSION ".as"
+
+#ifdef __linux__
+
+/* Set by SIGINT and SIGTERM */
+static volatile sig_atomic_t watch_interrupted;
+
+typedef struct Watch
+{
+    const char*     directory;
+    int             jobs;
+    char**          changed;    /* sources changed since the last batch, without the .as extension, in order */
+    int             changed_count;
+    int             changed_capacity;
+    CapturedJob*    batch;      /* the jobs of the batch being assembled */
+    ContextPool*    pool;       /* contexts of earlier jobs, their tables are warm */
+} Watch;
+
+static void interrupt_watch(int signal_number)
+{
+    (void)signal_number;
+    watch_interrupted = 1;
+}
+
+/* Runs on a worker thread: reassembles one source with a warm context */
+static void run_watch_job(int job_index, void* arg)
+{
+    Watch* watch = (Watch*)arg;
+    captured_job_run(&watch->batch[job_index], watch->pool);
+}
+
+/* Runs on the watching thread in order: prints the output the job captured */
+static void finish_watch_job(int job_index, void* arg)
+{
+    captured_job_finish(&((Watch*)arg)->batch[job_index]);
+}
+
+/* The length of the name without the .as extension, 0 if 'file' isn't a source */
+static size_t source_name_length(const char* file)
+{
+    size_t length = strlen(file);
+    size_t extension_length = strlen(SOURCE_EXTENSION);
+
+    if (length <= extension_length || strcmp(file + length - extension_length, SOURCE_EXTENSION) != 0)
+        return 0;
+    return length - extension_length;
+}
+
+/* Finds a source among the changed ones, returns its index or -1 */
+static int find_changed(const Watch* watch, const char* name)
+{
+    int i;
+    for (i = 0; i < watch->changed_count; i++)
+    {
+        if (strcmp(watch->changed[i], name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/* Builds the name of a file of the directory without its extension, NULL if it isn't a source */
+static char* source_name(const Watch* watch, const char* file)
+{
+    size_t length = source_name_length(file);
+    char* name;
+
+    if (length == 0)
+        return NULL;
+    name = malloc(strlen(watch->directory) + length + 2);
+    if (name == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate the name of [%s]\n", file);
+        return NULL;
+    }
+    sprintf(name, "%s/%.*s", watch->directory, (int)length, file);
+    return name;
+}
+
+/* Adds a file of the directory to the next batch, once */
+static void mark_changed(Watch* watch, const char* file)
+{
+    char* name = source_name(watch, file);
+
+    if (name == NULL)
+        return;
+    if (find_changed(watch, name) >= 0)
+    {
+        free(name);
+        return;
+    }
+    if (watch->changed_count == watch->changed_capacity)
+    {
+        int capacity = (watch->changed_capacity == 0) ? 16 : 2 * watch->changed_capacity;
+        char** grown = realloc(watch->changed, capacity * sizeof(char*));
+        if (grown == NULL)
+        {
+            log_error(__FILE__,__LINE__,"Failed to allocate the changed sources.\n");
+            free(name);
+            return;
+        }
+        watch->changed = grown;
+        watch->changed_capacity = capacity;
+    }
+    watch->changed[watch->changed_count++] = name;
+}
+
+/* Drops a file of the directory that is gone from the next batch */
+static void forget_changed(Watch* watch, const char* file)
+{
+    char* name = source_name(watch, file);
+    int index;
+
+    if (name == NULL)
+        return;
+    if ((index = find_changed(watch, name)) >= 0)
+    {
+        free(watch->changed[index]);
+        memmove(&watch->changed[index], &watch->changed[index + 1],
+            (watch->changed_count - index - 1) * sizeof(char*));
+        watch->changed_count--;
+    }
+    free(name);
+}
+
+static int compare_names(const void* a, const void* b)
+{
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+/* Adds every source of the directory to the next batch, in name order */
+static int mark_directory(Watch* watch)
+{
+    DIR* directory = opendir(watch->directory);
+    struct dirent* file;
+
+    if (directory == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to open the directory [%s]\n", watch->directory);
+        return INVALID_RETURN;
+    }
+    while ((file = readdir(directory)) != NULL)
+        mark_changed(watch, file->d_name);
+    closedir(directory);
+    qsort(watch->changed, watch->changed_count, sizeof(char*), compare_names);
+    return VALID_RETURN;
+}
+
+/* Assembles the changed sources on the worker threads and empties the list */
+static void assemble_changed(Watch* watch)
+{
+    int count = watch->changed_count;
+    int i;
+
+    if (count == 0)
+        return;
+    watch->batch = calloc(count, sizeof(CapturedJob));
+    if (watch->batch == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate the assembly jobs.\n");
+        return;
+    }
+    for (i = 0; i < count; i++)
+        watch->batch[i].name = watch->changed[i];
+
+    worker_pool_run(count, watch->jobs, run_watch_job, finish_watch_job, watch);
+
+    for (i = 0; i < count; i++)
+        free(watch->changed[i]);
+    free(watch->batch);
+    watch->batch = NULL;
+    watch->changed_count = 0;
+    log_out(__FILE__,__LINE__,"Assembled %d source%s, watching [%s] for changes\n",
+        count, (count == 1) ? "" : "s", watch->directory);
+}
+
+/* Reads the pending inotify events into the changed sources, INVALID_RETURN once the directory is gone */
+static int read_events(Watch* watch, int fd, char* buffer)
+{
+    ssize_t length = read(fd, buffer, WATCH_EVENT_BUFFER_SIZE);
+    ssize_t offset = 0;
+
+    if (length < 0)
+    {
+        if (errno == EINTR || errno == EAGAIN)
+            return VALID_RETURN;
+        log_error(__FILE__,__LINE__,"Failed to read the changes of [%s]\n", watch->directory);
+        return INVALID_RETURN;
+    }
+    while (offset < length)
+    {
+        const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+        offset += sizeof(struct inotify_event) + event->len;
+
+        if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+        {
+            log_error(__FILE__,__LINE__,"The directory [%s] was removed or moved.\n", watch->directory);
+            return INVALID_RETURN;
+        }
+        /* events were dropped, any source may have changed */
+        if (event->mask & IN_Q_OVERFLOW)
+            mark_directory(watch);
+        else if (event->len > 0 && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)))
+            mark_changed(watch, event->name);
+        else if (event->len > 0 && (event->mask & (IN_DELETE | IN_MOVED_FROM)))
+            forget_changed(watch, event->name);
+    }
+    return VALID_RETURN;
+}
+
+/* Waits for changes and assembles them in debounced batches until interrupted */
+static int watch_directory(Watch* watch, int fd)
+{
+    char* buffer = malloc(WATCH_EVENT_BUFFER_SIZE);
+    struct pollfd descriptor;
+    int flag = VALID_RETURN;
+
+    if (buffer == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate the event buffer.\n");
+        return INVALID_RETURN;
+    }
+    descriptor.fd = fd;
+    descriptor.events = POLLIN;
+
+    while (!watch_interrupted)
+    {
+        /* every change restarts the debounce wait, the batch goes once the directory is quiet */
+        int ready = poll(&descriptor, 1, (watch->changed_count > 0) ? WATCH_DEBOUNCE_MS : WATCH_POLL_MS);
+        if (ready < 0 && errno != EINTR)
+        {
+            log_error(__FILE__,__LINE__,"Failed to wait for the changes of [%s]\n", watch->directory);
+            flag = INVALID_RETURN;
+            break;
+        }
+        if (ready == 0)
+            assemble_changed(watch);
+        else if (ready > 0 && read_events(watch, fd, buffer) == INVALID_RETURN)
+        {
+            flag = INVALID_RETURN;
+            break;
+        }
+    }
+    free(buffer);
+    return flag;
+}
+
+int asm_watch_run(const char* directory, const AsmOptions* options, int jobs, AsmCache* cache)
+{
+    struct sigaction action, previous_interrupt, previous_terminate;
+    Watch watch;
+    int flag;
+    int fd;
+    int i;
+
+    fd = inotify_init();
+    if (fd < 0)
+    {
+        log_error(__FILE__,__LINE__,"Failed to start watching for changes: %s\n", strerror(errno));
+        return INVALID_RETURN;
+    }
+    if (inotify_add_watch(fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM |
+        IN_DELETE_SELF | IN_MOVE_SELF) < 0)
+    {
+        log_error(__FILE__,__LINE__,"Failed to watch [%s]: %s\n", directory, strerror(errno));
+        close(fd);
+        return INVALID_RETURN;
+    }
+
+    watch.directory = directory;
+    watch.jobs = jobs;
+    watch.changed = NULL;
+    watch.changed_count = 0;
+    watch.changed_capacity = 0;
+    watch.batch = NULL;
+    /* sources are edited while a batch runs, a mapped file cut short would end the watch with SIGBUS */
+    watch.pool = context_pool_create(options, cache, 1);
+    if (watch.pool == NULL)
+    {
+        close(fd);
+        return INVALID_RETURN;
+    }
+
+    /* without SA_RESTART an interrupt ends the wait for changes right away */
+    watch_interrupted = 0;
+    action.sa_handler = interrupt_watch;
+    action.sa_flags = 0;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &previous_interrupt);
+    sigaction(SIGTERM, &action, &previous_terminate);
+
+    /* the events from here on are read after the first batch, a source changed meanwhile isn't missed */
+    flag = mark_directory(&watch);
+    if (flag == VALID_RETURN)
+    {
+        assemble_changed(&watch);
+        flag = watch_directory(&watch, fd);
+    }
+    log_out(__FILE__,__LINE__,"Stopped watching [%s]\n", directory);
+
+    sigaction(SIGINT, &previous_interrupt, NULL);
+    sigaction(SIGTERM, &previous_terminate, NULL);
+    for (i = 0; i < watch.changed_count; i++)
+        free(watch.changed[i]);
+    free(watch.changed);
+    context_pool_destroy(watch.pool);
+    close(fd);
+    return flag;
+}
+
+#else
+
+int asm_watch_run(const char* directory, const AsmOptions* options, int jobs, AsmCache* cache)
+{
+    (void)options;
+    (void)jobs;
+    (void)cache;
+    log_error(__FILE__,__LINE__,"Watching [%s] needs inotify, which this system doesn't have.\n", directory);
+    return INVALID_RETURN;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,32 @@
+#ifndef ASM_WATCH_H
+#define ASM_WATCH_H
+
+#include "asm_context.h"
+#include "asm_cache.h"
+
+/** @brief Milliseconds without a change to a source before the changed sources are reassembled. */
+#define WATCH_DEBOUNCE_MS 100
+
+/**
+ * @brief Assembles the sources of a directory, then reassembles the ones that change until interrupted.
+ *
+ * Every .as file in the directory is assembled once, then the directory is watched
+ * with inotify. A source that is written or moved into the directory is reassembled
+ * once the directory has been quiet for WATCH_DEBOUNCE_MS, so an editor saving a
+ * file in several steps causes a single assembly, and the sources that changed
+ * together are assembled together on up to @p jobs threads. The other sources
+ * aren't touched. The contexts are kept between the batches, so their tables and
+ * buffers stay warm. The output is printed in the order the sources changed, as
+ * the assembler prints it for a list of files.
+ *
+ * Runs until SIGINT or SIGTERM, which are handled while it runs.
+ *
+ * @param directory The directory of the sources.
+ * @param options   The options of every assembly.
+ * @param jobs      Number of worker threads, 1 assembles serially.
+ * @param cache     The build cache of the contexts (see asm_cache.h), NULL for none.
+ * @return VALID_RETURN once interrupted, INVALID_RETURN if the directory couldn't be watched.
+ */
+int asm_watch_run(const char* directory, const AsmOptions* options, int jobs, AsmCache* cache);
+
+#endif /* ASM_WATCH_H */
@@ -16,11 +16,13 @@ generate final machine-readable output files.
 Processing Stages:
 ------------------
 1. Macro Expansion (Pre-Assembly Phase):
-   - Macros are parsed and expanded into a new `.am` file.
-   - If an error occurs during this step, the temporary file is deleted.
+   - The source is memory mapped (or read in large blocks) and scanned line by line.
+   - Macros are parsed and expanded into an in-memory buffer.
+   - With `--emit-am` the buffer is also written to a `.am` file.
+   - If an error occurs during this step, no `.am` file is written.
 
 2. First Pass:
-   - Parses the expanded `.am` file.
+   - Parses the expanded source straight from memory (no `.am` round trip).
    - Builds the symbol (label) table.
    - Validates syntax and structure.
    - Collects instruction and directive metadata.
@@ -31,17 +33,45 @@ Processing Stages:
      - `.ob`  - Object code
      - `.ent` - Entry labels
      - `.ext` - External labels
+   - With `--single-pass` there is no second pass: the words that reference a
+     label are backpatched as soon as it's defined, and every word is written
+     while the file is read, the records of the backpatched words are rewritten
+     at the end of the file (see single_pass.h).
 
 Design Notes:
 -------------
-- A shared `MacroTable` is reused across all files, and reset between them.
+- Every file is assembled through an `AsmContext` (see asm_context.h), which owns
+  the macro table, the expanded source, the arena, the error list and the output
+  streams. The same code is built into `build/libasm.a` for programs that
+  assemble without running this executable.
+- A serial run reuses a single context across all files, and resets it between them.
+- The labels and binary nodes of a file are allocated from an arena (see arena.h)
+  that is released at once when the file is done.
+- With `-j N` files are assembled concurrently by N worker threads. Every job
+  has a context of its own with captured output streams, and the captured output
+  is printed in file order, so the diagnostics and output files are identical to
+  a serial run.
+- With `--serve PATH` the assembler is a daemon answering requests on a UNIX
+  socket (see asm_server.h), and with `--connect PATH` the files are sent to it.
+- With `--cache DIR` the output files of every source assembled without errors
+  are kept in DIR, keyed by a hash of the source and the assembler version
+  (see asm_cache.h). A source that didn't change since is restored from there
+  instead of being assembled. `--cache-size MB` limits the size of DIR, the least
+  recently used entries are evicted past it.
+- With `--watch DIR` every source in DIR is assembled, then DIR is watched with
+  inotify and only the sources that change are reassembled, in debounced batches
+  on the -j worker threads (see asm_watch.h).
 - Logging is handled via a custom logger that outputs metadata and context.
 - All errors are collected into an internal array and printed at the end of each pass.
+  An error is a small record, its message comes from a static table when it's printed.
+  With `--max-errors N` a file stops being read once it has N errors.
 - Output files are automatically removed if they contain no relevant data.
 
 Usage:
 ------
-./assembler <filename1> <filename2> ...
+./assembler [--emit-am] [--single-pass] [-j N] [--max-errors N] [--cache DIR [--cache-size MB]] [--connect PATH] <filename1> <filename2> ...
+./assembler [--cache DIR [--cache-size MB]] --serve PATH
+./assembler [--emit-am] [--single-pass] [-j N] [--max-errors N] [--cache DIR [--cache-size MB]] --watch DIR
 
 Notes:
 ------
@@ -74,71 +104,318 @@ debugging the assembler's runtime behavior.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-#include "input.h"
 #include "common.h"
-#include "macro_table.h"
-#include "pre_asm.h"
-#include "utility.h"
-#include "first_pass.h"
-#include "label_table.h"
 #include "logger.h"
+#include "asm_context.h"
+#include "asm_protocol.h"
+#include "asm_server.h"
+#include "asm_watch.h"
+#include "context_pool.h"
+#include "worker_pool.h"
 
-int main(int argc,char* argv[])
+/* Writes the expanded source of every file to its .am file as well */
+#define EMIT_AM_OPTION "--emit-am"
+/* Backpatches the labels while reading the file, instead of in a second pass */
+#define SINGLE_PASS_OPTION "--single-pass"
+/* Assembles the files with N worker threads: "-j N" or "-jN" */
+#define JOBS_OPTION "-j"
+/* Stops reading a file once it has N errors: "--max-errors N" */
+#define MAX_ERRORS_OPTION "--max-errors"
+/* Runs as a daemon answering assembly requests on a UNIX socket: "--serve PATH" */
+#define SERVE_OPTION "--serve"
+/* Has the daemon listening on a UNIX socket assemble the files: "--connect PATH" */
+#define CONNECT_OPTION "--connect"
+/* Assembles the sources of a directory and reassembles them whenever they change: "--watch DIR" */
+#define WATCH_OPTION "--watch"
+/* Restores the output files of unchanged sources from a build cache directory: "--cache DIR" */
+#define CACHE_OPTION "--cache"
+/* The size limit of the build cache in megabytes: "--cache-size MB" */
+#define CACHE_SIZE_OPTION "--cache-size"
+
+#define USAGE "Usage: build/assembler [" EMIT_AM_OPTION "] [" SINGLE_PASS_OPTION "] [" JOBS_OPTION " N] [" MAX_ERRORS_OPTION " N] " \
+    "[" CACHE_OPTION " DIR [" CACHE_SIZE_OPTION " MB]] [" CONNECT_OPTION " PATH] <filename1> <filename2> ...\n" \
+    "       build/assembler [" CACHE_OPTION " DIR [" CACHE_SIZE_OPTION " MB]] " SERVE_OPTION " PATH\n" \
+    "       build/assembler [" EMIT_AM_OPTION "] [" SINGLE_PASS_OPTION "] [" JOBS_OPTION " N] [" MAX_ERRORS_OPTION " N] " \
+    "[" CACHE_OPTION " DIR [" CACHE_SIZE_OPTION " MB]] " WATCH_OPTION " DIR\n"
+
+typedef struct AssemblerOptions
+{
+    AsmOptions  assembly;   /* the options of every file, see asm_context.h */
+    int         jobs;       /* number of worker threads, 1 assembles serially */
+    const char* serve;      /* the socket to serve requests on, NULL to assemble the files */
+    const char* connect;    /* the socket of a daemon that assembles the files, NULL to assemble them here */
+    const char* watch;      /* the directory whose sources are reassembled as they change, NULL for none */
+    const char* cache_directory;    /* the build cache, NULL for none */
+    unsigned long cache_size;       /* the size limit of the build cache, in bytes */
+    AsmCache*   cache;      /* the build cache opened from cache_directory */
+    char**      files;      /* the input files, without the .as extension */
+    int         files_count;
+} AssemblerOptions;
+
+typedef struct AssemblyRun
+{
+    CapturedJob*    jobs;
+    ContextPool*    pool;   /* the contexts of the workers, warm between the files */
+} AssemblyRun;
+
+/* Runs on a worker thread: assembles one file with a context of the pool */
+static void run_assembly_job(int job_index, void* arg)
+{
+    AssemblyRun* run = (AssemblyRun*)arg;
+    captured_job_run(&run->jobs[job_index], run->pool);
+}
+
+/* Runs on the main thread in file order: prints the output the job captured */
+static void finish_assembly_job(int job_index, void* arg)
 {
-    FILE* fp;
-    char current_file[MAX_FILENAME];
-    char output_file[MAX_FILENAME];
-    int file_index          = 1;
-    int arg_count           = argc;
-    MacroTable* macro_table;
-
-    if(argc < 2)
+    captured_job_finish(&((AssemblyRun*)arg)->jobs[job_index]);
+}
+
+/* Assembles every file with a pool of worker threads */
+static int assemble_files_parallel(const AssemblerOptions* options)
+{
+    AssemblyRun run;
+    int result;
+    int i;
+
+    run.pool = context_pool_create(&options->assembly, options->cache, 0);
+    run.jobs = calloc(options->files_count, sizeof(CapturedJob));
+    if(run.pool == NULL || run.jobs == NULL)
     {
-        log_error(__FILE__,__LINE__,"Usage: build/assembler <filename1> <filename2> ...");
+        log_error(__FILE__,__LINE__,"Failed to allocate the assembly jobs.\n");
+        context_pool_destroy(run.pool);
+        free(run.jobs);
         return INVALID_RETURN;
     }
+    for(i = 0; i < options->files_count; i++)
+        run.jobs[i].name = options->files[i];
+
+    result = worker_pool_run(options->files_count, options->jobs, run_assembly_job, finish_assembly_job, &run);
+    free(run.jobs);
+    context_pool_destroy(run.pool);
+    return result;
+}
+
+/* Assembles every file in turn with a single context, its tables and buffers are reused between files */
+static int assemble_files_serial(const AssemblerOptions* options)
+{
+    int file_index;
+    AsmContext* context = asm_context_create(&options->assembly, NULL, NULL);
+
+    if(context == NULL)
+        return INVALID_RETURN;
+    asm_context_set_cache(context, options->cache);
+    for(file_index = 0; file_index < options->files_count; file_index++)
+        asm_context_assemble(context, options->files[file_index]);
+    asm_context_destroy(context);
+    return VALID_RETURN;
+}
 
-    macro_table = macro_table_create(10);
+/* Sends every file to the daemon on options->connect, and prints what it reports as a local run would */
+static int assemble_files_remote(const AssemblerOptions* options)
+{
+    char directory[MAX_FILENAME];
+    char path[2 * MAX_FILENAME];
+    AsmRequest request;
+    AsmResponse response;
+    int file_index;
+    int fd = asm_protocol_connect(options->connect);
+
+    if(fd == INVALID_RETURN)
+    {
+        log_error(__FILE__,__LINE__,"Failed to connect to the assembler daemon on [%s].\n", options->connect);
+        return INVALID_RETURN;
+    }
+    if(getcwd(directory, sizeof(directory)) == NULL)
+        directory[0] = NULL_TERMINATOR;
 
-    while(--arg_count > 0)
+    request.kind = ASM_REQUEST_PATH;
+    request.options = options->assembly;
+    request.source = NULL;
+    request.source_length = 0;
+    for(file_index = 0; file_index < options->files_count; file_index++)
     {
-        strcpy(current_file,argv[file_index]);
-        strcat(current_file, ".as");
-        log_out(__FILE__, __LINE__,"opening filename: %s\n",current_file);
-        fp = fopen(current_file,"r");
-        if(fp == NULL)
+        /* the daemon may run in another directory, relative paths are made absolute */
+        const char* name = options->files[file_index];
+        if(name[0] != '/' && strlen(directory) + strlen(name) + 2 <= sizeof(path))
         {
-            log_error(__FILE__,__LINE__,"Failed to open %s, file doesn't exists.\n", current_file);
-            file_index++;
-            continue;
+            sprintf(path, "%s/%s", directory, name);
+            name = path;
         }
+        request.name = (char*)name;
+        if(asm_protocol_call(fd, &request, &response) == INVALID_RETURN)
+        {
+            log_error(__FILE__,__LINE__,"The assembler daemon on [%s] didn't answer.\n", options->connect);
+            close(fd);
+            return INVALID_RETURN;
+        }
+        fwrite(response.out, sizeof(char), response.out_length, stdout);
+        fwrite(response.err, sizeof(char), response.err_length, stderr);
+        /* the output files go on lines of their own */
+        if(response.out_length > 0 && response.out[response.out_length - 1] != NEW_LINE && response.files_length > 0)
+            fputc(NEW_LINE, stdout);
+        fwrite(response.files, sizeof(char), response.files_length, stdout);
+        asm_protocol_free_response(&response);
+    }
+    close(fd);
+    return VALID_RETURN;
+}
+
+/* Parses the command line options, the remaining arguments are the input files */
+static int parse_options(int argc, char* argv[], AssemblerOptions* options)
+{
+    int i;
+    const char* jobs;
+
+    options->assembly.emit_am = 0;
+    options->assembly.single_pass = 0;
+    options->assembly.max_errors = 0;
+    options->jobs = 1;
+    options->serve = NULL;
+    options->connect = NULL;
+    options->watch = NULL;
+    options->cache_directory = NULL;
+    options->cache_size = DEFAULT_CACHE_SIZE_LIMIT;
+    options->cache = NULL;
+    options->files_count = 0;
+    options->files = malloc(sizeof(char*) * argc);
+    if(options->files == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate the input file list.\n");
+        return INVALID_RETURN;
+    }
 
-        if(parse_macros(fp, current_file,output_file,macro_table) != INVALID_RETURN)
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], EMIT_AM_OPTION) == 0)
         {
-            log_out(__FILE__,__LINE__,"Done Parsing Macros for - %s\n", current_file);
-            fclose(fp);           
-            /* 
-                preprares first pass and executes it, 
-                and continues to the 2nd pass     
-            */
-            prepare_first_pass(output_file,macro_table);
+            options->assembly.emit_am = 1;
         }
-        else
+        else if(strcmp(argv[i], SINGLE_PASS_OPTION) == 0)
         {
-            log_out(__FILE__,__LINE__,"Error Parsing Macros for - %s\n", output_file);
-            fclose(fp);
-            /* Found error in Pre-Asm -> Delete .am File */
-            if (remove(output_file) != 0) 
+            options->assembly.single_pass = 1;
+        }
+        else if(strcmp(argv[i], MAX_ERRORS_OPTION) == 0)
+        {
+            if(i + 1 >= argc || (options->assembly.max_errors = atoi(argv[i + 1])) < 1)
+            {
+                log_error(__FILE__,__LINE__,"Invalid number of errors after " MAX_ERRORS_OPTION ", expected at least 1.\n");
+                free(options->files);
+                return INVALID_RETURN;
+            }
+            i++;
+        }
+        else if(strcmp(argv[i], SERVE_OPTION) == 0 || strcmp(argv[i], CONNECT_OPTION) == 0 ||
+            strcmp(argv[i], CACHE_OPTION) == 0 || strcmp(argv[i], WATCH_OPTION) == 0)
+        {
+            if(i + 1 >= argc)
+            {
+                log_error(__FILE__,__LINE__,"Missing the path after %s.\n", argv[i]);
+                free(options->files);
+                return INVALID_RETURN;
+            }
+            if(strcmp(argv[i], SERVE_OPTION) == 0)
+                options->serve = argv[i + 1];
+            else if(strcmp(argv[i], CONNECT_OPTION) == 0)
+                options->connect = argv[i + 1];
+            else if(strcmp(argv[i], WATCH_OPTION) == 0)
+                options->watch = argv[i + 1];
+            else
+                options->cache_directory = argv[i + 1];
+            i++;
+        }
+        else if(strcmp(argv[i], CACHE_SIZE_OPTION) == 0)
+        {
+            long megabytes = (i + 1 < argc) ? atol(argv[i + 1]) : 0;
+            if(megabytes < 1 || (unsigned long)megabytes > (unsigned long)-1 / (1024UL * 1024UL))
             {
-                perror("Failed to delete file");
+                log_error(__FILE__,__LINE__,"Invalid cache size after " CACHE_SIZE_OPTION ", expected at least 1 megabyte.\n");
+                free(options->files);
+                return INVALID_RETURN;
             }
+            options->cache_size = (unsigned long)megabytes * 1024UL * 1024UL;
+            i++;
         }
+        else if(strncmp(argv[i], JOBS_OPTION, strlen(JOBS_OPTION)) == 0)
+        {
+            jobs = argv[i] + strlen(JOBS_OPTION);
+            if(*jobs == NULL_TERMINATOR)
+            {
+                if(i + 1 >= argc)
+                {
+                    log_error(__FILE__,__LINE__,"Missing the number of jobs after " JOBS_OPTION ".\n");
+                    free(options->files);
+                    return INVALID_RETURN;
+                }
+                jobs = argv[++i];
+            }
+            options->jobs = atoi(jobs);
+            if(options->jobs < 1 || options->jobs > MAX_WORKER_THREADS)
+            {
+                log_error(__FILE__,__LINE__,"Invalid number of jobs [%s], expected 1 to %d.\n", jobs, MAX_WORKER_THREADS);
+                free(options->files);
+                return INVALID_RETURN;
+            }
+        }
+        else
+        {
+            options->files[options->files_count++] = argv[i];
+        }
+    }
+    return VALID_RETURN;
+}
+
+/* Prints the counters of the build cache and closes it */
+static void close_cache(AsmCache* cache)
+{
+    AsmCacheStats stats;
+
+    if(cache == NULL)
+        return;
+    asm_cache_stats(cache, &stats);
+    log_out(__FILE__,__LINE__,"Build cache [%s]: %lu hits, %lu misses, %lu stored, %lu evicted\n",
+        asm_cache_directory(cache), stats.hits, stats.misses, stats.stores, stats.evictions);
+    asm_cache_close(cache);
+}
 
-        file_index++;
-        macro_table_reset(&macro_table);
+int main(int argc,char* argv[])
+{
+    AssemblerOptions options;
+    int result;
+
+    if(argc < 2 || parse_options(argc, argv, &options) == INVALID_RETURN)
+    {
+        log_error(__FILE__,__LINE__,USAGE);
+        return INVALID_RETURN;
+    }
+    if(options.serve == NULL && options.watch == NULL && options.files_count == 0)
+    {
+        log_error(__FILE__,__LINE__,USAGE);
+        free(options.files);
+        return INVALID_RETURN;
+    }
+    /* the daemon assembles the files of a client, it uses a cache of its own */
+    if(options.cache_directory != NULL && options.connect == NULL &&
+        (options.cache = asm_cache_open(options.cache_directory, options.cache_size)) == NULL)
+    {
+        free(options.files);
+        return INVALID_RETURN;
     }
 
-    macro_table_destroy(macro_table);
-    return VALID_RETURN;
+    if(options.serve != NULL)
+        result = asm_server_run(options.serve, options.cache);
+    else if(options.watch != NULL)
+        result = asm_watch_run(options.watch, &options.assembly, options.jobs, options.cache);
+    else if(options.connect != NULL)
+        result = assemble_files_remote(&options);
+    else if(options.jobs > 1 && options.files_count > 1)
+        result = assemble_files_parallel(&options);
+    else
+        result = assemble_files_serial(&options);
+
+    close_cache(options.cache);
+    free(options.files);
+    return result;
 }
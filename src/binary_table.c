@@ -1,6 +1,7 @@
 #include "binary_table.h"
 #include "logger.h"
 #include <stdlib.h>
+#include <string.h>
 #include "utility.h"
 
 BinaryNode* init_binary_node()
@@ -14,15 +15,65 @@ BinaryNode* init_binary_node()
     return node;
 }
 
-void print_binary_node(BinaryNode* node)
+/* Copies the characters of the node's line at [start, start + length) after 'prefix', clipped to the line as read by the first pass */
+static const char* rebuild_text(const BinaryTable* table, const BinaryNode* node, const char* prefix, 
+    size_t start, size_t length, char* text)
+{
+    const char* line        = table->source + node->line;
+    size_t line_length      = table->source_length - node->line;
+    const char* new_line    = memchr(line, NEW_LINE, line_length);
+    size_t prefix_length    = strlen(prefix);
+
+    if (new_line != NULL)
+        line_length = new_line - line;
+    if (line_length > MAX_LINE - 1)
+        line_length = MAX_LINE - 1;
+    if (start > line_length)
+        start = line_length;
+    if (length > line_length - start)
+        length = line_length - start;
+
+    memcpy(text, prefix, prefix_length);
+    memcpy(text + prefix_length, line + start, length);
+    text[prefix_length + length] = NULL_TERMINATOR;
+    return text;
+}
+
+const char* binary_node_text(const BinaryTable* table, const BinaryNode* node, char* text)
+{
+    switch (node->text)
+    {
+    case NODE_TEXT_IMMEDIATE:       return "Immediate value";
+    case NODE_TEXT_LABEL_ADDRESS:   return "Address of Label";
+    case NODE_TEXT_LABEL_DISTANCE:  return "Distance to Label";
+    case NODE_TEXT_ASCII_END:       return "Ascii code '\\0'";
+    default:                        break;
+    }
+
+    if (table->source == NULL || node->line > table->source_length)
+        return "NULL";
+
+    if (node->text == NODE_TEXT_INTEGER)
+        return rebuild_text(table, node, "Integer ", node->text_start, node->text_length, text);
+    if (node->text == NODE_TEXT_ASCII)
+        return rebuild_text(table, node, "Ascii code ", node->text_start, node->text_length, text);
+    return rebuild_text(table, node, "", 0, MAX_LINE, text);
+}
+
+void print_binary_node(const BinaryTable* table, const BinaryNode* node)
 {
     if (node)
     {
+        char text[BINARY_NODE_TEXT_SIZE];
+        const Fixup* fixup;
         /* Found a valid entry */
-        fprintf(stdout,  "[address: %u] - [line: %s] - \t\t", node->address, (node->line) ? node->line : "NULL");
+        fprintf(log_output_stream(),  "[address: %u] - [line: %s] - \t\t", node->address, binary_node_text(table, node, text));
         print_wordfield(node->word);
-        if(node->unresolved_label)
-            fprintf(stdout,  "[unresolved label: %s]\n", node->unresolved_label);
+        if((fixup = fixup_list_find(&table->fixups, node->address)) != NULL)
+        {
+            fprintf(log_output_stream(),  "[unresolved label: %s%s]\n", (fixup->kind == FIXUP_RELATIVE) ? "&" : "", 
+                table->fixups.symbols[fixup->symbol].name);
+        }
     }
     else
     {
@@ -31,7 +82,7 @@ void print_binary_node(BinaryNode* node)
     }
 }
 
-BinaryTable* binary_table_create(size_t initial_size) 
+BinaryTable* binary_table_create(size_t initial_size, Arena* arena) 
 {
     size_t i;
     BinaryTable* table = malloc(sizeof(BinaryTable));
@@ -53,6 +104,15 @@ BinaryTable* binary_table_create(size_t initial_size)
 
     table->size = 0;
     table->capacity = initial_size;
+    table->released = 0;
+    table->spare = NULL;
+    table->spare_count = 0;
+    table->spare_capacity = 0;
+    table->source = NULL;
+    table->source_length = 0;
+    table->line = 0;
+    table->arena = arena;
+    fixup_list_init(&table->fixups, arena);
     return table;
 }
 
@@ -62,16 +122,17 @@ void binary_table_destroy(BinaryTable* table)
     if (!table || !table->data) 
         return;
 
-    for (i = 0; i < table->size; i++) 
+    /* nodes in an arena are released with the arena */
+    for (i = 0; i < table->size && table->arena == NULL; i++) 
     {
-        if (table->data[i]) 
-        {
-            free(table->data[i]->line); 
-            free(table->data[i]->word);
-            free(table->data[i]->unresolved_label);
-            free(table->data[i]);
-        }
+        free(table->data[i]);
     }
+    for (i = 0; i < table->spare_count && table->arena == NULL; i++) 
+    {
+        free(table->spare[i]);
+    }
+    fixup_list_destroy(&table->fixups);
+    free(table->spare);
     free(table->data);
     table->data = NULL;
     table->size = 0;
@@ -79,74 +140,126 @@ void binary_table_destroy(BinaryTable* table)
     free(table);
 }
 
-void binary_node_add(BinaryTable* table, unsigned int address, char* line,char* unresolved_label) 
+/* Grows the table so that slot 'index' exists, new slots are set to NULL */
+static void binary_table_reserve(BinaryTable* table, size_t index)
 {
-    if (!table || !table->data) 
+    size_t i;
+    size_t new_capacity = table->capacity ? table->capacity : DEFAULT_BINARY_TABLE_SIZE;
+    BinaryNode** new_data;
+
+    if (index < table->capacity)
         return;
 
-    if (table->size >= table->capacity) 
+    while (new_capacity <= index)
+        new_capacity *= 2;
+
+    new_data = (BinaryNode**)realloc(table->data, new_capacity * sizeof(BinaryNode*));
+    if (!new_data) 
     {
-        size_t i;
-        size_t new_capacity = table->capacity * 2;
-        BinaryNode** new_data = (BinaryNode**)realloc(table->data, new_capacity * sizeof(BinaryNode*));
+        log_error(__FILE__,__LINE__,"Failed to resize BinaryTable");
+        exit(EXIT_FAILURE);
+    }
 
-        if (!new_data) 
-        {
-            log_error(__FILE__,__LINE__,"Failed to resize BinaryTable");
-            exit(EXIT_FAILURE);
-        }
+    /* Initialize new elements to NULL */
+    for (i = table->capacity; i < new_capacity; i++) 
+        new_data[i] = NULL;
 
-        /* Initialize new elements to NULL */
-        for (i = table->capacity; i < new_capacity; i++) {
-            new_data[i] = NULL;
-        }
+    table->data = new_data;
+    table->capacity = new_capacity;
+}
 
-        table->data = new_data;
-        table->capacity = new_capacity;
+/* Creates the node for 'address', or returns NULL if it can't be added */
+static BinaryNode* binary_node_create(BinaryTable* table, unsigned int address, NodeTextKind text)
+{
+    size_t index;
+
+    if (!table || !table->data || address < START_ADDRESS) 
+        return NULL;
+
+    index = BINARY_TABLE_INDEX(address);
+    if (index < table->released)
+    {
+        log_error(__FILE__,__LINE__,"BinaryNode at address %u was already written\n", address);
+        return NULL;
+    }
+    index -= table->released;
+    binary_table_reserve(table, index);
+
+    if (table->data[index]) 
+    {
+        log_error(__FILE__,__LINE__,"BinaryNode at address %u already exists\n", address);
+        return NULL;
     }
 
-    /* Allocate and initialize new node */
-    table->data[table->size] = init_binary_node();
-    if (!table->data[table->size]) 
+    /* Reuse a released node, or allocate and initialize a new one */
+    if (table->spare_count > 0)
+    {
+        table->data[index] = table->spare[--table->spare_count];
+        memset(table->data[index], 0, sizeof(BinaryNode));
+    }
+    else if (table->arena != NULL)
+        table->data[index] = arena_calloc(table->arena, 1, sizeof(BinaryNode));
+    else
+        table->data[index] = init_binary_node();
+    if (!table->data[index]) 
     {
         perror("Failed to allocate BinaryNode");
         exit(EXIT_FAILURE);
     }
 
-    table->data[table->size]->address = address;
-    table->data[table->size]->line = my_strdup(line);
-    table->data[table->size]->unresolved_label = my_strdup(unresolved_label); 
-    table->size++;
+    table->data[index]->address = address;
+    table->data[index]->line = table->line;
+    table->data[index]->text = (unsigned char)text;
+    if (index >= table->size)
+        table->size = index + 1;
+    return table->data[index];
 }
 
-void set_binary_node_wordfield(BinaryTable* table, unsigned int address, wordfield* word)
+void binary_table_set_source(BinaryTable* table, const char* source, size_t length)
 {
-    int node_index = binary_table_search(table, address);
-
-    if (node_index == INVALID_RETURN || !table || !table->data || !word) 
+    if (!table)
         return;
+    table->source = source;
+    table->source_length = length;
+    table->line = 0;
+}
+
+void binary_table_set_line(BinaryTable* table, size_t line_offset)
+{
+    if (table)
+        table->line = line_offset;
+}
+
+void binary_node_add(BinaryTable* table, unsigned int address, NodeTextKind text) 
+{
+    binary_node_create(table, address, text);
+}
+
+void binary_node_add_label(BinaryTable* table, unsigned int address, NodeTextKind text, const char* label, size_t label_length)
+{
+    if (binary_node_create(table, address, text) != NULL)
+        fixup_list_add(&table->fixups, address, label, label_length);
+}
 
-    if (!table->data[node_index]->word)  /* If not already allocated, allocate memory */
+void binary_node_add_data(BinaryTable* table, unsigned int address, NodeTextKind text, int start, int length)
+{
+    BinaryNode* node = binary_node_create(table, address, text);
+    if (node != NULL)
     {
-        table->data[node_index]->word = init_wordfield();
-        if (!table->data[node_index]->word)
-        {
-            log_error(__FILE__,__LINE__,"Failed to allocate memory for wordfield\n");
-            return;
-        }
+        /* a line is at most MAX_LINE characters, so both fit in a byte */
+        node->text_start  = (unsigned char)start;
+        node->text_length = (unsigned char)length;
     }
-
-    *(table->data[node_index]->word) = *word;  /* assign struct contents into allocated memory */
 }
 
-void set_binary_node_unresolved_label(BinaryTable* table, unsigned int address, char* name)
+void set_binary_node_wordfield(BinaryTable* table, unsigned int address, wordfield word)
 {
     int node_index = binary_table_search(table, address);
 
-    if (node_index == INVALID_RETURN || !table || !table->data || !name) 
+    if (node_index == INVALID_RETURN || !table || !table->data) 
         return;
-    
-    table->data[node_index]->unresolved_label = my_strdup(name);
+
+    table->data[node_index]->word = word;
 }
 
 void binary_table_print(BinaryTable* table)
@@ -158,23 +271,64 @@ void binary_table_print(BinaryTable* table)
     log_out(__FILE__,__LINE__,"Printing the Binary Table: \n");
     for (i = 0; i < table->size; i++) 
     {
-        print_binary_node(table->data[i]);
+        if (table->data[i])
+            print_binary_node(table, table->data[i]);
     }
 }
 
-int binary_table_search(BinaryTable* table, unsigned int address)
+void binary_table_release(BinaryTable* table, unsigned int address)
 {
-    size_t i;
+    size_t i, count, occupied;
 
-    if (!table || !table->data) 
-        return INVALID_RETURN;
+    if (!table || !table->data || address < START_ADDRESS) 
+        return;
 
-    for (i = 0; i < table->size; i++) 
+    count = BINARY_TABLE_INDEX(address);
+    if (count <= table->released)
+        return;
+    count -= table->released;
+    occupied = (count < table->size) ? count : table->size;
+
+    for (i = 0; i < occupied; i++)
     {
-        if(table->data[i] && table->data[i]->address == address)
+        if (table->data[i] == NULL)
+            continue;
+        if (table->spare_count == table->spare_capacity)
         {
-            return i;
+            size_t capacity = table->spare_capacity ? table->spare_capacity * 2 : DEFAULT_BINARY_TABLE_SIZE;
+            BinaryNode** spare = (BinaryNode**)realloc(table->spare, capacity * sizeof(BinaryNode*));
+            if (!spare)
+            {
+                log_error(__FILE__,__LINE__,"Failed to resize the released nodes of a BinaryTable");
+                exit(EXIT_FAILURE);
+            }
+            table->spare = spare;
+            table->spare_capacity = capacity;
         }
+        table->spare[table->spare_count++] = table->data[i];
     }
+
+    memmove(table->data, table->data + occupied, (table->size - occupied) * sizeof(BinaryNode*));
+    for (i = table->size - occupied; i < table->size; i++)
+        table->data[i] = NULL;
+    table->size -= occupied;
+    table->released += count;
+    fixup_list_release(&table->fixups, address);
+}
+
+int binary_table_search(BinaryTable* table, unsigned int address)
+{
+    size_t index;
+
+    if (!table || !table->data || address < START_ADDRESS) 
+        return INVALID_RETURN;
+
+    index = BINARY_TABLE_INDEX(address);
+    if (index < table->released)
+        return INVALID_RETURN;
+    index -= table->released;
+    if (index < table->size && table->data[index])
+        return (int)index;
+
     return INVALID_RETURN;
 }
\ No newline at end of file
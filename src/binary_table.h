@@ -2,23 +2,44 @@
 #define BINARY_TABLE_H
  
 #include "wordfield.h"
+#include "common.h"
+#include "arena.h"
+#include "fixup_list.h"
 #include <stdlib.h>
 #include <stdio.h>
  
 /** @brief Default capacity for a BinaryTable. */
 #define DEFAULT_BINARY_TABLE_SIZE 25
 
+/** @brief Size of a buffer that holds the text of any BinaryNode, see binary_node_text. */
+#define BINARY_NODE_TEXT_SIZE MAX_WORD
+
+/**
+ * @brief What the text of a BinaryNode is made of. The text is never stored,
+ * it is rebuilt from the source only when a listing or a debug dump needs it.
+ */
+typedef enum
+{
+    NODE_TEXT_LINE,             /* the source line of the word */
+    NODE_TEXT_IMMEDIATE,        /* "Immediate value" */
+    NODE_TEXT_LABEL_ADDRESS,    /* "Address of Label" */
+    NODE_TEXT_LABEL_DISTANCE,   /* "Distance to Label" */
+    NODE_TEXT_INTEGER,          /* "Integer " followed by a number of the source line */
+    NODE_TEXT_ASCII,            /* "Ascii code " followed by a character of the source line */
+    NODE_TEXT_ASCII_END         /* "Ascii code '\0'" */
+} NodeTextKind;
+
 /**
- * @brief Holds address, line text, and a pointer to a wordfield.
+ * @brief Holds address, a reference to the line text, and the machine word at that address.
  */
 typedef struct BinaryNode
 {
-    unsigned int address; /* Memory address. */
-    char* line;           /* Original line text. */
-    wordfield* word;      /* Pointer to the wordfield. */
-    /* store a label if we need to fix it in the 2nd-Pass. 
-       NULL if there's no unresolved label. */
-    char* unresolved_label;
+    unsigned int address;       /* Memory address. */
+    wordfield word;             /* The packed machine word. */
+    size_t line;                /* Offset of the source line in the source of the table. */
+    unsigned char text;         /* NodeTextKind of the text. */
+    unsigned char text_start;   /* INTEGER / ASCII: position of the characters in the line. */
+    unsigned char text_length;  /* INTEGER / ASCII: number of characters. */
 } BinaryNode;
 
 /**
@@ -27,59 +48,120 @@ typedef struct BinaryNode
  */
 BinaryNode* init_binary_node();
 
+
 /**
- * @brief Prints a single BinaryNode.
- * @param node The BinaryNode to print.
+ * @brief Converts a memory address into its slot in a BinaryTable.
  */
-void print_binary_node(BinaryNode* node);
+#define BINARY_TABLE_INDEX(address) ((size_t)((address) - START_ADDRESS))
 
 /**
- * @brief A dynamic array of BinaryNode pointers.
+ * @brief A dense, address-indexed array of BinaryNode pointers.
+ *
+ * The node for a given address lives at data[address - START_ADDRESS - released], so
+ * adding, searching and updating a node are all O(1). Addresses that were skipped by
+ * the first pass are left as NULL slots. A single pass releases the words it already
+ * wrote from the front of the table, see binary_table_release.
  */
 typedef struct
 {
-    BinaryNode** data;  /* Array of pointers to BinaryNode. */
-    size_t size;        /* Current number of elements. */
+    BinaryNode** data;  /* Array of pointers to BinaryNode, indexed by address - START_ADDRESS - released. */
+    size_t size;        /* One past the highest occupied slot. */
     size_t capacity;    /* Maximum capacity before resizing. */
+    size_t released;    /* Number of slots released from the front of the table. */
+    BinaryNode** spare; /* Released nodes, reused by the next nodes that are added. */
+    size_t spare_count;
+    size_t spare_capacity;
+    const char* source; /* The source the lines of the nodes are in, retained by the caller. */
+    size_t source_length;
+    size_t line;        /* Offset of the line new nodes are added from. */
+    Arena* arena;       /* Arena of the nodes and their labels, NULL to allocate them on the heap. */
+    FixupList fixups;   /* The words that reference labels, patched in the 2nd-Pass. */
 } BinaryTable;
 
+/**
+ * @brief Prints a single BinaryNode.
+ * @param table The BinaryTable of the node, holds the source its text is rebuilt from.
+ * @param node  The BinaryNode to print.
+ */
+void print_binary_node(const BinaryTable* table, const BinaryNode* node);
+
+/**
+ * @brief Rebuilds the text of a BinaryNode, I.E: "Integer 5" or its source line.
+ * @param table     The BinaryTable of the node.
+ * @param node      The BinaryNode.
+ * @param text      Receives the text, at least BINARY_NODE_TEXT_SIZE characters.
+ * @return The text, "NULL" when the source of the table isn't set.
+ */
+const char* binary_node_text(const BinaryTable* table, const BinaryNode* node, char* text);
+
 /**
  * @brief Creates a new BinaryTable.
- * @param initial_size Initial capacity.
+ * @param initial_size  Initial capacity.
+ * @param arena         Arena to allocate the nodes and their labels from, they are released
+ *                      with the arena. NULL allocates each of them on the heap.
  * @return Pointer to the created BinaryTable.
  */
-BinaryTable* binary_table_create(size_t initial_size);
+BinaryTable* binary_table_create(size_t initial_size, Arena* arena);
 
 /**
- * @brief Frees a BinaryTable and all associated nodes.
+ * @brief Frees a BinaryTable and all associated nodes, nodes in an arena are left to the arena.
  * @param table Pointer to the BinaryTable.
  */
 void binary_table_destroy(BinaryTable* table);
 
 /**
- * @brief Adds a new BinaryNode with address and line to the table.
+ * @brief Sets the source the lines of the nodes are in. The source is not copied,
+ * it must outlive every print of the table.
+ * @param table     Pointer to the BinaryTable.
+ * @param source    The characters of the source.
+ * @param length    The number of characters in the source.
+ */
+void binary_table_set_source(BinaryTable* table, const char* source, size_t length);
+
+/**
+ * @brief Sets the source line the following nodes are added from.
+ * @param table         Pointer to the BinaryTable.
+ * @param line_offset   The offset of the line in the source.
+ */
+void binary_table_set_line(BinaryTable* table, size_t line_offset);
+
+/**
+ * @brief Adds a new BinaryNode with address and text to the table, from the current line.
+ * The table grows as needed so that @p address has a slot of its own.
  * @param table             Pointer to the BinaryTable.
  * @param address           The address for the new node.
- * @param line              The line to associate with the node.
- * @param unresolved_label  The unresolved label to be set in 2nd-Pass
+ * @param text              The NodeTextKind of the text to associate with the node.
  */
-void binary_node_add(BinaryTable* table, unsigned int address, char* line,char* unresolved_label);
+void binary_node_add(BinaryTable* table, unsigned int address, NodeTextKind text);
 
 /**
- * @brief Sets the wordfield of a BinaryNode by its address.
+ * @brief Adds a new BinaryNode whose word references a label, and records its fix-up.
+ * Same as binary_node_add, the word is patched in the 2nd-Pass.
+ * @param table         Pointer to the BinaryTable.
+ * @param address       The address for the new node.
+ * @param text          The NodeTextKind of the text to associate with the node.
+ * @param label         The characters of the label as written in the operand, I.E: LIST or &LOOP.
+ * @param label_length  The number of characters in the label.
+ */
+void binary_node_add_label(BinaryTable* table, unsigned int address, NodeTextKind text, const char* label, size_t label_length);
+
+/**
+ * @brief Adds a new BinaryNode of a data word, whose text ends with characters of the current line.
  * @param table     Pointer to the BinaryTable.
- * @param address   The address to search for.
- * @param word      Pointer to the wordfield to set.
+ * @param address   The address for the new node.
+ * @param text      NODE_TEXT_INTEGER or NODE_TEXT_ASCII.
+ * @param start     The position of the characters in the line.
+ * @param length    The number of characters.
  */
-void set_binary_node_wordfield(BinaryTable* table, unsigned int address, wordfield* word);
+void binary_node_add_data(BinaryTable* table, unsigned int address, NodeTextKind text, int start, int length);
 
 /**
- * @brief Sets the unresolved label of a BinaryNode
- * @param table         Pointer to the BinaryTable.
- * @param address       The address to search for.
- * @param label_name    The name of the unresolved label to set.
+ * @brief Sets the wordfield of a BinaryNode by its address.
+ * @param table     Pointer to the BinaryTable.
+ * @param address   The address to search for.
+ * @param word      The wordfield to set.
  */
-void set_binary_node_unresolved_label(BinaryTable* table, unsigned int address, char* name);
+void set_binary_node_wordfield(BinaryTable* table, unsigned int address, wordfield word);
 
 /**
  * @brief Prints the contents of the entire table.
@@ -88,7 +170,15 @@ void set_binary_node_unresolved_label(BinaryTable* table, unsigned int address,
 void binary_table_print(BinaryTable* table);
 
 /**
- * @brief Searches for a BinaryNode by address.
+ * @brief Releases the nodes below @p address and their fix-ups, once their words were written.
+ * Released addresses can't be added again, the nodes are kept for reuse by the next ones.
+ * @param table     Pointer to the BinaryTable.
+ * @param address   The address of the first node that is kept.
+ */
+void binary_table_release(BinaryTable* table, unsigned int address);
+
+/**
+ * @brief Looks up a BinaryNode by address in constant time.
  * @param table     Pointer to the BinaryTable.
  * @param address   The address to find.
  * @return The index if found, otherwise -1.
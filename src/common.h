@@ -27,6 +27,7 @@ typedef enum
 
 
 #define OUTPUT_PATH "build/output_files/"
+#define ASSEMBLER_VERSION "2.0" /* part of the build cache key, changes whenever the output of a source may change */
 #define NEW_LINE '\n'
 #define DOUBLE_QUOTE '\"'
 #define COMMA ','
@@ -0,0 +1,121 @@
+#define _POSIX_C_SOURCE 200809L /* open_memstream */
+#include "context_pool.h"
+#include "common.h"
+#include "logger.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+struct ContextPool
+{
+    AsmOptions      options;        /* the options of the contexts created */
+    int             has_options;    /* zero to create the contexts with the defaults */
+    AsmCache*       cache;
+    int             copy_sources;
+    pthread_mutex_t lock;           /* guards the idle contexts */
+    AsmContext*     idle[MAX_IDLE_CONTEXTS];    /* contexts released earlier, their tables are warm */
+    int             idle_count;
+};
+
+ContextPool* context_pool_create(const AsmOptions* options, AsmCache* cache, int copy_sources)
+{
+    ContextPool* pool = malloc(sizeof(ContextPool));
+
+    if (pool == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate the context pool.\n");
+        return NULL;
+    }
+    pool->has_options = (options != NULL);
+    if (options != NULL)
+        pool->options = *options;
+    pool->cache = cache;
+    pool->copy_sources = copy_sources;
+    pool->idle_count = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    return pool;
+}
+
+void context_pool_destroy(ContextPool* pool)
+{
+    int i;
+
+    if (pool == NULL)
+        return;
+    for (i = 0; i < pool->idle_count; i++)
+        asm_context_destroy(pool->idle[i]);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+AsmContext* context_pool_take(ContextPool* pool)
+{
+    AsmContext* context = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->idle_count > 0)
+        context = pool->idle[--pool->idle_count];
+    pthread_mutex_unlock(&pool->lock);
+    if (context == NULL)
+    {
+        context = asm_context_create(pool->has_options ? &pool->options : NULL, NULL, NULL);
+        if (context != NULL)
+        {
+            asm_context_copy_sources(context, pool->copy_sources);
+            asm_context_set_cache(context, pool->cache);
+        }
+    }
+    return context;
+}
+
+void context_pool_release(ContextPool* pool, AsmContext* context)
+{
+    if (context == NULL)
+        return;
+    pthread_mutex_lock(&pool->lock);
+    if (pool->idle_count < MAX_IDLE_CONTEXTS)
+    {
+        pool->idle[pool->idle_count++] = context;
+        context = NULL;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    asm_context_destroy(context);
+}
+
+void captured_job_run(CapturedJob* job, ContextPool* pool)
+{
+    AsmContext* context;
+
+    job->out = open_memstream(&job->out_data, &job->out_size);
+    job->err = open_memstream(&job->err_data, &job->err_size);
+
+    context = context_pool_take(pool);
+    if (context != NULL)
+    {
+        asm_context_set_streams(context, job->out, job->err);
+        asm_context_assemble(context, job->name);
+        asm_context_set_streams(context, NULL, NULL);
+        context_pool_release(pool, context);
+    }
+
+    if (job->out != NULL)
+        fclose(job->out);
+    if (job->err != NULL)
+        fclose(job->err);
+}
+
+void captured_job_finish(CapturedJob* job)
+{
+    if (job->out != NULL)
+    {
+        fwrite(job->out_data, sizeof(char), job->out_size, stdout);
+        free(job->out_data);
+    }
+    if (job->err != NULL)
+    {
+        fwrite(job->err_data, sizeof(char), job->err_size, stderr);
+        free(job->err_data);
+    }
+    fflush(stdout);
+    fflush(stderr);
+}
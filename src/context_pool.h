@@ -0,0 +1,80 @@
+#ifndef CONTEXT_POOL_H
+#define CONTEXT_POOL_H
+
+#include <stdio.h>
+#include "asm_context.h"
+#include "asm_cache.h"
+
+/** @brief Number of idle contexts a pool keeps, the contexts released past it are freed. */
+#define MAX_IDLE_CONTEXTS 64
+
+/**
+ * @brief Warm assembly contexts shared by the threads of a process.
+ *
+ * A context released to the pool keeps its tables and buffers, so the next file
+ * a thread takes it for doesn't allocate them again. Taking and releasing are
+ * thread safe, a context taken is used by the taking thread only.
+ */
+typedef struct ContextPool ContextPool;
+
+/**
+ * @brief A single input file assembled by a worker thread, its output captured for the calling thread.
+ */
+typedef struct CapturedJob
+{
+    const char* name;       /* the input file, without the .as extension */
+    FILE*       out;        /* captures the output of the job, NULL when it couldn't be captured */
+    FILE*       err;        /* captures the diagnostics of the job, NULL when they couldn't be captured */
+    char*       out_data;   /* output captured by out */
+    size_t      out_size;
+    char*       err_data;   /* output captured by err */
+    size_t      err_size;
+} CapturedJob;
+
+/**
+ * @brief Creates an empty pool.
+ * @param options       The options of the contexts the pool creates, NULL for the defaults.
+ * @param cache         The build cache of the contexts (see asm_cache.h), NULL for none.
+ * @param copy_sources  Non-zero to have the contexts copy their sources (see asm_context_copy_sources).
+ * @return The pool, or NULL if it couldn't be allocated.
+ */
+ContextPool* context_pool_create(const AsmOptions* options, AsmCache* cache, int copy_sources);
+
+/**
+ * @brief Frees a pool and the contexts it keeps, every taken context must have been released.
+ * @param pool The pool, may be NULL.
+ */
+void context_pool_destroy(ContextPool* pool);
+
+/**
+ * @brief Takes an idle context, or creates one if the pool has none.
+ * @param pool The pool.
+ * @return The context, or NULL if it couldn't be allocated.
+ */
+AsmContext* context_pool_take(ContextPool* pool);
+
+/**
+ * @brief Gives a context back to the pool, it is freed if the pool is full.
+ * @param pool      The pool.
+ * @param context   The context, may be NULL.
+ */
+void context_pool_release(ContextPool* pool, AsmContext* context);
+
+/**
+ * @brief Runs on a worker thread: assembles the file of a job with a context of the pool.
+ *
+ * The output and diagnostics are captured in the job. When a stream can't be
+ * captured the job writes straight to stdout / stderr.
+ *
+ * @param job   The job, its name set and the rest zeroed.
+ * @param pool  The pool the context is taken from.
+ */
+void captured_job_run(CapturedJob* job, ContextPool* pool);
+
+/**
+ * @brief Runs on the calling thread in file order: prints and frees the output a job captured.
+ * @param job The job, after captured_job_run.
+ */
+void captured_job_finish(CapturedJob* job);
+
+#endif /* CONTEXT_POOL_H */
@@ -1,7 +1,8 @@
 #ifndef ERROR_MANAGER_H
 #define ERROR_MANAGER_H
 
-#define MAX_ERROR_LINE 150
+/** @brief File id of an error that has no file. */
+#define ERROR_NO_FILE 0xFFFF
 
 /**
  * @enum ErrorType
@@ -47,46 +48,108 @@ typedef enum
     ErrorType_ExtraneousText_Instruction,
     ErrorType_ExtraneousText_Macro,
     ErrorType_MemoryAllocationFailure,
-    ErrorType_OpenFileFailure
+    ErrorType_OpenFileFailure,
+    ErrorType_Count /* number of error types, not an error */
 } ErrorType;
 
+/**
+ * @brief A recorded error, a small fixed record without allocations of its own.
+ *
+ * The message comes from a static table when the error is printed, and the file is
+ * an id into the file names interned by the list.
+ */
 typedef struct
 {
-    char*       error_msg;  /* prints the reason of the error including FILE and LINE and recommnedation */
-    ErrorType   error_type; /* special types for various errors */
-    char*       file;       /* the file the error occurred */ 
-    int         line;       /* the line the error occurred */
+    unsigned short  error_type; /* an ErrorType, selects the message */
+    unsigned short  file;       /* id of the file the error occurred in, ERROR_NO_FILE if none */
+    int             line;       /* the line the error occurred */
 } ErrorEntry;
 
+/**
+ * @brief A growable list of error entries.
+ *
+ * The error manager keeps a default list; a job assembled on a worker thread records
+ * its errors in its own list instead (see job_context.h).
+ */
+typedef struct ErrorList
+{
+    ErrorEntry* errors;         /* The recorded entries */
+    int         count;          /* Number of recorded entries */
+    int         capacity;       /* Number of allocated entries */
+    char**      files;          /* The file names the entries refer to, by id */
+    int         files_count;    /* Number of interned file names */
+    int         files_capacity; /* Number of allocated file names */
+    int         limit;          /* Maximum number of errors recorded for a file, 0 for no limit */
+    int         file_errors;    /* Errors of the current file so far, printed ones included */
+    int         dropped;        /* Errors not recorded since the last print, the limit was reached */
+    int         limit_reported; /* Non-zero once the limit of the current file was printed */
+} ErrorList;
+
+/**
+ * @brief Initializes an empty error list.
+ * @param list The list to initialize.
+ */
+void error_list_init(ErrorList* list);
+
+/**
+ * @brief Frees every entry of an error list and the list's storage.
+ * @param list The list to destroy.
+ */
+void error_list_destroy(ErrorList* list);
+
 /**
  * @brief Adds an error entry to the internal error tracking system.
  *
- * Creates and stores an error entry with the provided type, file, and line number.
- * If the internal error array is full, logs an error to the logger system.
+ * Creates and stores an error entry with the provided type, file, and line number
+ * in the error list of the current job, or in the default list.
+ * Once the current file reached the error limit the entry is only counted.
  *
  * @param error_type  The specific type of error encountered.
- * @param file        The filename where the error occurred.
+ * @param file        The filename where the error occurred, may be NULL.
  * @param line        The line number where the error occurred.
  */
 void add_error_entry(ErrorType error_type,const char *file, int line);
 
 /**
- * @brief Clears all stored error entries and frees associated memory.
+ * @brief Sets the maximum number of errors recorded for a file, the passes stop reading it once reached.
+ *
+ * The limit belongs to the error list of the current job (or to the default list),
+ * so jobs assembled concurrently can have different limits.
+ *
+ * @param limit The maximum number of errors, 0 for no limit.
+ */
+void set_error_limit(int limit);
+
+/**
+ * @brief Starts counting the errors of a new file toward the error limit.
+ */
+void reset_error_limit();
+
+/**
+ * @brief Checks whether the current file reached the error limit.
+ *
+ * @return VALID_RETURN (0) if the limit was reached, INVALID_RETURN (-1) otherwise.
+ */
+int is_error_limit_reached();
+
+/**
+ * @brief Clears all stored error entries.
  *
- * Resets the internal error tracking array and deallocates memory
- * for all stored file paths and error messages.
+ * Resets the internal error tracking array and frees the interned file names,
+ * the errors still count toward the limit of the current file.
  */
 void clean_errors_array();
 
 /**
  * @brief Checks whether any errors have been recorded.
  *
- * @return VALID_RETURN (0) if no errors are present, INVALID_RETURN (-1) if errors exist.
+ * @return VALID_RETURN (0) if no errors are present, INVALID_RETURN (-1) if errors exist,
+ *         including ones past the error limit that were only counted.
  */
 int is_errors_array_empty();
 
 /**
- * @brief Prints all collected error messages to the standard output.
+ * @brief Prints all collected error messages to the output stream of the current job.
  *
  * Iterates over the internal error array and prints each error message
  * along with its file and line number.
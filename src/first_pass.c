@@ -4,65 +4,33 @@
 #include "logger.h"
 #include "error_manager.h"
 #include "second_pass.h"
+#include "single_pass.h"
 #include <ctype.h>
 
-void prepare_first_pass(const char* filepath, MacroTable* macro_table)
+int prepare_first_pass(const char* filepath, MacroTable* macro_table, const StringBuffer* source, Arena* arena, int single_pass)
 {
     /* 
         tables created locally - since the stack frame of this function will remain valid
         until we return/ fininshed with the first pass. 
     */
-    FILE* fp;
     LabelTable label_table;
-    InstructionTable instruction_table;
 
-    instruction_table_create(&instruction_table); 
-    instruction_table_insert(&instruction_table, "mov",  0,  0);
-    instruction_table_insert(&instruction_table, "cmp",  1,  0);
-    instruction_table_insert(&instruction_table, "add",  2,  1);
-    instruction_table_insert(&instruction_table, "sub",  2,  2);
-    instruction_table_insert(&instruction_table, "lea",  4,  0);
-    instruction_table_insert(&instruction_table, "clr",  5,  1);
-    instruction_table_insert(&instruction_table, "not",  5,  2);
-    instruction_table_insert(&instruction_table, "inc",  5,  3);
-    instruction_table_insert(&instruction_table, "dec",  5,  4);
-    instruction_table_insert(&instruction_table, "jmp",  9,  1);
-    instruction_table_insert(&instruction_table, "bne",  9,  2);
-    instruction_table_insert(&instruction_table, "jsr",  9,  3);
-    instruction_table_insert(&instruction_table, "red", 12,  0);
-    instruction_table_insert(&instruction_table, "prn", 13,  0);
-    instruction_table_insert(&instruction_table, "rts", 14,  0);
-    instruction_table_insert(&instruction_table, "stop",15,  0);
-    
-    label_table_create(&label_table);
+    label_table_create(&label_table,arena);
 
-    log_out(__FILE__,__LINE__, "firstpass: opening filename: %s\n", filepath);
-    fp = fopen(filepath, "r");
-    if(fp == NULL)
-    {
-        log_error(__FILE__,__LINE__, "Failed to open [%s] for first pass\n.", filepath);
-        add_error_entry(ErrorType_OpenFileFailure,__FILE__,__LINE__);
-        label_table_destroy(&label_table);
-        return;
-    }
-
-    if(execute_first_pass(fp,&label_table,&instruction_table, macro_table,filepath) >= 0) /* success */
+    log_out(__FILE__,__LINE__, "firstpass: reading expanded source of: %s\n", filepath);
+    if(execute_first_pass(source,&label_table,macro_table,arena,filepath,single_pass) >= 0) /* success */
     {
         log_out(__FILE__,__LINE__, "Done First-Pass for [%s]\n.", filepath);
+        return VALID_RETURN;
     }
-    else /* first pass failed */
-    {
-        log_error(__FILE__,__LINE__, "Failed First-Pass for [%s]\n.", filepath);
-    }
-    
-    if(fp)
-    {
-        fclose(fp);
-    }
+    /* first pass failed */
+    log_error(__FILE__,__LINE__, "Failed First-Pass for [%s]\n.", filepath);
+    return INVALID_RETURN;
 }   
 
 
-int execute_first_pass(FILE* fp, LabelTable* label_table, InstructionTable* instruction_table, MacroTable* macro_table, const char* filepath)
+int execute_first_pass(const StringBuffer* source, LabelTable* label_table, MacroTable* macro_table, Arena* arena, const char* filepath,
+    int single_pass)
 {
     int flag                    = 0;    /* flag is used to signal if we encounted errors while executing first pass */
     unsigned int DC             = 0;    /* data counter */
@@ -74,32 +42,44 @@ int execute_first_pass(FILE* fp, LabelTable* label_table, InstructionTable* inst
     unsigned int DCF            = -1;   /* final data counter */
     unsigned int ICF            = -1;   /* final instruction counter */
     char* line                  = string_calloc(MAX_LINE, sizeof(char)); 
-    char* word                  = string_calloc(MAX_WORD, sizeof(char));
-    BinaryTable* binary_table   = binary_table_create(5);
-
-    while(read_line(fp,line) != INVALID_RETURN)
+    BinaryTable* binary_table   = binary_table_create(5,arena);
+    size_t source_offset        = 0;    /* position of the next line in the expanded source */
+    size_t line_offset          = 0;    /* position of the current line in the expanded source */
+    int current_line            = 0;    /* line number in the expanded source */
+    SinglePass pass;                    /* the words written so far, in single pass mode */
+
+    /* the nodes refer to their lines in the expanded source instead of copying them */
+    binary_table_set_source(binary_table,source->data,source->length);
+    if(single_pass)
+        single_pass_begin(&pass,filepath);
+    /* a file that reached the error limit isn't read any further, its labels are still resolved */
+    while(is_error_limit_reached() == INVALID_RETURN &&
+        read_line_from_buffer(source->data,source->length,&source_offset,line) != INVALID_RETURN)
     {
-        static int current_line = 0;
         int position = 0;
+        Token token;
         current_line++;
+        binary_table_set_line(binary_table,line_offset);
+        line_offset = source_offset;
         if(line[0] == SEMICOLON || (is_line_empty(line) == VALID_RETURN))
         {
             /* ignore comments and empty lines */
             continue;
         }
-        while ((position = read_word_from_line(line, word, position)) != INVALID_RETURN) 
+        while ((position = next_token(line, position, &token)) != INVALID_RETURN) 
         {
-            if(is_instruction(word) != INVALID_RETURN)
+            KeywordKind kind = token_classify(&token,NULL);
+            if(kind == KEYWORD_INSTRUCTION)
             {
-                flag = handle_instruction(binary_table,instruction_table,&TC, current_line,line,word,&position,filepath);
+                flag = handle_instruction(binary_table,&TC,current_line,line,&token,&position,filepath);
             }
-            else if(is_directive(word) != INVALID_RETURN)
+            else if(kind == KEYWORD_DIRECTIVE)
             {
-                flag = handle_directive(binary_table,label_table,&TC,&DC,line,word,&position,filepath,current_line);
+                flag = handle_directive(binary_table,label_table,&TC,&DC,line,&token,&position,filepath,current_line);
             }
-            else if(is_label(word) != INVALID_RETURN)
+            else if(token_is_label(&token) != INVALID_RETURN)
             {
-                flag = handle_labels(label_table,TC,line,word,position,filepath,current_line);
+                flag = handle_labels(label_table,TC,line,&token,position,filepath,current_line);
             }      
             else
             {
@@ -110,19 +90,19 @@ int execute_first_pass(FILE* fp, LabelTable* label_table, InstructionTable* inst
             if(flag == INVALID_RETURN)
                 break;
         }
+        if(single_pass)
+            single_pass_line(&pass,binary_table,label_table,line,TC);
     }
 
     ICF = TC - START_ADDRESS - DC;
     DCF = DC;
 
-    printf("\n\n");
+    fprintf(log_output_stream(), "\n\n");
     binary_table_print(binary_table);
-    printf("\n\n");
+    fprintf(log_output_stream(), "\n\n");
     label_table_print(label_table);
-    printf("\n\n");
+    fprintf(log_output_stream(), "\n\n");
 
-    if(word)
-        free(word);
     if(line)
         free(line);
 
@@ -135,64 +115,45 @@ int execute_first_pass(FILE* fp, LabelTable* label_table, InstructionTable* inst
         print_errors_array();
         clean_errors_array();
     
+        if(single_pass)
+        {
+            single_pass_end(&pass,binary_table,label_table,ICF,DCF);
+            return INVALID_RETURN;
+        }
         log_out(__FILE__,__LINE__,"Continuing To Second-Pass: \n");
         flag = prepare_second_pass(filepath,binary_table,label_table,ICF,DCF);
         return INVALID_RETURN;
     }
 
+    if(single_pass)
+        return single_pass_end(&pass,binary_table,label_table,ICF,DCF);
+
     log_out(__FILE__,__LINE__,"Continuing To Second-Pass: \n");
     flag = prepare_second_pass(filepath,binary_table,label_table,ICF,DCF);
 
     return flag;
 }
 
-int get_operands_count(char* str)
+OperandType get_operand_type(const Token* operand)
 {
-    if(str == NULL)
+    if(operand == NULL)
     {
-        log_error(__FILE__,__LINE__,"Can't get wordfield count, str is NULL!.\n");
+        log_out(__FILE__,__LINE__,"operand is null! can't get operand type!\n");
         return INVALID_RETURN;
     }
-
-    if(is_instruction(str) != VALID_RETURN)
-    {
-        return INVALID_RETURN;
-    }
-
-    if(strcmp(str,"stop") == 0 || strcmp(str,"rts") == 0)
-    {
-        
-        return NO_OPERANDS_INSTRUCTION;
-    }
-    if(strcmp(str,"mov") == 0 || strcmp(str,"cmp") == 0 || 
-        strcmp(str,"add") == 0 || strcmp(str,"sub") == 0 || 
-        strcmp(str,"lea") == 0)
-    {
-        return TWO_OPERANDS_INSTRUCTION;
-    }
-    return ONE_OPERAND_INSTRUCTION;
-}
-
-OperandType get_operand_type(char* str)
-{
-    if(str == NULL)
-    {
-        log_out(__FILE__,__LINE__,"str is null! can't get operand type!\n");
-        return INVALID_RETURN;
-    }
-    if(str[0] == HASHTAG || isdigit(*str)) 
+    if(operand->length > 0 && (operand->text[0] == HASHTAG || isdigit((unsigned char)operand->text[0]))) 
     {
         return OPERAND_TYPE_IMMEDIATE; /* addressing mode: 0 */
     }
-    else if(str[0] == AMPERSAND)
+    else if(operand->kind == TOKEN_KIND_RELATIVE)
     {
         return OPERAND_TYPE_RELATIVE; /* addressing mode: 2*/
     }
-    else if(is_register(str) != INVALID_RETURN)
+    else if(token_is_register(operand) != INVALID_RETURN)
     {
         return OPERAND_TYPE_REGISTER; /* addressing mode: 3 */
     }
-    else if(is_label(str) != INVALID_RETURN)
+    else if(token_is_label(operand) != INVALID_RETURN)
     {
         return OPERAND_TYPE_DIRECT;
     }
@@ -200,26 +161,26 @@ OperandType get_operand_type(char* str)
     return INVALID_RETURN;
 }
 
-DirectiveType get_directive_type(char* str)
+DirectiveType get_directive_type(const Token* directive)
 {
-    if(str == NULL)
+    if(directive == NULL)
     {
-        log_out(__FILE__,__LINE__,"str is null! can't get directive type!\n");
+        log_out(__FILE__,__LINE__,"directive is null! can't get directive type!\n");
         return INVALID_RETURN;
     }
-    if(strcmp(str,".string") == 0) /* .string */
+    if(token_equals(directive,".string")) /* .string */
     {
         return DIRECTIVE_TYPE_STRING; 
     }
-    else if(strcmp(str,".data") == 0) /* .data 2*/
+    else if(token_equals(directive,".data")) /* .data 2*/
     {
         return DIRECTIVE_TYPE_DATA; 
     }
-    else if(strcmp(str,".extern") == 0) /* .extern */
+    else if(token_equals(directive,".extern")) /* .extern */
     {
         return DIRECTIVE_TYPE_EXTERN;
     }
-    else if(strcmp(str,".entry") == 0) /* .entry */
+    else if(token_equals(directive,".entry")) /* .entry */
     {
         return DIRECTIVE_TYPE_ENTRY;
     }
@@ -227,42 +188,42 @@ DirectiveType get_directive_type(char* str)
     return INVALID_RETURN;
 }
 
-wordfield* get_char_wordfield(char* character)
+wordfield get_char_wordfield(const char* character)
 {
-    wordfield* wf;
+    wordfield wf = 0;
     if(character == NULL)
     {
-        log_error(__FILE__,__LINE__,"Can't convert to ascii, character is NULL, returning NULL\n");
-        return NULL;
+        log_error(__FILE__,__LINE__,"Can't convert to ascii, character is NULL, returning an empty word\n");
+        return wf;
     }
 
-    wf = init_wordfield();
-    set_wordfield_by_num(wf,(int)*character);
+    set_wordfield_by_num(&wf,(int)*character);
     return wf;
 }
 
-int handle_labels(LabelTable* label_table, unsigned int TC, char* line, char* word,int position,
+int handle_labels(LabelTable* label_table, unsigned int TC, char* line, const Token* label,int position,
     const char* filepath, int current_line)
 {
-    char temp[MAX_LABEL_LENGTH];
-    char* label_name        = string_calloc(strlen(word)+1, sizeof(char));
+    Token next;
+    Token label_name        = *label;
+    KeywordKind next_kind;
     int flag                = 0;
-    int temp_position       = position;
     int label_index;
     
-    if(word[strlen(word) - 1] != COLON)
+    if(token_last_char(label) != COLON)
     {    
         /* 
             get the next word - if its an instruction or a directive or just a single ':'
             we are missing a ':' for the label
             otherwise we have an unrecognized token
         */
-        temp_position = read_word_from_line(line, temp, temp_position);
-        if(temp[strlen(temp) - 1] == COLON)
+        next_token(line, position, &next);
+        next_kind = token_classify(&next,NULL);
+        if(token_last_char(&next) == COLON)
         {
             add_error_entry(ErrorType_InvalidLabel_InvalidColon,filepath,current_line);
         }
-        else if(is_instruction(temp) != INVALID_RETURN || is_directive(temp) != INVALID_RETURN)
+        else if(next_kind == KEYWORD_INSTRUCTION || next_kind == KEYWORD_DIRECTIVE)
         {
             add_error_entry(ErrorType_InvalidLabel_MissingColon,filepath,current_line);
         }
@@ -270,61 +231,49 @@ int handle_labels(LabelTable* label_table, unsigned int TC, char* line, char* wo
         {
             add_error_entry(ErrorType_UnrecognizedToken,filepath,current_line);
         }
-        if(label_name != NULL)
-            free(label_name);
         return INVALID_RETURN;
     }
     
-    if(!isspace(line[temp_position+1]))
+    if(!isspace(line[position+1]))
     {
         add_error_entry(ErrorType_InvalidLabel_MissingSpace,filepath,current_line);
-        if(label_name != NULL)
-            free(label_name);
         return INVALID_RETURN;
     }
 
-    strcpy(label_name,word);
-    remove_last_character(label_name);
+    token_drop_last(&label_name); /* the ':' */
     
-    if((label_index = label_table_search(label_table,label_name)) != INVALID_RETURN)
+    if((label_index = label_table_search_n(label_table,label_name.text,label_name.length)) != INVALID_RETURN)
     {
         if(label_table->labels[label_index].type != LABELTYPE_ENTRY)
         {    
             add_error_entry(ErrorType_InvalidLabel_Redefinition,filepath,current_line);
-            if(label_name != NULL)
-                free(label_name);
             return INVALID_RETURN;
         }
         else
         {
-            label_table->labels[label_index].address = TC;
+            label_table_set_address(label_table, label_index, TC);
         }    
     }
 
-    else if(is_instruction(label_name) != INVALID_RETURN || is_directive(label_name) != INVALID_RETURN  || is_register(label_name) != INVALID_RETURN)
+    else if(token_classify(&label_name,NULL) != KEYWORD_NONE) /* an instruction, a directive or a register */
     {
         add_error_entry(ErrorType_InvalidLabel_Reserved,filepath,current_line);
-        if(label_name != NULL)
-            free(label_name);
         return INVALID_RETURN;
     }
 
-    temp_position = read_word_from_line(line, temp, temp_position);
-    if(temp_position == INVALID_RETURN)
+    if(next_token(line, position, &next) == INVALID_RETURN)
     {
         add_error_entry(ErrorType_InvalidLabel_EmptyLabel,filepath,current_line);
-        if(label_name != NULL)
-            free(label_name);
         flag = INVALID_RETURN;
     }
 
     if(flag != INVALID_RETURN && label_index == -1)
     {
         /* add the valid label to the label table and set its type as CODE */
-        label_table_add(label_table,my_strdup(label_name),TC,LABELTYPE_CODE);
+        label_table_add_n(label_table,label_name.text,label_name.length,TC,LABELTYPE_CODE);
     }
 
-    if((is_directive(temp) == VALID_RETURN) && flag != INVALID_RETURN && label_index != INVALID_RETURN)
+    if((token_is_directive(&next) == VALID_RETURN) && flag != INVALID_RETURN && label_index != INVALID_RETURN)
     {
         if(label_table->labels[label_index].type != LABELTYPE_ENTRY)
             label_table_set_label_type(label_table,TC,LABELTYPE_DATA);
@@ -332,88 +281,75 @@ int handle_labels(LabelTable* label_table, unsigned int TC, char* line, char* wo
             label_table_set_label_type(label_table,TC,LABELTYPE_DATA_ENTRY);
     }
 
-    if(label_name != NULL)
-        free(label_name);
     return flag;
 }
 
-int handle_instruction(BinaryTable* binary_table,InstructionTable* instruction_table, 
-    unsigned int* TC, unsigned int current_line, char* line, char* word, int* position,const char* filepath)
+int handle_instruction(BinaryTable* binary_table, unsigned int* TC, unsigned int current_line, char* line,
+    const Token* instruction, int* position,const char* filepath)
 {
-    int flag                = 0;
-    int operands_count      = 0;
-    wordfield* wf           = create_wordfield_by_opname(word, instruction_table);
-    set_wordfield_are(wf,ARE_ABSOLUTE);
-    operands_count          = get_operands_count(word);
-    
-    if(operands_count == INVALID_RETURN)
+    Token extra;
+    int flag                        = 0;
+    const IsaInstruction* isa       = isa_lookup(instruction->text, instruction->length);
+
+    if(isa == NULL)
     {
-        log_error(__FILE__,__LINE__, "Failed to get operands count!\n");
-        free(wf); 
-        wf = NULL;
+        /* instruction names are matched case insensitively, but only lower case names have an encoding */
+        add_error_entry(ErrorType_UnrecognizedToken,filepath,current_line);
         return INVALID_RETURN;
     }
-    else if(operands_count == NO_OPERANDS_INSTRUCTION)
+    
+    if(isa->operands == NO_OPERANDS_INSTRUCTION)
     {
-        binary_node_add(binary_table,*TC,line,NULL); /* no operands, no need for the unresolved label */
-        set_binary_node_wordfield(binary_table,*TC,wf);
-        (*TC)++;
+        add_instruction_word(binary_table,TC,instruction_template(isa,OPERAND_NONE,OPERAND_NONE));
         
         /* try to get the next word in line, if we recieve a valid position in line, extraneous text found */
-        if((*position = read_word_from_line(line, word, *position)) != INVALID_RETURN)
+        if((*position = next_token(line, *position, &extra)) != INVALID_RETURN)
         {    
             add_error_entry(ErrorType_ExtraneousText_Instruction,filepath,current_line);
-            free(wf); 
-            wf = NULL;
             return INVALID_RETURN;
         } 
     }
-    else if (operands_count == ONE_OPERAND_INSTRUCTION)
+    else if (isa->operands == ONE_OPERAND_INSTRUCTION)
     {
-        flag = handle_single_operand_instruction(binary_table,line,word,position,TC,filepath,current_line,wf);        
+        flag = handle_single_operand_instruction(binary_table,line,position,TC,filepath,current_line,isa);        
     }
     else 
     {
-        flag = handle_double_operand_instruction(binary_table,line,word,position,TC,filepath,current_line,wf);
+        flag = handle_double_operand_instruction(binary_table,line,position,TC,filepath,current_line,isa);
     } 
-
-    if(wf != NULL)
-    {
-        free(wf);
-        wf = NULL;   
-    }
     
     return flag;
 }
 
 int handle_directive(BinaryTable* binary_table, LabelTable* label_table, unsigned int* TC, unsigned int* DC,
-    char* line, char* word, int* position,const char* filepath, int current_line)
+    char* line, const Token* directive, int* position,const char* filepath, int current_line)
 {
     DirectiveType directive_type;
+    Token label;
     int flag                    = 0;
     int index;
     
     /*
         IMPORTANT: .entry is handled in the 2nd pass. 
     */
-    directive_type = get_directive_type(word);
+    directive_type = get_directive_type(directive);
     switch (directive_type)
     {
     case DIRECTIVE_TYPE_STRING:
-        flag = handle_string_directive(binary_table,TC,DC,line,word,position,filepath,current_line);
+        flag = handle_string_directive(binary_table,TC,DC,line,position,filepath,current_line);
         break;
     case DIRECTIVE_TYPE_DATA:
-        flag = handle_data_directive(binary_table,TC,DC,line,word,position,filepath,current_line);
+        flag = handle_data_directive(binary_table,TC,DC,line,position,filepath,current_line);
         break;
     case DIRECTIVE_TYPE_EXTERN:
-        flag = check_directive_label(label_table,line,word,position,filepath,current_line);
+        flag = check_directive_label(label_table,line,directive,&label,position,filepath,current_line);
         /* add the valid label to the label table and set its type as CODE */
         if(flag == VALID_RETURN)
-            label_table_add(label_table,my_strdup(word),0,LABELTYPE_EXTERN);
+            label_table_add_n(label_table,label.text,label.length,0,LABELTYPE_EXTERN);
         break;
     case DIRECTIVE_TYPE_ENTRY:
-        flag = check_directive_label(label_table,line,word,position,filepath,current_line);
-        if((index = label_table_search(label_table,word)) != INVALID_RETURN)
+        flag = check_directive_label(label_table,line,directive,&label,position,filepath,current_line);
+        if((index = label_table_search_n(label_table,label.text,label.length)) != INVALID_RETURN)
         {
             if(label_table->labels[index].type == LABELTYPE_CODE)
                 label_table->labels[index].type = LABELTYPE_CODE_ENTRY;
@@ -423,7 +359,7 @@ int handle_directive(BinaryTable* binary_table, LabelTable* label_table, unsigne
     
         if(flag == VALID_RETURN && index == INVALID_RETURN)
         {
-            label_table_add(label_table,my_strdup(word),0,LABELTYPE_ENTRY);    
+            label_table_add_n(label_table,label.text,label.length,0,LABELTYPE_ENTRY);    
         }
 
         flag = INVALID_RETURN; /* in order to 'skip' the whole line, we set it to invalid */
@@ -436,21 +372,22 @@ int handle_directive(BinaryTable* binary_table, LabelTable* label_table, unsigne
 }
 
 
-int check_immediate_value(char* value_operand, const char* filepath, int current_line)
+int check_immediate_value(const Token* value_operand, const char* filepath, int current_line)
 {
     int value;
-    if(value_operand[0] != HASHTAG) /* checks for '#' */
+    Token number = *value_operand;
+    if(number.length == 0 || number.text[0] != HASHTAG) /* checks for '#' */
     {
         add_error_entry(ErrorType_InvalidValue_MissingHashtag,filepath,current_line);
         return INVALID_RETURN;
     }    
-    remove_first_character(value_operand);
-    if(is_valid_number(value_operand) == INVALID_RETURN)
+    token_drop_first(&number);
+    if(token_is_valid_number(&number) == INVALID_RETURN)
     {
         add_error_entry(ErrorType_InvalidValue,filepath,current_line);
         return INVALID_RETURN;
     }
-    value = atoi(value_operand);
+    value = token_to_int(&number);
     if(value > MAX_24_BIT_NUMBER)
     {
         add_error_entry(ErrorType_InvalidValue_Exceeding,filepath,current_line);
@@ -459,610 +396,259 @@ int check_immediate_value(char* value_operand, const char* filepath, int current
     return value;
 }            
 
-void handle_immediate_operand(BinaryTable* binary_table,char* line, char* immediate_operand,unsigned int* TC,
-    const char* filepath, int current_line,wordfield* wf_instruction,wordfield* wf_immediate_value)
+void add_instruction_word(BinaryTable* binary_table, unsigned int* TC, wordfield word)
 {
-    int num = check_immediate_value(immediate_operand,filepath,current_line);
-    
-    if(wf_instruction != NULL)
+    binary_node_add(binary_table,*TC,NODE_TEXT_LINE);
+    set_binary_node_wordfield(binary_table,*TC,word);
+    (*TC)++;
+}
+
+void add_operand_word(BinaryTable* binary_table, const Token* operand, OperandType operand_type, int value, unsigned int* TC)
+{
+    wordfield immediate_value = 0;
+
+    switch (operand_type)
     {
-        binary_node_add(binary_table,*TC,line,NULL);
-        set_binary_node_wordfield(binary_table,*TC,wf_instruction);
+    case OPERAND_TYPE_IMMEDIATE:
+        set_wordfield_are_num(&immediate_value,value,ARE_ABSOLUTE); 
+        binary_node_add(binary_table,*TC,NODE_TEXT_IMMEDIATE);
+        set_binary_node_wordfield(binary_table,*TC,immediate_value);
         (*TC)++;
-    }
-    
-    if(wf_immediate_value != NULL)
-    {
-        set_wordfield_are_num(wf_immediate_value,num,ARE_ABSOLUTE); 
-        binary_node_add(binary_table,*TC,"Immediate value",NULL);
-        set_binary_node_wordfield(binary_table,*TC,wf_immediate_value);
+        break;
+    case OPERAND_TYPE_DIRECT:
+        binary_node_add_label(binary_table,*TC,NODE_TEXT_LABEL_ADDRESS,operand->text,operand->length);
+        set_binary_node_wordfield(binary_table,*TC,0); /* the address is set in the 2nd pass */
+        (*TC)++;
+        break;
+    case OPERAND_TYPE_RELATIVE:
+        /* 
+            NOTE: This assembler supports both direct and relative addressing.
+            If an operand is missing the '&' prefix, it will be treated as a direct addressing mode.
+            To use relative addressing, ensure that the operand begins with an '&'.
+        */
+        binary_node_add_label(binary_table,*TC,NODE_TEXT_LABEL_DISTANCE,operand->text,operand->length);
+        set_binary_node_wordfield(binary_table,*TC,0); /* the distance is set in the 2nd pass */
         (*TC)++;
+        break;
+    default:
+        /* no use for an extra wordfield for a register, it's in the instruction word */
+        break;
     }
 }
 
-
-void handle_register_operand(BinaryTable* binary_table, char* line, char* word, OperandType operand1_type,unsigned int* TC,
-    const char* filepath, int current_line,wordfield* wf_instruction)
+int get_register_number(const Token* register_operand, const char* filepath, int current_line)
 {
     int num = 0;
-    if(is_register(word) == INVALID_RETURN) /* TODO: Add an error entry if register is invalid. */
+    Token register_number = *register_operand;
+    if(token_is_register(register_operand) == INVALID_RETURN) /* TODO: Add an error entry if register is invalid. */
     {
         log_error(__FILE__,__LINE__,"Register invalid! Not Valid Register Name.\n");
-        return;
+        return INVALID_RETURN;
     }
-    remove_first_character(word);
-    num = atoi(word);
+    token_drop_first(&register_number); /* the 'r' */
+    num = token_to_int(&register_number);
     if(num > MAX_REGISTERS)
     {
         add_error_entry(ErrorType_InvalidRegister_ExceedingRegisterIndex,filepath,current_line);
-        return;
-    }
-    
-    if(operand1_type == OPERAND_TYPE_SINGLE)
-    {
-        set_wordfield_dest(wf_instruction,OPERAND_TYPE_REGISTER,num);
-        binary_node_add(binary_table,*TC,line,NULL);
-        set_binary_node_wordfield(binary_table,*TC,wf_instruction);
-        return;
-    }
-
-    if(operand1_type == OPERAND_TYPE_FIRST)
-    {
-        /* we have oeprand1_type as -1 - we are in the first operand of 2 in total */
-        set_wordfield_src(wf_instruction,OPERAND_TYPE_REGISTER,num);
-        binary_node_add(binary_table,*TC,line,NULL);
-        set_binary_node_wordfield(binary_table,*TC,wf_instruction);
-        return;
+        return INVALID_RETURN;
     }
+    return num;
+}
 
-    set_wordfield_dest(wf_instruction,OPERAND_TYPE_REGISTER,num);
-    /* first operand has an extra wordfield, the instruction wordfield is 2 addresses back */
-    if(operand1_type != OPERAND_TYPE_REGISTER && operand1_type != OPERAND_TYPE_FIRST)
-    {
-        set_binary_node_wordfield(binary_table,*TC-2,wf_instruction);
-    }
-    else 
+int get_operand_value(const Token* operand, OperandType operand_type, int* flag, const char* filepath, int current_line)
+{
+    switch (operand_type)
     {
-        /* we are in the second operand - 1st operand was not a register - has an extra wordfield */
-        set_binary_node_wordfield(binary_table,*TC-1,wf_instruction); 
+    case OPERAND_TYPE_IMMEDIATE:
+        return check_immediate_value(operand,filepath,current_line);
+    case OPERAND_TYPE_DIRECT:
+        *flag = token_is_label(operand);
+        if(*flag == INVALID_RETURN)
+        {
+            add_error_entry(ErrorType_InvalidLabel_Name,filepath,current_line);
+        }
+        return 0;
+    case OPERAND_TYPE_REGISTER:
+        return get_register_number(operand,filepath,current_line);
+    default:
+        return 0;
     }
 }
 
-int handle_single_operand_instruction(BinaryTable* binary_table,char* line, char* word,int* position, unsigned int* TC,
-    const char* filepath, int current_line,wordfield* wf_instruction)
+int handle_single_operand_instruction(BinaryTable* binary_table,char* line,int* position, unsigned int* TC,
+    const char* filepath, int current_line,const IsaInstruction* instruction)
 {
-    char* single_operand;
+    Token operand, extra;
     OperandType single_operand_type;
+    wordfield word;
+    int value;
     int flag            = 0;
-    wordfield* new_wf   = init_wordfield();
-    *position           = read_word_from_line(line, word, *position);
-    single_operand_type = get_operand_type(word);
+    *position           = next_token(line, *position, &operand);
+    single_operand_type = get_operand_type(&operand);
 
-    if(check_target_operand(wf_instruction->opcode,single_operand_type) == INVALID_RETURN)
+    /* an addressing mode the instruction doesn't accept has no template */
+    word = instruction_template(instruction,OPERAND_NONE,single_operand_type);
+    if(word == WORD_TEMPLATE_ILLEGAL)
     {
-        free(new_wf);
-        new_wf = NULL;
         add_error_entry(ErrorType_InvalidInstruction_WrongTargetOperand,filepath,current_line);
         return INVALID_RETURN;
     }
 
     if(*position == INVALID_RETURN)
     {
-        free(new_wf);
-        new_wf = NULL;
         add_error_entry(ErrorType_InvalidInstruction_MissingTargetOperand,filepath,current_line);
         return INVALID_RETURN;
     }
-    single_operand = my_strdup(word);
     /* try to get the next word in line, if we recieve a valid position in line, extraneous text found */
-    if((*position = read_word_from_line(line, word, *position)) != INVALID_RETURN)
+    if((*position = next_token(line, *position, &extra)) != INVALID_RETURN)
     {
-        free(new_wf);
-        new_wf = NULL;
-        
-        free(single_operand);
-        single_operand = NULL;
-        
         add_error_entry(ErrorType_ExtraneousText_Instruction,filepath,current_line);
         return INVALID_RETURN;
     } 
 
-    switch (single_operand_type)
-    {
-    case OPERAND_TYPE_IMMEDIATE:
-        handle_immediate_operand(binary_table,line,single_operand,TC,filepath,current_line,wf_instruction,new_wf);
-        if(new_wf != NULL)
-        {
-            free(new_wf);
-            new_wf = NULL;
-        }
-        break;
-    case OPERAND_TYPE_DIRECT:
-        flag = is_label(single_operand);
-        if(flag == INVALID_RETURN)
-        {
-            add_error_entry(ErrorType_InvalidLabel_Name,filepath,current_line);
-        }
-        set_wordfield_dest(wf_instruction,OPERAND_TYPE_DIRECT,0);
-        binary_node_add(binary_table,*TC,line,NULL);
-        set_binary_node_wordfield(binary_table,*TC,wf_instruction);
-        (*TC)++;
-        binary_node_add(binary_table,*TC,"Address of Label",single_operand);
-        set_binary_node_wordfield(binary_table,*TC,new_wf);
-        if(new_wf != NULL)
-        {
-            free(new_wf);
-            new_wf = NULL;
-        }
-        (*TC)++;
-        break;
-    case OPERAND_TYPE_RELATIVE:
-        /* 
-            NOTE: This assembler supports both direct and relative addressing.
-            If an operand is missing the '&' prefix, it will be treated as a direct addressing mode.
-            To use relative addressing, ensure that the operand begins with an '&'.
-        */
-
-        set_wordfield_dest(wf_instruction,OPERAND_TYPE_RELATIVE,0);
-        binary_node_add(binary_table,*TC,line,NULL);
-        set_binary_node_wordfield(binary_table,*TC,wf_instruction);
-        (*TC)++;
-        
-        binary_node_add(binary_table,*TC,"Distance to Label",single_operand);
-        set_binary_node_wordfield(binary_table,*TC,new_wf);
-        if(new_wf != NULL)
-        {
-            free(new_wf);
-            new_wf = NULL;
-        }
-        (*TC)++;
-        break;
-    case OPERAND_TYPE_REGISTER:
-        handle_register_operand(binary_table,line,single_operand,OPERAND_TYPE_SINGLE,TC,filepath,current_line,wf_instruction);
-        (*TC)++;
-
-        /* no use for an extra wordfield if 1st operand is a register */
-        if(new_wf)
-        {
-            free(new_wf);
-            new_wf = NULL;
-        }
-        break;
-    default:
-        break;
-    }
-
-    if(single_operand != NULL)
-    {
-        free(single_operand);
-        single_operand = NULL;
-    }
+    value = get_operand_value(&operand,single_operand_type,&flag,filepath,current_line);
+    if(single_operand_type == OPERAND_TYPE_REGISTER && value != INVALID_RETURN)
+        word |= WORD_DEST_REGISTER(value);
 
+    add_instruction_word(binary_table,TC,word);
+    add_operand_word(binary_table,&operand,single_operand_type,value,TC);
     return flag;
 }
 
-int handle_double_operand_instruction(BinaryTable* binary_table,char* line, char* word,int* position, unsigned int* TC,
-    const char* filepath, int current_line,wordfield* wf_instruction)
+int handle_double_operand_instruction(BinaryTable* binary_table,char* line,int* position, unsigned int* TC,
+    const char* filepath, int current_line,const IsaInstruction* instruction)
 {
     OperandType operand1_type, operand2_type;
-    char* operand1; /* NOTE: make sure to free when necessary! */
-    char* operand2; /* NOTE: make sure to free when necessary! */
-    wordfield* new_wf1  = NULL; 
-    wordfield* new_wf2  = NULL;
+    Token operand1, operand2, extra;
+    wordfield word;
+    int value1, value2, mode;
     int flag            = 0;
     
-
-    get_double_operands(line,word,position,filepath,current_line,&operand1,&operand2);
-    
-    if(operand1 == NULL || operand2 == NULL)
+    if(get_double_operands(line,position,filepath,current_line,&operand1,&operand2) == INVALID_RETURN)
         return INVALID_RETURN;
 
     /* try to get the next word in line, in order to find extraneous text */
-    if((*position = read_word_from_line(line, word, *position)) != INVALID_RETURN)
+    if((*position = next_token(line, *position, &extra)) != INVALID_RETURN)
     {
-        free(operand1);
-        operand1 = NULL;
-        free(operand2);
-        operand2 = NULL;
         add_error_entry(ErrorType_ExtraneousText_Instruction,filepath,current_line);
         return INVALID_RETURN;
     } 
 
-    operand1_type = get_operand_type(operand1);
-    operand2_type = get_operand_type(operand2);
+    operand1_type = get_operand_type(&operand1);
+    operand2_type = get_operand_type(&operand2);
     
-    if(check_src_operand(wf_instruction->opcode,operand1_type) == INVALID_RETURN)
-    {
-        free(operand1);
-        operand1 = NULL;
-        free(operand2);
-        operand2 = NULL;
-        add_error_entry(ErrorType_InvalidInstruction_WrongSrcOperand,filepath,current_line);
-        return INVALID_RETURN;
-    }
-    if(check_target_operand(wf_instruction->opcode,operand2_type) == INVALID_RETURN)
+    /* a combination of addressing modes the instruction doesn't accept has no template */
+    word = instruction_template(instruction,operand1_type,operand2_type);
+    if(word == WORD_TEMPLATE_ILLEGAL)
     {
-        free(operand1);
-        operand1 = NULL;
-        free(operand2);
-        operand2 = NULL;
-        add_error_entry(ErrorType_InvalidInstruction_WrongTargetOperand,filepath,current_line);
-        return INVALID_RETURN;
-    }
-
-    switch (operand1_type)
-    {
-    case OPERAND_TYPE_IMMEDIATE: 
-        set_wordfield_src(wf_instruction,OPERAND_TYPE_IMMEDIATE,0);
-        new_wf1 = init_wordfield();
-        handle_immediate_operand(binary_table,line,operand1,TC,filepath,current_line,wf_instruction,new_wf1);
-                
-        if(new_wf1 != NULL)
-        {
-            free(new_wf1);
-            new_wf1 = NULL;
-        }
-        break;
-    case OPERAND_TYPE_DIRECT:
-        flag = is_label(operand1);
-        if(flag == INVALID_RETURN)
-        {
-            add_error_entry(ErrorType_InvalidLabel_Name,filepath,current_line);
-        }        
-        set_wordfield_src(wf_instruction,OPERAND_TYPE_DIRECT,0);
-        binary_node_add(binary_table,*TC,line,NULL);
-        set_binary_node_wordfield(binary_table,*TC,wf_instruction);
-        (*TC)++;
-        new_wf1 = init_wordfield();
-        binary_node_add(binary_table,*TC,"Address of Label",operand1);
-        set_binary_node_wordfield(binary_table,*TC,new_wf1);
-        if(new_wf1 != NULL)
-        {
-            free(new_wf1);
-            new_wf1 = NULL;
-        }
-        (*TC)++;
-        break;
-    case OPERAND_TYPE_RELATIVE:
-        /* 
-        NOTE: This assembler supports both direct and relative addressing.
-        If an operand is missing the '&' prefix, it will be treated as a direct addressing mode.
-        To use relative addressing, ensure that the operand begins with an '&'.
-        */
-
-        (*TC)++;
-        /* no use for this if 1st operand is relative - processed in 2nd Pass */
-        if(new_wf1 != NULL)
-        {
-            free(new_wf1);
-            new_wf1 = NULL;
-        }
-        if(operand1 != NULL)
-        {
-            free(operand1);
-            new_wf1 = NULL;
-        }
-        break;
-    case OPERAND_TYPE_REGISTER:
-        handle_register_operand(binary_table,line, operand1,OPERAND_TYPE_FIRST,TC,filepath,current_line,wf_instruction);
-        (*TC)++;
-        /* no use for an extra wordfield if 1st operand is a register */
-        
-        if(new_wf1 != NULL)
-        {
-            free(new_wf1);
-            new_wf1 = NULL;
-        }
-        if(operand1 != NULL)
+        /* the source is at fault if no destination makes it legal */
+        for (mode = 0; mode < ADDRESSING_MODES; mode++)
         {
-            free(operand1);
-            operand1 = NULL;
+            if(instruction_template(instruction,operand1_type,mode) != WORD_TEMPLATE_ILLEGAL)
+                break;
         }
-        break;
-    default:
-        break;
+        if(mode == ADDRESSING_MODES)
+            add_error_entry(ErrorType_InvalidInstruction_WrongSrcOperand,filepath,current_line);
+        else
+            add_error_entry(ErrorType_InvalidInstruction_WrongTargetOperand,filepath,current_line);
+        return INVALID_RETURN;
     }
 
-    
-    switch (operand2_type)
-    {
-    case OPERAND_TYPE_IMMEDIATE: /* only in the special case of an immediate value if the instruction is 'cmp' */
-        new_wf2 = init_wordfield();
-        handle_immediate_operand(binary_table,line,operand2,TC,filepath,current_line,NULL,new_wf2);
-        
-        if(new_wf2 != NULL)
-        {
-            free(new_wf2);
-            new_wf2 = NULL;
-        }
-        break;
-    case OPERAND_TYPE_DIRECT:
-        flag = is_label(operand2);
-        if(flag == INVALID_RETURN)
-        {
-            add_error_entry(ErrorType_InvalidLabel_Name,filepath,current_line);
-        }
-        set_wordfield_dest(wf_instruction,OPERAND_TYPE_DIRECT,0);
-        if(operand1_type == OPERAND_TYPE_IMMEDIATE || operand1_type == OPERAND_TYPE_REGISTER || operand1_type == OPERAND_TYPE_RELATIVE)
-        {
-            set_binary_node_wordfield(binary_table,*TC-1,wf_instruction);
-        }
-        else if(operand1_type == OPERAND_TYPE_DIRECT)
-        {
-            set_binary_node_wordfield(binary_table,*TC-2,wf_instruction);
-        }
+    value1 = get_operand_value(&operand1,operand1_type,&flag,filepath,current_line);
+    value2 = get_operand_value(&operand2,operand2_type,&flag,filepath,current_line);
+    if(operand1_type == OPERAND_TYPE_REGISTER && value1 != INVALID_RETURN)
+        word |= WORD_SRC_REGISTER(value1);
+    if(operand2_type == OPERAND_TYPE_REGISTER && value2 != INVALID_RETURN)
+        word |= WORD_DEST_REGISTER(value2);
 
-        new_wf2 = init_wordfield();
-        binary_node_add(binary_table,*TC,"Address of Label",operand2);
-        set_binary_node_wordfield(binary_table,*TC,new_wf2);
-        if(new_wf2 != NULL)
-        {
-            free(new_wf2);
-            new_wf2 = NULL;
-        }
-        (*TC)++;
-        break;
-    case OPERAND_TYPE_RELATIVE:
-        /* 
-            NOTE: This assembler supports both direct and relative addressing.
-            If an operand is missing the '&' prefix, it will be treated as a direct addressing mode.
-            To use relative addressing, ensure that the operand begins with an '&'.
-        */
-        (*TC)++;
-        /* no use for this if 2nd operand if its relative - processed in 2nd Pass */
-        if(new_wf2 != NULL)
-        {
-            free(new_wf2);
-            new_wf2 = NULL;
-        }
-        if(operand2 != NULL)
-        {
-            free(operand2);
-            operand2 = NULL;
-        }
-        break;
-    case OPERAND_TYPE_REGISTER:
-        handle_register_operand(binary_table,line,operand2,operand1_type,TC,filepath,current_line,wf_instruction);
-        /* no use for this if 2nd operand is a register */
-        if(new_wf2 != NULL)
-        {
-            free(new_wf2);
-            new_wf2 = NULL;
-        }
-        if(operand2 != NULL)
-        {
-            free(operand2);
-            operand2 = NULL;
-        }
-        break;
-    default:
-        break;
-    }
-
-    if(new_wf1 != NULL)
-    {
-        free(new_wf1);
-        new_wf1 = NULL;
-    }
-    if(operand1 != NULL)
-    {
-        free(operand1);
-        operand1 = NULL;
-    }
-    if(new_wf2 != NULL)
-    {
-        free(new_wf2);
-        new_wf2 = NULL;
-    }
-    if(operand2 != NULL)
-    {
-        free(operand2);
-        operand2 = NULL;
-    }
+    /* the instruction word, then the extra word of each operand that has one */
+    add_instruction_word(binary_table,TC,word);
+    add_operand_word(binary_table,&operand1,operand1_type,value1,TC);
+    add_operand_word(binary_table,&operand2,operand2_type,value2,TC);
     return flag;
 }
 
-void get_double_operands(char* line, char* word, int* position, const char* filepath, int current_line,
-    char** operand1, char** operand2)
+int get_double_operands(char* line, int* position, const char* filepath, int current_line,
+    Token* operand1, Token* operand2)
 {
-    *position = read_word_from_line(line, word, *position); /* get operand1 */
-    if(word[strlen(word)-1] == COMMA) /* if last character of src operand is a comma remove it */
+    Token token;
+    *position = next_token(line, *position, &token); /* get operand1 */
+    if(token_last_char(&token) == COMMA) /* if last character of src operand is a comma drop it */
     {
-        remove_last_character(word);  
-        *operand1 = my_strdup(word);
-        *position = read_word_from_line(line, word, *position);
+        *operand1 = token;
+        token_drop_last(operand1);
+        *position = next_token(line, *position, &token);
         if(*position == INVALID_RETURN) 
         {
             add_error_entry(ErrorType_InvalidInstruction_MissingTargetOperand,filepath,current_line);
-            if(*operand1 != NULL)
-            {
-                free(*operand1);
-                *operand1 = NULL;
-            }
-            return;
+            return INVALID_RETURN;
         }
-        *operand2 = my_strdup(word);
+        *operand2 = token;
     } 
     else /* otherwise check for comma to see if missing */
     {
-        *operand1 = my_strdup(word);
-        *position = read_word_from_line(line, word, *position);
-        if(COMMA != word[0])
+        *operand1 = token;
+        *position = next_token(line, *position, &token);
+        if(token.kind != TOKEN_KIND_COMMA || token.length == 0)
         {
             add_error_entry(ErrorType_InvalidInstruction_MissingComma,filepath,current_line);      
-            if(*operand1 != NULL)
-            {
-                free(*operand1);
-                *operand1 = NULL;
-            }
-            return;
+            return INVALID_RETURN;
         }
-        if(word[0] == NULL_TERMINATOR || strlen(word) == 1) 
+        if(token.length == 1) /* a lone ',' - the operand is the next word */
         {
-            *position = read_word_from_line(line, word, *position);
+            *position = next_token(line, *position, &token);
         }    
-        else if(word[0] == COMMA)
-            remove_first_character(word);
-        *operand2 = my_strdup(word);
+        else
+            token_drop_first(&token);
+        *operand2 = token;
     }  
-}
-
-/**
- * @brief Table defining valid addressing modes for source operands based on opcode.
- *
- * This array specifies allowed addressing modes for source operands for each opcode (0-15).
- * Each entry corresponds to an opcode and includes flags (1 or 0) for each addressing mode:
- * { IMMEDIATE, DIRECT, RELATIVE, REGISTER }
- *
- * Unused opcodes must be explicitly initialized to zeros.
- */
-static int valid_src[MAX_INSTRUCTIONS][ADDRESSING_MODES] = 
-{
-    /* 
-        NOTE: 
-        some entried are unused but most be defined.
-        the order is as in the mmn's table of valid addressing modes:
-        { IMMEDIATE, DIRECT, RELATIVE, REGISTER }     
-    */
-
-    { 1, 1, 0, 1 }, /* opcode 0: mov */    
-    { 1, 1, 0, 1 }, /* opcode 1: cmp */
-    { 1, 1, 0, 1 }, /* opcode 2: add/sub */
-    { 0, 0, 0, 0 }, /* opcode 3 (UNUSED) */
-    { 0, 1, 0, 0 }, /* opcode 4: lea */
-    { 0, 0, 0, 0 }, /* opcode 5: clr/not/inc/dec */
-    { 0, 0, 0, 0 }, /* opcode 6 (UNUSED) */
-    { 0, 0, 0, 0 }, /* opcode 7 (UNUSED) */
-    { 0, 0, 0, 0 }, /* opcode 8 (UNUSED) */
-    { 0, 0, 0, 0 }, /* opcode 9: jmp/bne/jsr */
-    { 0, 0, 0, 0 }, /* opcode 10 (UNUSED) */
-    { 0, 0, 0, 0 }, /* opcode 11 (UNUSED) */
-    { 0, 0, 0, 0 }, /* opcode 12: red */
-    { 0, 0, 0, 0 }, /* opcode 13: prn */
-    { 0, 0, 0, 0 }, /* opcode 14: rts */
-    { 0, 0, 0, 0 }, /* opcode 15: stop */
-};
-
-/**
- * @brief Table defining valid addressing modes for destination operands based on opcode.
- *
- * This array specifies allowed addressing modes for destination operands for each opcode (0-15).
- * Each entry corresponds to an opcode and includes flags (1 or 0) for each addressing mode:
- * { IMMEDIATE, DIRECT, RELATIVE, REGISTER }
- *
- * Unused opcodes must be explicitly initialized to zeros.
- */
-static int valid_dest[MAX_INSTRUCTIONS][ADDRESSING_MODES] =
-{
-    /* 
-        NOTE: 
-        some entried are unused but most be defined.
-        the order is as in the mmn's table of valid addressing modes:
-        { IMMEDIATE, DIRECT, RELATIVE, REGISTER }     
-    */
-
-    { 0, 1, 0, 1 }, /* opcode 0: mov */
-    { 1, 1, 0, 1 }, /* opcode 1: cmp */
-    { 0, 1, 0, 1 }, /* opcode 2: add/sub */
-    { 0, 0, 0, 0 }, /* opcode 3 (UNUSED) */
-    { 0, 1, 0, 1 }, /* opcode 4: lea */
-    { 0, 1, 0, 1 }, /* opcode 5: clr/not/inc/dec */
-    { 0, 0, 0, 0 }, /* opcode 6 (UNUSED) */
-    { 0, 0, 0, 0 }, /* opcode 7 (UNUSED) */
-    { 0, 0, 0, 0 }, /* opcode 8 (UNUSED) */
-    { 0, 1, 1, 0 }, /* opcode 9: jmp/bne/jsr */
-    { 0, 0, 0, 0 }, /* opcode 10 (UNUSED) */
-    { 0, 0, 0, 0 }, /* opcode 11 (UNUSED) */
-    { 0, 1, 0, 1 }, /* opcode 12: red */
-    { 1, 1, 0, 1 }, /* opcode 13: prn */
-    { 0, 0, 0, 0 }, /* opcode 14: rts */
-    { 0, 0, 0, 0 }  /* opcode 15: stop */
-
-};
-
-int check_src_operand(int opcode, OperandType operand_type) 
-{
-    int flag = -1;
-    if (opcode < 0 || opcode > 15) 
-        return INVALID_RETURN;
-    if (operand_type < 0 || operand_type > 3) 
-        return INVALID_RETURN;
-
-    flag = valid_src[opcode][operand_type];
-    if(flag == 1)
-        return VALID_RETURN;
-    
-    return INVALID_RETURN;
-}
-
-int check_target_operand(int opcode, OperandType operand_type) 
-{
-    int flag = -1;
-    if (opcode < 0 || opcode > 15) 
-        return INVALID_RETURN;
-    if (operand_type < 0 || operand_type > 3) 
-        return INVALID_RETURN;
-
-    flag = valid_dest[opcode][operand_type];
-    if(flag == 1)
-        return VALID_RETURN;
-    
-    return INVALID_RETURN;
+    return VALID_RETURN;
 }
 
 int handle_data_directive(BinaryTable* binary_table,unsigned int* TC, unsigned int* DC, char* line, 
-    char* word, int* position,const char* filepath, int current_line)
+    int* position,const char* filepath, int current_line)
 {
-    char last_num_str[MAX_WORD] = "Integer "; 
-    wordfield* last_wf          = init_wordfield(); 
+    Token number;
+    wordfield last_wf           = 0; 
     int numbers_count           = 0;
 
-    while ((*position = read_word_from_line(line, word, *position)) != INVALID_RETURN && word[strlen(word)-1] == COMMA)
+    while ((*position = next_token(line, *position, &number)) != INVALID_RETURN && token_last_char(&number) == COMMA)
     {
-        char final_str[MAX_WORD] = "Integer ";
-        wordfield num_wf = {0};
-        remove_last_character(word);
-        set_wordfield_by_num(&num_wf,(unsigned int)atoi(word));
+        wordfield num_wf = 0;
+        token_drop_last(&number);
+        set_wordfield_by_num(&num_wf,(unsigned int)token_to_int(&number));
         if(numbers_count == 0)
         {
-            binary_node_add(binary_table,*TC,line, NULL);
-            set_binary_node_wordfield(binary_table,*TC,&num_wf);
+            binary_node_add(binary_table,*TC,NODE_TEXT_LINE);
+            set_binary_node_wordfield(binary_table,*TC,num_wf);
             numbers_count++;
             (*TC)++;
             continue;
         }
         
-        strcat(final_str, word);
-        binary_node_add(binary_table,*TC, final_str, NULL);
-        set_binary_node_wordfield(binary_table,*TC,&num_wf);
+        binary_node_add_data(binary_table,*TC,NODE_TEXT_INTEGER,(int)(number.text - line),number.length);
+        set_binary_node_wordfield(binary_table,*TC,num_wf);
         (*TC)++;
         numbers_count++;
     }
     if(*position == -1)
     {
-        if(last_wf)
-            free(last_wf);
         add_error_entry(ErrorType_InvalidDirective_Empty,filepath,current_line);
         return INVALID_RETURN;
     }
     if(numbers_count == 0) /* single number I.E: .data 100 */
     {
-        set_wordfield_by_num(last_wf,(unsigned int)atoi(word));
-        binary_node_add(binary_table,*TC,line, NULL);
+        set_wordfield_by_num(&last_wf,(unsigned int)token_to_int(&number));
+        binary_node_add(binary_table,*TC,NODE_TEXT_LINE);
         set_binary_node_wordfield(binary_table,*TC,last_wf);
-        if(last_wf)
-            free(last_wf);
         (*TC)++;
         numbers_count++; 
         *DC += numbers_count;
         return VALID_RETURN;
     }
-    set_wordfield_by_num(last_wf,(unsigned int)atoi(word));
-    strcat(last_num_str, word);
-    binary_node_add(binary_table,*TC, last_num_str, NULL);
+    set_wordfield_by_num(&last_wf,(unsigned int)token_to_int(&number));
+    binary_node_add_data(binary_table,*TC,NODE_TEXT_INTEGER,(int)(number.text - line),number.length);
     set_binary_node_wordfield(binary_table,*TC,last_wf);
-    if(last_wf)
-        free(last_wf);
     (*TC)++;
     numbers_count++; 
     /* NOTE: numbers count should be valid here */
@@ -1072,26 +658,20 @@ int handle_data_directive(BinaryTable* binary_table,unsigned int* TC, unsigned i
 }
 
 int handle_string_directive(BinaryTable* binary_table, unsigned int* TC, unsigned int* DC, char* line, 
-    char* word, int* position,const char* filepath, int current_line)
+    int* position,const char* filepath, int current_line)
 {
+    Token string;
     int i               = 0; 
     int str_length      = -1;
     int char_count      = 0;
-    wordfield* last_wf  = init_wordfield(); 
 
-    *position = read_word_from_line(line, word, *position);
-    str_length = strlen(word);
-    if((*position == -1 || word[0] != DOUBLE_QUOTE || word[str_length] != DOUBLE_QUOTE) && 
-        (word[0] != DOUBLE_QUOTE && word[str_length] != DOUBLE_QUOTE))
+    *position = next_token(line, *position, &string);
+    if(string.kind != TOKEN_KIND_STRING)
     {
-        if(last_wf)
-            free(last_wf);
         add_error_entry(ErrorType_InvalidDirective_MissingQuotes,filepath,current_line);
         return INVALID_RETURN;
     }
-    remove_first_character(word);
-    remove_last_character(word);
-    str_length -= 2; /* not including 2 double quotes */
+    str_length = string.length - 2; /* not including 2 double quotes */
 
     /* 
         NOTE:
@@ -1102,50 +682,34 @@ int handle_string_directive(BinaryTable* binary_table, unsigned int* TC, unsigne
     
     for( ; i < str_length; i++)
     {
-        wordfield* tmp;
-        wordfield char_wf = {0};
-        char character[2];
-        char ascii_str[MAX_WORD] = "Ascii code ";
-        strncpy(character,&word[i],1);
-        tmp = get_char_wordfield(character);
-        if (tmp != NULL) 
-        {
-            char_wf = *tmp; 
-            free(tmp);       
-        }
+        const char* character = &string.text[i + 1]; /* skip the opening '"' */
+        wordfield char_wf = get_char_wordfield(character);
         
         if(char_count == 0)
         {
-            binary_node_add(binary_table,*TC,line, NULL);
-            set_binary_node_wordfield(binary_table,*TC,&char_wf);
+            binary_node_add(binary_table,*TC,NODE_TEXT_LINE);
+            set_binary_node_wordfield(binary_table,*TC,char_wf);
             (*TC)++;
             char_count++;
             continue;
         }
-        strncat(ascii_str, character,1);
-        binary_node_add(binary_table,*TC,ascii_str, NULL);
-        set_binary_node_wordfield(binary_table,*TC,&char_wf);
+        binary_node_add_data(binary_table,*TC,NODE_TEXT_ASCII,(int)(character - line),1);
+        set_binary_node_wordfield(binary_table,*TC,char_wf);
         (*TC)++;
         char_count++;
     }
-    binary_node_add(binary_table,*TC,"Ascii code \'\\0\'", NULL);
-    set_binary_node_wordfield(binary_table,*TC,last_wf);
-    if(last_wf)
-        free(last_wf);
+    binary_node_add(binary_table,*TC,NODE_TEXT_ASCII_END);
+    set_binary_node_wordfield(binary_table,*TC,0);
     (*TC)++;
 
     return VALID_RETURN;
 }
 
-int check_directive_label(LabelTable* label_table,char* line, char* word, int* position,
+int check_directive_label(LabelTable* label_table,char* line, const Token* directive, Token* label, int* position,
     const char* filepath, int current_line)
 {
-    char directive_name[MAX_WORD];
-    strcpy(directive_name,word);
-
-    *position = read_word_from_line(line, word, *position);
-    is_label(word);        
-    if(label_table_search(label_table,word) != INVALID_RETURN && strcmp(directive_name,".entry") != VALID_RETURN)
+    *position = next_token(line, *position, label);
+    if(label_table_search_n(label_table,label->text,label->length) != INVALID_RETURN && !token_equals(directive,".entry"))
     {
         add_error_entry(ErrorType_InvalidLabel_Redefinition,filepath,current_line);
         return INVALID_RETURN;
@@ -1156,4 +720,4 @@ int check_directive_label(LabelTable* label_table,char* line, char* word, int* p
         return INVALID_RETURN;
     }
     return VALID_RETURN;
-}
\ No newline at end of file
+}
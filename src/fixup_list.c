@@ -0,0 +1,197 @@
+#include "fixup_list.h"
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "logger.h"
+#include "utility.h"
+
+#define SYMBOL_SLOT_EMPTY -1
+
+/* Returns the name slot holding the 'length' characters of 'name', or the empty slot where it would go */
+static int* symbol_slot_find(const FixupList* list, const char* name, size_t length)
+{
+    size_t mask = list->slot_count - 1;
+    size_t i = hash_string_n(name, length) & mask;
+
+    while (list->symbol_slots[i] != SYMBOL_SLOT_EMPTY)
+    {
+        const char* symbol_name = list->symbols[list->symbol_slots[i]].name;
+        if (strncmp(symbol_name, name, length) == 0 && symbol_name[length] == NULL_TERMINATOR)
+            return &list->symbol_slots[i];
+        i = (i + 1) & mask;
+    }
+    return &list->symbol_slots[i];
+}
+
+/* Doubles the name index and re-inserts every symbol, the index is kept at most half full */
+static int symbol_index_grow(FixupList* list)
+{
+    size_t i;
+    size_t slot_count = list->slot_count ? list->slot_count * 2 : DEFAULT_FIXUP_LIST_SIZE;
+    int* slots = malloc(slot_count * sizeof(int));
+
+    if (slots == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate memory for the fix-up symbols index!\n");
+        return INVALID_RETURN;
+    }
+    for (i = 0; i < slot_count; i++)
+        slots[i] = SYMBOL_SLOT_EMPTY;
+
+    free(list->symbol_slots);
+    list->symbol_slots  = slots;
+    list->slot_count    = slot_count;
+    for (i = 0; i < list->symbol_count; i++)
+    {
+        const char* name = list->symbols[i].name;
+        *symbol_slot_find(list, name, strlen(name)) = (int)i;
+    }
+    return VALID_RETURN;
+}
+
+/* Returns the index of the symbol named by 'length' characters of 'name', adding it if it's new */
+static int symbol_intern(FixupList* list, const char* name, size_t length)
+{
+    int* slot;
+    char* copy;
+
+    if ((list->symbol_count + 1) * 2 > list->slot_count && symbol_index_grow(list) == INVALID_RETURN)
+        return INVALID_RETURN;
+
+    slot = symbol_slot_find(list, name, length);
+    if (*slot != SYMBOL_SLOT_EMPTY)
+        return *slot;
+
+    if (list->symbol_count == list->symbol_capacity)
+    {
+        size_t capacity = list->symbol_capacity ? list->symbol_capacity * 2 : DEFAULT_FIXUP_LIST_SIZE;
+        FixupSymbol* symbols = realloc(list->symbols, capacity * sizeof(FixupSymbol));
+        if (symbols == NULL)
+        {
+            log_error(__FILE__,__LINE__,"Failed to allocate memory for the fix-up symbols!\n");
+            return INVALID_RETURN;
+        }
+        list->symbols = symbols;
+        list->symbol_capacity = capacity;
+    }
+
+    copy = (list->arena != NULL) ? arena_strndup(list->arena, name, length) : my_strndup(name, length);
+    if (copy == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate memory for a fix-up symbol!\n");
+        return INVALID_RETURN;
+    }
+    list->symbols[list->symbol_count].name  = copy;
+    list->symbols[list->symbol_count].label = FIXUP_SYMBOL_UNRESOLVED;
+    list->symbols[list->symbol_count].pending = 0;
+    *slot = (int)list->symbol_count;
+    return (int)list->symbol_count++;
+}
+
+void fixup_list_init(FixupList* list, Arena* arena)
+{
+    list->data              = NULL;
+    list->count             = 0;
+    list->capacity          = 0;
+    list->symbols           = NULL;
+    list->symbol_count      = 0;
+    list->symbol_capacity   = 0;
+    list->symbol_slots      = NULL;
+    list->slot_count        = 0;
+    list->arena             = arena;
+}
+
+void fixup_list_destroy(FixupList* list)
+{
+    size_t i;
+
+    /* names in an arena are released with the arena */
+    for (i = 0; i < list->symbol_count && list->arena == NULL; i++)
+        free(list->symbols[i].name);
+
+    free(list->data);
+    free(list->symbols);
+    free(list->symbol_slots);
+    fixup_list_init(list, list->arena);
+}
+
+int fixup_list_add(FixupList* list, unsigned int address, const char* label, size_t length)
+{
+    size_t i;
+    int symbol;
+    FixupKind kind = FIXUP_DIRECT;
+
+    if (length > 0 && label[0] == AMPERSAND)
+    {
+        kind = FIXUP_RELATIVE;
+        label++;
+        length--;
+    }
+    if ((symbol = symbol_intern(list, label, length)) == INVALID_RETURN)
+        return INVALID_RETURN;
+
+    if (list->count == list->capacity)
+    {
+        size_t capacity = list->capacity ? list->capacity * 2 : DEFAULT_FIXUP_LIST_SIZE;
+        Fixup* data = realloc(list->data, capacity * sizeof(Fixup));
+        if (data == NULL)
+        {
+            log_error(__FILE__,__LINE__,"Failed to allocate memory for the fix-up list!\n");
+            return INVALID_RETURN;
+        }
+        list->data = data;
+        list->capacity = capacity;
+    }
+
+    /* words are emitted in address order, so this only shifts when a word is added out of order */
+    for (i = list->count; i > 0 && list->data[i - 1].address > address; i--)
+        list->data[i] = list->data[i - 1];
+
+    list->data[i].address       = address;
+    list->data[i].symbol        = (unsigned int)symbol;
+    list->data[i].next_pending  = 0;
+    list->data[i].kind          = (unsigned char)kind;
+    list->data[i].resolved      = 0;
+    list->count++;
+    return VALID_RETURN;
+}
+
+/* Returns the position of the first fix-up at or above 'address' */
+static size_t fixup_lower_bound(const FixupList* list, unsigned int address)
+{
+    size_t low = 0;
+    size_t high = list->count;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (list->data[middle].address < address)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+Fixup* fixup_list_find(const FixupList* list, unsigned int address)
+{
+    size_t i = fixup_lower_bound(list, address);
+    return (i < list->count && list->data[i].address == address) ? &list->data[i] : NULL;
+}
+
+int fixup_list_find_symbol(const FixupList* list, const char* name, size_t length)
+{
+    if (list->slot_count == 0)
+        return INVALID_RETURN;
+    return *symbol_slot_find(list, name, length);
+}
+
+void fixup_list_release(FixupList* list, unsigned int address)
+{
+    size_t released = fixup_lower_bound(list, address);
+
+    if (released == 0)
+        return;
+    memmove(list->data, list->data + released, (list->count - released) * sizeof(Fixup));
+    list->count -= released;
+}
@@ -0,0 +1,115 @@
+#ifndef FIXUP_LIST_H
+#define FIXUP_LIST_H
+
+#include <stddef.h>
+#include "arena.h"
+
+/** @brief Default capacity for a FixupList. */
+#define DEFAULT_FIXUP_LIST_SIZE 16
+
+/** @brief Value of FixupSymbol.label until the second pass looks the symbol up. */
+#define FIXUP_SYMBOL_UNRESOLVED -2
+
+/**
+ * @brief How a fix-up patches its word.
+ */
+typedef enum
+{
+    FIXUP_DIRECT,   /* the address of the label, I.E: mov LIST, r1 */
+    FIXUP_RELATIVE, /* the distance to the label, I.E: jmp &LOOP */
+    FIXUP_EXTERNAL  /* a direct fix-up that resolved to an external label, written to the .ext file */
+} FixupKind;
+
+/**
+ * @brief A word that is patched once its label is known.
+ */
+typedef struct Fixup
+{
+    unsigned int address;       /* Address of the word to patch. */
+    unsigned int symbol;        /* Index of the referenced label in FixupList.symbols. */
+    unsigned int next_pending;  /* The next word waiting for the same label in a single pass, see SinglePass.pending. */
+    unsigned char kind;         /* FixupKind of the word. */
+    unsigned char resolved;     /* Non-zero once the word was patched. */
+} Fixup;
+
+/**
+ * @brief A label referenced by fix-ups, every name is stored once however many words reference it.
+ */
+typedef struct FixupSymbol
+{
+    char* name;             /* The label name, without the '&' of a relative reference. */
+    int label;              /* Index of the label in the label table, cached once it is found. */
+    unsigned int pending;   /* The first word waiting for the label in a single pass, see SinglePass.pending. */
+} FixupSymbol;
+
+/**
+ * @brief The words of a file that reference labels, kept in address order.
+ *
+ * The first pass records a fix-up for every label operand it emits, so the second
+ * pass patches those words only instead of checking every word of the file.
+ */
+typedef struct FixupList
+{
+    Fixup* data;            /* The fix-ups, sorted by address. */
+    size_t count;           /* Number of fix-ups. */
+    size_t capacity;        /* Allocated capacity of data. */
+    FixupSymbol* symbols;   /* The referenced labels, indexed by Fixup.symbol. */
+    size_t symbol_count;    /* Number of symbols. */
+    size_t symbol_capacity; /* Allocated capacity of symbols. */
+    int* symbol_slots;      /* Name index of the symbols, holds symbol indexes or -1. */
+    size_t slot_count;      /* Number of slots in the name index (a power of 2). */
+    Arena* arena;           /* Arena of the symbol names, NULL to allocate them on the heap. */
+} FixupList;
+
+/**
+ * @brief Initializes an empty FixupList.
+ * @param list  Pointer to the FixupList.
+ * @param arena Arena to copy the symbol names into, NULL copies them on the heap.
+ */
+void fixup_list_init(FixupList* list, Arena* arena);
+
+/**
+ * @brief Frees the memory owned by a FixupList, names in an arena are left to the arena.
+ * @param list Pointer to the FixupList.
+ */
+void fixup_list_destroy(FixupList* list);
+
+/**
+ * @brief Records a fix-up of the word at @p address.
+ *
+ * A label that starts with '&' is a relative reference, as the operand is written
+ * in the source, I.E: &LOOP. Any other label is a direct reference.
+ *
+ * @param list      Pointer to the FixupList.
+ * @param address   The address of the word to patch.
+ * @param label     The characters of the label, don't need to be null terminated.
+ * @param length    The number of characters in the label.
+ * @return VALID_RETURN on success, INVALID_RETURN if the allocation failed.
+ */
+int fixup_list_add(FixupList* list, unsigned int address, const char* label, size_t length);
+
+/**
+ * @brief Returns the fix-up of the word at @p address.
+ * @param list      Pointer to the FixupList.
+ * @param address   The address of the word.
+ * @return The fix-up, or NULL if the word has none.
+ */
+Fixup* fixup_list_find(const FixupList* list, unsigned int address);
+
+/**
+ * @brief Returns the symbol of a label, if any word references it.
+ * @param list      Pointer to the FixupList.
+ * @param name      The characters of the label name.
+ * @param length    The number of characters in the name.
+ * @return The index of the symbol, or INVALID_RETURN if no word references the label.
+ */
+int fixup_list_find_symbol(const FixupList* list, const char* name, size_t length);
+
+/**
+ * @brief Drops the fix-ups of the words below @p address, once those words were written.
+ * @param list      Pointer to the FixupList.
+ * @param address   The address of the first word that is kept.
+ */
+void fixup_list_release(FixupList* list, unsigned int address);
+
+#endif /* FIXUP_LIST_H */
@@ -0,0 +1,177 @@
+#include "hex_encoder.h"
+#include "common.h"
+#include <string.h>
+
+/* The SIMD encoders are built for x86 with GCC or Clang, they are picked at runtime by the CPU features */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEX_ENCODER_X86
+#include <immintrin.h>
+#endif
+
+/* Number of words the hex digits are produced for at once */
+#define HEX_BLOCK_WORDS 32
+/* Number of bytes in a 24-bit word */
+#define WORD_BYTES 3
+/* Number of digits of an address */
+#define ADDRESS_DIGITS 7
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/* Writes the two hex digits of every byte of 'bytes' */
+static void hex_bytes_scalar(const unsigned char* bytes, size_t length, char* hex)
+{
+    size_t i;
+    for (i = 0; i < length; i++)
+    {
+        hex[2 * i]      = hex_digits[bytes[i] >> 4];
+        hex[2 * i + 1]  = hex_digits[bytes[i] & 0xF];
+    }
+}
+
+#ifdef HEX_ENCODER_X86
+
+/* The hex digits of 16 nibbles, one per byte: '0' + n, plus the gap to 'a' for n above 9 */
+__attribute__((target("sse2")))
+static __m128i nibbles_to_ascii_sse2(__m128i nibbles)
+{
+    const __m128i nine          = _mm_set1_epi8(9);
+    const __m128i zero_char     = _mm_set1_epi8('0');
+    const __m128i letter_gap    = _mm_set1_epi8('a' - '0' - 10);
+    __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, nine), letter_gap);
+    return _mm_add_epi8(_mm_add_epi8(nibbles, zero_char), letters);
+}
+
+__attribute__((target("sse2")))
+static void hex_bytes_sse2(const unsigned char* bytes, size_t length, char* hex)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    size_t i;
+
+    for (i = 0; i + 16 <= length; i += 16)
+    {
+        __m128i x   = _mm_loadu_si128((const __m128i*)(bytes + i));
+        __m128i hi  = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+        __m128i lo  = _mm_and_si128(x, mask);
+        /* interleaving the high and low nibbles puts the digits of every byte in order */
+        _mm_storeu_si128((__m128i*)(hex + 2 * i), nibbles_to_ascii_sse2(_mm_unpacklo_epi8(hi, lo)));
+        _mm_storeu_si128((__m128i*)(hex + 2 * i + 16), nibbles_to_ascii_sse2(_mm_unpackhi_epi8(hi, lo)));
+    }
+    hex_bytes_scalar(bytes + i, length - i, hex + 2 * i);
+}
+
+__attribute__((target("avx2")))
+static void hex_bytes_avx2(const unsigned char* bytes, size_t length, char* hex)
+{
+    const __m256i mask  = _mm256_set1_epi8(0x0F);
+    const __m256i table = _mm256_setr_epi8('0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f',
+                                           '0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f');
+    size_t i;
+
+    for (i = 0; i + 32 <= length; i += 32)
+    {
+        __m256i x   = _mm256_loadu_si256((const __m256i*)(bytes + i));
+        __m256i hi  = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(x, 4), mask));
+        __m256i lo  = _mm256_shuffle_epi8(table, _mm256_and_si256(x, mask));
+        /* unpacking works within each 128-bit lane: a = bytes 0-7 | 16-23, b = bytes 8-15 | 24-31 */
+        __m256i a   = _mm256_unpacklo_epi8(hi, lo);
+        __m256i b   = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i*)(hex + 2 * i), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i*)(hex + 2 * i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    hex_bytes_sse2(bytes + i, length - i, hex + 2 * i);
+}
+
+#endif /* HEX_ENCODER_X86 */
+
+int hex_encoder_supported(HexEncoderKind kind)
+{
+    switch (kind)
+    {
+    case HEX_ENCODER_SCALAR:
+        return VALID_RETURN;
+#ifdef HEX_ENCODER_X86
+    case HEX_ENCODER_SSE2:
+        return __builtin_cpu_supports("sse2") ? VALID_RETURN : INVALID_RETURN;
+    case HEX_ENCODER_AVX2:
+        return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse2")) ? VALID_RETURN : INVALID_RETURN;
+#endif
+    default:
+        return INVALID_RETURN;
+    }
+}
+
+HexEncoderKind hex_encoder_best()
+{
+    if (hex_encoder_supported(HEX_ENCODER_AVX2) == VALID_RETURN)
+        return HEX_ENCODER_AVX2;
+    if (hex_encoder_supported(HEX_ENCODER_SSE2) == VALID_RETURN)
+        return HEX_ENCODER_SSE2;
+    return HEX_ENCODER_SCALAR;
+}
+
+/* Writes the hex digits of 'length' bytes with the encoder 'kind' */
+static void hex_bytes(HexEncoderKind kind, const unsigned char* bytes, size_t length, char* hex)
+{
+#ifdef HEX_ENCODER_X86
+    if (kind == HEX_ENCODER_AVX2)
+    {
+        hex_bytes_avx2(bytes, length, hex);
+        return;
+    }
+    if (kind == HEX_ENCODER_SSE2)
+    {
+        hex_bytes_sse2(bytes, length, hex);
+        return;
+    }
+#endif
+    (void)kind;
+    hex_bytes_scalar(bytes, length, hex);
+}
+
+size_t hex_encode_word_lines_with(HexEncoderKind kind, char* out, unsigned int address, const wordfield* words, size_t count)
+{
+    unsigned char bytes[HEX_BLOCK_WORDS * WORD_BYTES];
+    char hex[HEX_BLOCK_WORDS * WORD_BYTES * 2];
+    char digits[ADDRESS_DIGITS];
+    size_t block, i;
+    int digit;
+
+    for (digit = ADDRESS_DIGITS - 1; digit >= 0; digit--, address /= 10)
+        digits[digit] = (char)('0' + address % 10);
+
+    for (block = 0; block < count; block += HEX_BLOCK_WORDS)
+    {
+        size_t block_count = (count - block < HEX_BLOCK_WORDS) ? count - block : HEX_BLOCK_WORDS;
+
+        /* the bytes of a word from the most significant one, so their hex digits are in "%06x" order */
+        for (i = 0; i < block_count; i++)
+        {
+            wordfield word = words[block + i] & MASK_WORD;
+            bytes[WORD_BYTES * i]       = (unsigned char)(word >> 16);
+            bytes[WORD_BYTES * i + 1]   = (unsigned char)(word >> 8);
+            bytes[WORD_BYTES * i + 2]   = (unsigned char)word;
+        }
+        hex_bytes(kind, bytes, block_count * WORD_BYTES, hex);
+
+        for (i = 0; i < block_count; i++)
+        {
+            memcpy(out, digits, ADDRESS_DIGITS);
+            out[ADDRESS_DIGITS] = ' ';
+            memcpy(out + ADDRESS_DIGITS + 1, hex + WORD_BYTES * 2 * i, WORD_BYTES * 2);
+            out[HEX_WORD_LINE_LENGTH - 1] = NEW_LINE;
+            out += HEX_WORD_LINE_LENGTH;
+
+            /* the next address is one more, counted up in its decimal digits */
+            for (digit = ADDRESS_DIGITS - 1; digit >= 0 && digits[digit] == '9'; digit--)
+                digits[digit] = '0';
+            if (digit >= 0)
+                digits[digit]++;
+        }
+    }
+    return count * HEX_WORD_LINE_LENGTH;
+}
+
+size_t hex_encode_word_lines(char* out, unsigned int address, const wordfield* words, size_t count)
+{
+    return hex_encode_word_lines_with(hex_encoder_best(), out, address, words, count);
+}
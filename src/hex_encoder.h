@@ -0,0 +1,62 @@
+#ifndef HEX_ENCODER_H
+#define HEX_ENCODER_H
+
+#include <stddef.h>
+#include "wordfield.h"
+
+/** @brief Number of characters in a word line of the .ob file, I.E: "0000100 0a0c04\n". */
+#define HEX_WORD_LINE_LENGTH 15
+
+/** @brief Addresses below this are written with exactly 7 digits, as "%.7d" does. */
+#define HEX_ENCODER_ADDRESS_LIMIT 10000000
+
+/**
+ * @brief The implementations of the word line encoder.
+ */
+typedef enum
+{
+    HEX_ENCODER_SCALAR, /* a hex digit table, one nibble at a time */
+    HEX_ENCODER_SSE2,   /* 16 bytes of words at a time, x86 baseline */
+    HEX_ENCODER_AVX2,   /* 32 bytes of words at a time, when the CPU supports it */
+    HEX_ENCODER_COUNT
+} HexEncoderKind;
+
+/**
+ * @brief Checks if an encoder can run on this build and CPU.
+ * @param kind The encoder.
+ * @return VALID_RETURN if it can, INVALID_RETURN otherwise.
+ */
+int hex_encoder_supported(HexEncoderKind kind);
+
+/**
+ * @brief Returns the fastest encoder the CPU supports, detected at runtime.
+ * @return The encoder used by hex_encode_word_lines.
+ */
+HexEncoderKind hex_encoder_best();
+
+/**
+ * @brief Writes the .ob lines of consecutive words, as "%.7d %06x\n" per word.
+ *
+ * The addresses are counted up in decimal characters, and the hex digits of the
+ * words are produced in blocks by the best encoder the CPU supports.
+ *
+ * @param out       Receives count * HEX_WORD_LINE_LENGTH characters, not null terminated.
+ * @param address   The address of the first word, address + count must be at most HEX_ENCODER_ADDRESS_LIMIT.
+ * @param words     The words.
+ * @param count     The number of words.
+ * @return The number of characters written.
+ */
+size_t hex_encode_word_lines(char* out, unsigned int address, const wordfield* words, size_t count);
+
+/**
+ * @brief Same as hex_encode_word_lines, with a given encoder.
+ * @param kind      The encoder, must be supported (see hex_encoder_supported).
+ * @param out       Receives count * HEX_WORD_LINE_LENGTH characters, not null terminated.
+ * @param address   The address of the first word, address + count must be at most HEX_ENCODER_ADDRESS_LIMIT.
+ * @param words     The words.
+ * @param count     The number of words.
+ * @return The number of characters written.
+ */
+size_t hex_encode_word_lines_with(HexEncoderKind kind, char* out, unsigned int address, const wordfield* words, size_t count);
+
+#endif /* HEX_ENCODER_H */
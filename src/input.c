@@ -92,3 +92,49 @@ int read_line(FILE* fp, char *line)
 
     return VALID_RETURN;
 }
+
+int read_line_from_buffer(const char* buffer, size_t length, size_t* offset, char* line)
+{
+    LineView view;
+
+    /* no characters left, same as reaching EOF in read_line */
+    if (next_line_view(buffer, length, offset, &view) == INVALID_RETURN)
+    {
+        line[0] = '\0';
+        return INVALID_RETURN;
+    }
+
+    line_view_copy(&view, line);
+    return VALID_RETURN;
+}
+
+int next_line_view(const char* buffer, size_t length, size_t* offset, LineView* view)
+{
+    size_t pos = *offset;
+    const char* new_line;
+
+    if (pos >= length)
+        return INVALID_RETURN;
+
+    view->data  = buffer + pos;
+    new_line    = memchr(view->data, NEW_LINE, length - pos);
+    if (new_line != NULL)
+    {
+        view->length = new_line - view->data;
+        *offset = pos + view->length + 1; /* skip the new line itself */
+    }
+    else
+    {
+        view->length = length - pos;
+        *offset = length;
+    }
+    return VALID_RETURN;
+}
+
+void line_view_copy(const LineView* view, char* line)
+{
+    /* the rest of a long line is discarded, as in read_line */
+    size_t length = (view->length < MAX_LINE - 1) ? view->length : MAX_LINE - 1;
+    memcpy(line, view->data, length);
+    line[length] = '\0';
+}
@@ -2,6 +2,16 @@
 #define INPUT_H
 #include <stdio.h>
 
+/**
+ * @brief A view of a single line inside a larger buffer, without its new line.
+ * The characters are not copied and are not null terminated.
+ */
+typedef struct LineView
+{
+    const char* data;   /* first character of the line */
+    size_t      length; /* number of characters in the line, the new line excluded */
+} LineView;
+
 /**
  * @brief reads words from a file one by one
  * @param fp    the file to read from
@@ -28,6 +38,34 @@ int read_word_from_line(const char* line, char* word, int start_pos);
  */
 int read_line(FILE* fp, char* line);
 
+/**
+ * @brief reads lines from a memory buffer one line at a time, exactly like read_line does from a file
+ * @param buffer    the buffer to read from
+ * @param length    the number of characters in the buffer
+ * @param offset    the position to read from, advanced past the line that was read
+ * @param line      contains the lines as we read them one line at a time 
+ * @return VALID_RETURN on success or INVALID_RETURN when reaching the end of the buffer.
+ */
+int read_line_from_buffer(const char* buffer, size_t length, size_t* offset, char* line);
+
+/**
+ * @brief Finds the next line in a memory buffer without copying it
+ * @param buffer    the buffer to read from
+ * @param length    the number of characters in the buffer
+ * @param offset    the position to read from, advanced past the line that was found
+ * @param view      receives the line, of any length
+ * @return VALID_RETURN on success or INVALID_RETURN when reaching the end of the buffer.
+ */
+int next_line_view(const char* buffer, size_t length, size_t* offset, LineView* view);
+
+/**
+ * @brief Copies a line view into a line buffer, discarding what doesn't fit in MAX_LINE
+ *        exactly like read_line does
+ * @param view  the line to copy
+ * @param line  receives the line, must hold MAX_LINE characters
+ */
+void line_view_copy(const LineView* view, char* line);
+
 
 
 #endif
\ No newline at end of file
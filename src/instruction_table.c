@@ -5,6 +5,7 @@
 #include "common.h"
 #include "utility.h"
 #include "logger.h"
+#include "isa.h"
 
 /* Print a single instruction node */
 void instruction_node_print(InstructionNode* node)
@@ -45,28 +46,20 @@ void instruction_table_destroy(InstructionTable* table)
 
 int instruction_table_insert(InstructionTable* table, const char* op_name, unsigned int op_code, unsigned int funct)
 {
-    size_t index;
+    int index;
 
     if (!table || !op_name || op_name[0] == NULL_TERMINATOR)
         return INVALID_RETURN;
 
-    
+    /* only the instructions of the ISA have a slot */
     index = get_instruction_index(op_name);
+    if (index == INVALID_RETURN)
+        return INVALID_RETURN;
 
     if (table->instructions[index].op_name[0] == NULL_TERMINATOR)
     {
-        if(strcmp(op_name,"stop") == 0)
-        {
-            strncpy(table->instructions[index].op_name, op_name, MAX_OP_NAME);
-            table->instructions[index].op_name[MAX_OP_NAME] = NULL_TERMINATOR; /* ensure null-termination */
-        }   
-        else
-        {
-            strncpy(table->instructions[index].op_name, op_name, MAX_OP_NAME - 1);
-            table->instructions[index].op_name[MAX_OP_NAME - 1] = NULL_TERMINATOR; /* ensure null-termination */
-        }
-
-        
+        /* an empty slot is all zeros, so the name stays null terminated */
+        strncpy(table->instructions[index].op_name, op_name, MAX_OP_NAME);
         table->instructions[index].op_code = op_code;
         table->instructions[index].funct   = funct;
         return VALID_RETURN;
@@ -78,15 +71,25 @@ int instruction_table_insert(InstructionTable* table, const char* op_name, unsig
 /* Retrieve an instruction by name */
 InstructionNode* instruction_table_get(InstructionTable* table, const char* op_name)
 {
-    size_t          index;
+    if (!op_name)
+        return NULL;
 
-    if (!table || !op_name || op_name[0] == NULL_TERMINATOR)
+    return instruction_table_get_n(table, op_name, strlen(op_name));
+}
+
+InstructionNode* instruction_table_get_n(InstructionTable* table, const char* op_name, size_t length)
+{
+    int index;
+
+    if (!table || !op_name || length == 0 || length > MAX_OP_NAME)
         return NULL;
 
-    index     = get_instruction_index(op_name);
+    index = get_instruction_index_n(op_name, length);
+    if (index == INVALID_RETURN)
+        return NULL;
 
     /* Check if the slot has the same op_name */
-    if (strncmp(table->instructions[index].op_name, op_name, MAX_OP_NAME) == 0)
+    if (strncmp(table->instructions[index].op_name, op_name, length) == 0)
     {
         return &table->instructions[index];
     }
@@ -97,12 +100,14 @@ InstructionNode* instruction_table_get(InstructionTable* table, const char* op_n
 
 void instruction_table_remove(InstructionTable* table, const char* op_name)
 {
-    size_t          index;
+    int index;
 
     if (!table || !op_name || op_name[0] == NULL_TERMINATOR)
         return;
 
-    index     = get_instruction_index(op_name);
+    index = get_instruction_index(op_name);
+    if (index == INVALID_RETURN)
+        return;
 
     if (strcmp(table->instructions[index].op_name, op_name) == 0)
     {
@@ -129,74 +134,82 @@ void instruction_table_print(InstructionTable* table)
 
 int get_instruction_index(const char *s)
 {
+    return get_instruction_index_n(s, strlen(s));
+}
+
+int get_instruction_index_n(const char *s, size_t length)
+{
+    if (length != 3 && length != 4)
+        return INVALID_RETURN;
+
     switch (s[0])
     {
         case 'a':  /* add */
-            if (s[1]=='d' && s[2]=='d' && s[3]==NULL_TERMINATOR)
-                return 2;  /* "add" */
+            if (s[1]=='d' && s[2]=='d' && length==3)
+                return ISA_ADD; /* "add" */
             break;
 
         case 'b':  /* bne */
-            if (s[1]=='n' && s[2]=='e' && s[3]==NULL_TERMINATOR)
-                return 10; /* "bne" */
+            if (s[1]=='n' && s[2]=='e' && length==3)
+                return ISA_BNE; /* "bne" */
             break;
 
         case 'c':  /* cmp, clr */
-            if (s[1]=='m' && s[2]=='p' && s[3]==NULL_TERMINATOR)
-                return 1;  /* "cmp" */
-            if (s[1]=='l' && s[2]=='r' && s[3]==NULL_TERMINATOR)
-                return 5;  /* "clr" */
+            if (s[1]=='m' && s[2]=='p' && length==3)
+                return ISA_CMP; /* "cmp" */
+            if (s[1]=='l' && s[2]=='r' && length==3)
+                return ISA_CLR; /* "clr" */
             break;
 
         case 'd':  /* dec */
-            if (s[1]=='e' && s[2]=='c' && s[3]==NULL_TERMINATOR)
-                return 8;  /* "dec" */
+            if (s[1]=='e' && s[2]=='c' && length==3)
+                return ISA_DEC; /* "dec" */
             break;
 
         case 'i':  /* inc */
-            if (s[1]=='n' && s[2]=='c' && s[3]==NULL_TERMINATOR)
-                return 7;  /* "inc" */
+            if (s[1]=='n' && s[2]=='c' && length==3)
+                return ISA_INC; /* "inc" */
             break;
 
         case 'j':  /* jmp, jsr */
-            if (s[1]=='m' && s[2]=='p' && s[3]==NULL_TERMINATOR)
-                return 9;  /* "jmp" */
-            if (s[1]=='s' && s[2]=='r' && s[3]==NULL_TERMINATOR)
-                return 11; /* "jsr" */
+            if (s[1]=='m' && s[2]=='p' && length==3)
+                return ISA_JMP; /* "jmp" */
+            if (s[1]=='s' && s[2]=='r' && length==3)
+                return ISA_JSR; /* "jsr" */
             break;
 
         case 'l':  /* lea */
-            if (s[1]=='e' && s[2]=='a' && s[3]==NULL_TERMINATOR)
-                return 4;  /* "lea" */
+            if (s[1]=='e' && s[2]=='a' && length==3)
+                return ISA_LEA; /* "lea" */
             break;
 
         case 'm':  /* mov */
-            if (s[1]=='o' && s[2]=='v' && s[3]==NULL_TERMINATOR)
-                return 0;  /* "mov" */
+            if (s[1]=='o' && s[2]=='v' && length==3)
+                return ISA_MOV; /* "mov" */
             break;
 
         case 'n':  /* not */
-            if (s[1]=='o' && s[2]=='t' && s[3]==NULL_TERMINATOR)
-                return 6;  /* "not" */
+            if (s[1]=='o' && s[2]=='t' && length==3)
+                return ISA_NOT; /* "not" */
             break;
 
         case 'p':  /* prn */
-            if (s[1]=='r' && s[2]=='n' && s[3]==NULL_TERMINATOR)
-                return 13; /* "prn" */
+            if (s[1]=='r' && s[2]=='n' && length==3)
+                return ISA_PRN; /* "prn" */
             break;
 
         case 'r':  /* red, rts */
-            if (s[1]=='e' && s[2]=='d' && s[3]==NULL_TERMINATOR)
-                return 12; /* "red" */
-            if (s[1]=='t' && s[2]=='s' && s[3]==NULL_TERMINATOR)
-                return 14; /* "rts" */
+            if (s[1]=='e' && s[2]=='d' && length==3)
+                return ISA_RED; /* "red" */
+            if (s[1]=='t' && s[2]=='s' && length==3)
+                return ISA_RTS; /* "rts" */
             break;
 
         case 's':  /* sub, stop */
-            if (s[1]=='u' && s[2]=='b' && s[3]==NULL_TERMINATOR)
-                return 3;  /* "sub" */
-            if (s[1]=='t' && s[2]=='o' && s[3]=='p' && s[4]==NULL_TERMINATOR)
-                return 15; /* "stop" */
+            if (s[1]=='u' && s[2]=='b' && length==3)
+                return ISA_SUB; /* "sub" */
+            if (length==4 && s[1]=='t' && s[2]=='o' && s[3]=='p')
+                return ISA_STOP;/* "stop" */
             break;
     }
 
@@ -15,7 +15,7 @@
  */
 typedef struct InstructionNode 
 {
-   char            op_name[MAX_OP_NAME]; /* Operation name (e.g., "ADD"). */
+   char            op_name[MAX_OP_NAME + 1]; /* Operation name (e.g., "ADD"), null terminated. */
    unsigned int    op_code;              /* Primary opcode. */
    unsigned int    funct;                /* Secondary code. */
 } InstructionNode;
@@ -64,6 +64,15 @@ int instruction_table_insert(InstructionTable* table, const char* op_name, unsig
  */
 InstructionNode* instruction_table_get(InstructionTable* table, const char* op_name);
 
+/**
+ * @brief Retrieves an instruction by a name that is not null terminated, I.E: a token of a line.
+ * @param table     Pointer to the InstructionTable.
+ * @param op_name   The characters of the operation name.
+ * @param length    The number of characters in the name.
+ * @return Pointer to the found InstructionNode, or NULL if not found.
+ */
+InstructionNode* instruction_table_get_n(InstructionTable* table, const char* op_name, size_t length);
+
 /**
  * @brief Removes an instruction by name.
  * @param table     Pointer to the InstructionTable.
@@ -80,8 +89,18 @@ void instruction_table_print(InstructionTable* table);
 /**
  * @brief Returns the index of an instruction in the instruction table by name.
  * @param op_name A C-string representing the instruction name to search for.
- * @return An integer index if found, or INVALID_RETURN if the instruction name is not recognized.
+ * @return The index of the instruction in isa_instructions (an IsaIndex) if found, or INVALID_RETURN
+ *         if the instruction name is not recognized.
  */
 int get_instruction_index(const char* op_name);
 
+/**
+ * @brief Returns the index of an instruction by a name that is not null terminated.
+ * @param op_name   The characters of the instruction name.
+ * @param length    The number of characters in the name.
+ * @return The index of the instruction in isa_instructions (an IsaIndex) if found, or INVALID_RETURN
+ *         if the instruction name is not recognized.
+ */
+int get_instruction_index_n(const char* op_name, size_t length);
+
 #endif /* INSTRUCTION_TABLE_H */
@@ -0,0 +1,19 @@
+#include "isa.h"
+#include "instruction_table.h"
+
+#define ISA_ENTRY(id, name, opcode, funct, operands, src_modes, dest_modes) \
+    { name, opcode, funct, operands, src_modes, dest_modes },
+
+const IsaInstruction isa_instructions[ISA_INSTRUCTION_COUNT] =
+{
+    ISA_INSTRUCTIONS(ISA_ENTRY)
+};
+
+/* the instruction set must fill the opcode space the rest of the assembler is sized for */
+typedef char isa_count_check[(ISA_INSTRUCTION_COUNT == MAX_INSTRUCTIONS) ? 1 : -1];
+
+const IsaInstruction* isa_lookup(const char* name, size_t length)
+{
+    int index = get_instruction_index_n(name, length);
+    return (index == INVALID_RETURN) ? NULL : &isa_instructions[index];
+}
@@ -0,0 +1,72 @@
+#ifndef ISA_H
+#define ISA_H
+
+#include <stddef.h>
+#include "common.h"
+
+/** @brief Bit of an addressing mode in the addressing modes masks of the ISA. */
+#define ISA_MODE(operand_type) (1u << (operand_type))
+
+#define MODE_NONE       0u
+#define MODE_IMMEDIATE  ISA_MODE(OPERAND_TYPE_IMMEDIATE)
+#define MODE_DIRECT     ISA_MODE(OPERAND_TYPE_DIRECT)
+#define MODE_RELATIVE   ISA_MODE(OPERAND_TYPE_RELATIVE)
+#define MODE_REGISTER   ISA_MODE(OPERAND_TYPE_REGISTER)
+
+/**
+ * @brief The instruction set, the single description every instruction lookup is built from.
+ *
+ * Each X(id, name, opcode, funct, operands, src_modes, dest_modes) entry describes one instruction,
+ * in the order of get_instruction_index. The addressing modes are as in the mmn's table of valid
+ * addressing modes.
+ */
+#define ISA_INSTRUCTIONS(X) \
+    X(MOV,  "mov",   0, 0, TWO_OPERANDS_INSTRUCTION, MODE_IMMEDIATE | MODE_DIRECT | MODE_REGISTER, MODE_DIRECT | MODE_REGISTER) \
+    X(CMP,  "cmp",   1, 0, TWO_OPERANDS_INSTRUCTION, MODE_IMMEDIATE | MODE_DIRECT | MODE_REGISTER, MODE_IMMEDIATE | MODE_DIRECT | MODE_REGISTER) \
+    X(ADD,  "add",   2, 1, TWO_OPERANDS_INSTRUCTION, MODE_IMMEDIATE | MODE_DIRECT | MODE_REGISTER, MODE_DIRECT | MODE_REGISTER) \
+    X(SUB,  "sub",   2, 2, TWO_OPERANDS_INSTRUCTION, MODE_IMMEDIATE | MODE_DIRECT | MODE_REGISTER, MODE_DIRECT | MODE_REGISTER) \
+    X(LEA,  "lea",   4, 0, TWO_OPERANDS_INSTRUCTION, MODE_DIRECT,                                  MODE_DIRECT | MODE_REGISTER) \
+    X(CLR,  "clr",   5, 1, ONE_OPERAND_INSTRUCTION,  MODE_NONE,                                    MODE_DIRECT | MODE_REGISTER) \
+    X(NOT,  "not",   5, 2, ONE_OPERAND_INSTRUCTION,  MODE_NONE,                                    MODE_DIRECT | MODE_REGISTER) \
+    X(INC,  "inc",   5, 3, ONE_OPERAND_INSTRUCTION,  MODE_NONE,                                    MODE_DIRECT | MODE_REGISTER) \
+    X(DEC,  "dec",   5, 4, ONE_OPERAND_INSTRUCTION,  MODE_NONE,                                    MODE_DIRECT | MODE_REGISTER) \
+    X(JMP,  "jmp",   9, 1, ONE_OPERAND_INSTRUCTION,  MODE_NONE,                                    MODE_DIRECT | MODE_RELATIVE) \
+    X(BNE,  "bne",   9, 2, ONE_OPERAND_INSTRUCTION,  MODE_NONE,                                    MODE_DIRECT | MODE_RELATIVE) \
+    X(JSR,  "jsr",   9, 3, ONE_OPERAND_INSTRUCTION,  MODE_NONE,                                    MODE_DIRECT | MODE_RELATIVE) \
+    X(RED,  "red",  12, 0, ONE_OPERAND_INSTRUCTION,  MODE_NONE,                                    MODE_DIRECT | MODE_REGISTER) \
+    X(PRN,  "prn",  13, 0, ONE_OPERAND_INSTRUCTION,  MODE_NONE,                                    MODE_IMMEDIATE | MODE_DIRECT | MODE_REGISTER) \
+    X(RTS,  "rts",  14, 0, NO_OPERANDS_INSTRUCTION,  MODE_NONE,                                    MODE_NONE) \
+    X(STOP, "stop", 15, 0, NO_OPERANDS_INSTRUCTION,  MODE_NONE,                                    MODE_NONE)
+
+#define ISA_INDEX(id, name, opcode, funct, operands, src_modes, dest_modes) ISA_##id,
+
+/** @brief Index of every instruction in isa_instructions, I.E: ISA_MOV. */
+typedef enum
+{
+    ISA_INSTRUCTIONS(ISA_INDEX)
+    ISA_INSTRUCTION_COUNT
+} IsaIndex;
+
+/** @brief Description of a single instruction. */
+typedef struct IsaInstruction
+{
+    const char*     name;       /* instruction name, I.E: "mov" */
+    unsigned int    opcode;     /* primary opcode */
+    unsigned int    funct;      /* secondary code */
+    int             operands;   /* number of operands (0, 1, or 2) */
+    unsigned int    src_modes;  /* mask of the valid addressing modes of the source operand */
+    unsigned int    dest_modes; /* mask of the valid addressing modes of the destination operand */
+} IsaInstruction;
+
+/** @brief The instruction set, indexed by IsaIndex. */
+extern const IsaInstruction isa_instructions[ISA_INSTRUCTION_COUNT];
+
+/**
+ * @brief Looks up an instruction by its name, case sensitive (I.E: "mov" but not "MOV").
+ * @param name      The characters of the name, not necessarily null terminated.
+ * @param length    The number of characters in the name.
+ * @return The instruction, or NULL if the name is not an instruction.
+ */
+const IsaInstruction* isa_lookup(const char* name, size_t length);
+
+#endif /* ISA_H */
@@ -0,0 +1,23 @@
+#define _POSIX_C_SOURCE 200112L
+#include "job_context.h"
+#include <pthread.h>
+
+static pthread_key_t context_key;
+static pthread_once_t context_key_once = PTHREAD_ONCE_INIT;
+
+static void create_context_key()
+{
+    pthread_key_create(&context_key, NULL);
+}
+
+void job_context_bind(JobContext* context)
+{
+    pthread_once(&context_key_once, create_context_key);
+    pthread_setspecific(context_key, context);
+}
+
+JobContext* job_context_current()
+{
+    pthread_once(&context_key_once, create_context_key);
+    return (JobContext*)pthread_getspecific(context_key);
+}
@@ -0,0 +1,38 @@
+#ifndef JOB_CONTEXT_H
+#define JOB_CONTEXT_H
+
+#include <stdio.h>
+
+struct ErrorList;
+struct OutputSink;
+
+/**
+ * @brief Per-job state that would otherwise be process-wide.
+ *
+ * When files are assembled concurrently every worker thread binds the context of
+ * the job it runs. The logger then writes to the job's own streams and the error
+ * manager records errors in the job's own list, so jobs never share output or
+ * errors. A NULL field falls back to the process-wide default (stdout, stderr,
+ * the error manager's default list, or the files in build/output_files/).
+ */
+typedef struct JobContext
+{
+    FILE* out;                  /* Stream for informational output, NULL for stdout. */
+    FILE* err;                  /* Stream for error output, NULL for stderr. */
+    struct ErrorList* errors;   /* Error list of the job, NULL for the default list. */
+    const struct OutputSink* sink; /* Receives the output files of the job, NULL to write them to files. */
+} JobContext;
+
+/**
+ * @brief Binds a context to the calling thread.
+ * @param context The context to bind, or NULL to unbind.
+ */
+void job_context_bind(JobContext* context);
+
+/**
+ * @brief Returns the context bound to the calling thread.
+ * @return The bound context, or NULL if none is bound.
+ */
+JobContext* job_context_current();
+
+#endif /* JOB_CONTEXT_H */
@@ -0,0 +1,96 @@
+#include "keyword.h"
+#include "instruction_table.h"
+#include "isa.h"
+
+#include <ctype.h>
+#include <string.h>
+
+static int match_register(const char* s, size_t length, Keyword* keyword)
+{
+    if (length != 2 || s[0] != 'r' || s[1] < '0' || s[1] >= '0' + MAX_REGISTERS)
+        return 0;
+
+    keyword->kind   = KEYWORD_REGISTER;
+    keyword->reg    = s[1] - '0';
+    return 1;
+}
+
+static int match_instruction(const char* s, size_t length, Keyword* keyword)
+{
+    char name[MAX_OP_NAME];
+    size_t i;
+    int index;
+
+    if (length > MAX_OP_NAME)
+        return 0;
+
+    /* instruction names are case insensitive, lower the word on the stack */
+    for (i = 0; i < length; i++)
+        name[i] = (char)tolower((unsigned char)s[i]);
+
+    if ((index = get_instruction_index_n(name, length)) == INVALID_RETURN)
+        return 0;
+
+    keyword->kind   = KEYWORD_INSTRUCTION;
+    keyword->index  = index;
+    keyword->opcode = isa_instructions[index].opcode;
+    keyword->funct  = isa_instructions[index].funct;
+    return 1;
+}
+
+static int match_directive(const char* s, size_t length, Keyword* keyword)
+{
+    size_t dotted       = (s[0] == '.');
+    const char* name    = s + dotted;
+    DirectiveType type;
+
+    switch (length - dotted)
+    {
+    case 4:
+        if (memcmp(name, "data", 4) != 0)
+            return 0;
+        type = DIRECTIVE_TYPE_DATA;
+        break;
+    case 5:
+        if (memcmp(name, "entry", 5) != 0)
+            return 0;
+        type = DIRECTIVE_TYPE_ENTRY;
+        break;
+    case 6:
+        if (memcmp(name, "string", 6) == 0)
+            type = DIRECTIVE_TYPE_STRING;
+        else if (memcmp(name, "extern", 6) == 0)
+            type = DIRECTIVE_TYPE_EXTERN;
+        else
+            return 0;
+        break;
+    default:
+        return 0;
+    }
+
+    keyword->kind       = KEYWORD_DIRECTIVE;
+    keyword->directive  = dotted ? type : (DirectiveType)INVALID_RETURN;
+    return 1;
+}
+
+KeywordKind classify_keyword(const char* text, size_t length, Keyword* keyword)
+{
+    Keyword found;
+
+    found.kind      = KEYWORD_NONE;
+    found.index     = INVALID_RETURN;
+    found.opcode    = 0;
+    found.funct     = 0;
+    found.directive = (DirectiveType)INVALID_RETURN;
+    found.reg       = INVALID_RETURN;
+
+    if (text != NULL && length > 0)
+    {
+        if (!match_register(text, length, &found) && !match_instruction(text, length, &found))
+            match_directive(text, length, &found);
+    }
+
+    if (keyword != NULL)
+        *keyword = found;
+    return found.kind;
+}
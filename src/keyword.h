@@ -0,0 +1,43 @@
+#ifndef KEYWORD_H
+#define KEYWORD_H
+
+#include <stddef.h>
+#include "common.h"
+
+/** @brief Kinds of reserved words of the assembly language. */
+typedef enum
+{
+    KEYWORD_NONE,           /* not a reserved word, I.E: a label, a macro name or a number */
+    KEYWORD_INSTRUCTION,    /* an instruction name, matched case insensitively, I.E: mov, STOP */
+    KEYWORD_DIRECTIVE,      /* a directive name, with or without the dot, I.E: .data, entry */
+    KEYWORD_REGISTER        /* a register name, r0 - r7 */
+} KeywordKind;
+
+/**
+ * @brief A classified reserved word. Only the fields of its kind are meaningful.
+ */
+typedef struct Keyword
+{
+    KeywordKind     kind;       /* kind of the word */
+    int             index;      /* instruction: index of the instruction, as get_instruction_index */
+    unsigned int    opcode;     /* instruction: primary opcode */
+    unsigned int    funct;      /* instruction: secondary code */
+    DirectiveType   directive;  /* directive: its type, or INVALID_RETURN for a name without the dot */
+    int             reg;        /* register: its number */
+} Keyword;
+
+/**
+ * @brief Classifies a word as an instruction, a directive, a register or none of them.
+ *
+ * The word does not need to be null terminated, so a token can be classified in place.
+ * Classification is a switch on the length and the first characters of the word, it
+ * never allocates memory.
+ *
+ * @param text      The characters of the word.
+ * @param length    The number of characters in the word.
+ * @param keyword   Receives the classified word, may be NULL when only the kind is needed.
+ * @return The kind of the word, KEYWORD_NONE if it is not a reserved word.
+ */
+KeywordKind classify_keyword(const char* text, size_t length, Keyword* keyword);
+
+#endif /* KEYWORD_H */
@@ -1,6 +1,7 @@
 #include "label_table.h"
 #include "logger.h"
 #include "common.h"
+#include "utility.h"
 
 const char* labeltype_to_string(enum LabelType type) 
 {
@@ -11,7 +12,152 @@ const char* labeltype_to_string(enum LabelType type)
 }
 
 
-void label_table_create(LabelTable* table) 
+/* Mixes the bits of an address so nearby addresses spread across the index */
+static unsigned long hash_address(unsigned int address)
+{
+    unsigned long hash = address & 0xFFFFFFFFUL;
+    hash = ((hash >> 16) ^ hash) * 0x45D9F3BUL & 0xFFFFFFFFUL;
+    hash = ((hash >> 16) ^ hash) * 0x45D9F3BUL & 0xFFFFFFFFUL;
+    return (hash >> 16) ^ hash;
+}
+
+/* Returns the name slot holding the 'length' characters of 'name', or the empty slot where it would go */
+static int* name_slot_find(LabelTable* table, const char* name, size_t length)
+{
+    unsigned int mask = table->slot_count - 1;
+    unsigned int i = hash_string_n(name, length) & mask;
+
+    while (table->name_slots[i] != LABEL_SLOT_EMPTY)
+    {
+        const char* label_name = table->labels[table->name_slots[i]].name;
+        if (strncmp(label_name, name, length) == 0 && label_name[length] == NULL_TERMINATOR)
+            return &table->name_slots[i];
+        i = (i + 1) & mask;
+    }
+    return &table->name_slots[i];
+}
+
+/* Returns the address slot for 'address', claiming an empty one if 'create' is set */
+static LabelAddressSlot* address_slot_find(LabelTable* table, unsigned int address, int create)
+{
+    unsigned int mask = table->slot_count - 1;
+    unsigned int i = hash_address(address) & mask;
+
+    while (table->address_slots[i].in_use)
+    {
+        if (table->address_slots[i].address == address)
+            return &table->address_slots[i];
+        i = (i + 1) & mask;
+    }
+    if (!create)
+        return NULL;
+
+    table->address_slots[i].in_use  = 1;
+    table->address_slots[i].address = address;
+    table->address_slots[i].head    = LABEL_SLOT_EMPTY;
+    table->address_slots[i].tail    = LABEL_SLOT_EMPTY;
+    table->address_used++;
+    return &table->address_slots[i];
+}
+
+/* Links a label into the chain of its address, keeping the chain in ascending label order */
+static void address_link(LabelTable* table, int index)
+{
+    LabelAddressSlot* slot = address_slot_find(table, table->labels[index].address, 1);
+    int prev = slot->tail;
+
+    while (prev != LABEL_SLOT_EMPTY && prev > index)
+        prev = table->address_prev[prev];
+
+    table->address_prev[index] = prev;
+    if (prev == LABEL_SLOT_EMPTY)
+    {
+        table->address_next[index] = slot->head;
+        slot->head = index;
+    }
+    else
+    {
+        table->address_next[index] = table->address_next[prev];
+        table->address_next[prev] = index;
+    }
+
+    if (table->address_next[index] == LABEL_SLOT_EMPTY)
+        slot->tail = index;
+    else
+        table->address_prev[table->address_next[index]] = index;
+}
+
+/* Unlinks a label from the chain of its current address */
+static void address_unlink(LabelTable* table, int index)
+{
+    LabelAddressSlot* slot = address_slot_find(table, table->labels[index].address, 0);
+    int prev = table->address_prev[index];
+    int next = table->address_next[index];
+
+    if (slot == NULL)
+        return;
+
+    if (prev == LABEL_SLOT_EMPTY)
+        slot->head = next;
+    else
+        table->address_next[prev] = next;
+
+    if (next == LABEL_SLOT_EMPTY)
+        slot->tail = prev;
+    else
+        table->address_prev[next] = prev;
+}
+
+/* (Re)allocates both hash indexes for the current capacity and re-inserts every label */
+static void label_table_rebuild_index(LabelTable* table)
+{
+    unsigned int i;
+    unsigned int slot_count = 16;
+
+    /* keep the load factor of both indexes at or below 1/2 */
+    while (slot_count < table->capacity * 2)
+        slot_count *= 2;
+
+    free(table->name_slots);
+    free(table->address_slots);
+    free(table->address_next);
+    free(table->address_prev);
+    table->slot_count       = slot_count;
+    table->address_used     = 0;
+    table->name_slots       = (int*)malloc(slot_count * sizeof(int));
+    table->address_slots    = (LabelAddressSlot*)calloc(slot_count, sizeof(LabelAddressSlot));
+    table->address_next     = (int*)malloc(table->capacity * sizeof(int));
+    table->address_prev     = (int*)malloc(table->capacity * sizeof(int));
+    if (!table->name_slots || !table->address_slots || !table->address_next || !table->address_prev) 
+    {
+        log_error(__FILE__,__LINE__,  "Failed to allocate memory for the label table index!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < slot_count; i++)
+        table->name_slots[i] = LABEL_SLOT_EMPTY;
+
+    for (i = 0; i < table->size; i++)
+    {
+        *name_slot_find(table, table->labels[i].name, strlen(table->labels[i].name)) = (int)i;
+        address_link(table, (int)i);
+    }
+}
+
+/*
+ * Indexes the address of a label. A label that moves leaves the slot of its old address
+ * behind, so once 3/4 of the address slots are taken the index is rebuilt instead, which
+ * only keeps the addresses the labels have now.
+ */
+static void address_index(LabelTable* table, int index)
+{
+    if (table->address_used >= table->slot_count / 4 * 3)
+        label_table_rebuild_index(table);
+    else
+        address_link(table, index);
+}
+
+void label_table_create(LabelTable* table, Arena* arena) 
 {
     table->labels = (LabelNode*)malloc(LABEL_TABLE_DEFAULT_SIZE * sizeof(LabelNode));
     if (!table->labels) 
@@ -21,6 +167,13 @@ void label_table_create(LabelTable* table)
     }
     table->size = 0;
     table->capacity = LABEL_TABLE_DEFAULT_SIZE;
+
+    table->name_slots    = NULL;
+    table->address_slots = NULL;
+    table->address_next  = NULL;
+    table->address_prev  = NULL;
+    table->arena         = arena;
+    label_table_rebuild_index(table);
 }
 
 void label_table_destroy(LabelTable* table) 
@@ -28,21 +181,39 @@ void label_table_destroy(LabelTable* table)
     if (table->labels) 
     {
         size_t i = 0;
-        for (; i < table->size; i++) 
+        /* names in an arena are released with the arena */
+        for (; i < table->size && table->arena == NULL; i++) 
         {
             free(table->labels[i].name);
         }
         free(table->labels);
         table->labels = NULL;
     }
+    free(table->name_slots);
+    free(table->address_slots);
+    free(table->address_next);
+    free(table->address_prev);
+    table->name_slots    = NULL;
+    table->address_slots = NULL;
+    table->address_next  = NULL;
+    table->address_prev  = NULL;
     table->size = 0;
     table->capacity = 0;
+    table->slot_count = 0;
+    table->address_used = 0;
 }
 
 /* Dynamically adds a label to the table */
-void label_table_add(LabelTable* table, char* name, unsigned int address, enum LabelType type) 
+void label_table_add(LabelTable* table, const char* name, unsigned int address, enum LabelType type) 
 {
-    if(label_table_search(table,name) >= 0)
+    label_table_add_n(table, name, strlen(name), address, type);
+}
+
+void label_table_add_n(LabelTable* table, const char* name, size_t length, unsigned int address, enum LabelType type)
+{
+    char* copy;
+
+    if(label_table_search_n(table,name,length) >= 0)
     {
         log_error(__FILE__,__LINE__, "Error, label already exists in the label table!\n");
         return;
@@ -58,12 +229,22 @@ void label_table_add(LabelTable* table, char* name, unsigned int address, enum L
             log_error(__FILE__,__LINE__, "Failed to reallocate memory for the label table!\n");
             exit(EXIT_FAILURE);
         }
+        label_table_rebuild_index(table);
     }
 
-    table->labels[table->size].name = name;
+    copy = (table->arena != NULL) ? arena_strndup(table->arena, name, length) : my_strndup(name, length);
+    if (copy == NULL)
+    {
+        log_error(__FILE__,__LINE__, "Failed to allocate memory for the label name!\n");
+        return;
+    }
+
+    table->labels[table->size].name = copy;
     table->labels[table->size].address = address;
     table->labels[table->size].type = type;
+    *name_slot_find(table, copy, length) = (int)table->size;
     table->size++;
+    address_index(table, (int)table->size - 1);
 }
 
 void label_table_print(LabelTable* table) 
@@ -79,7 +260,7 @@ void label_table_print(LabelTable* table)
 
     for (; i < table->size; i++) 
     {
-        fprintf(stdout, "| %-6s | %-10u | %-6s |\n",
+        fprintf(log_output_stream(), "| %-6s | %-10u | %-6s |\n",
                table->labels[i].name,
                table->labels[i].address,
                labeltype_to_string(table->labels[i].type));
@@ -100,28 +281,45 @@ void label_node_print(LabelNode* node)
 
 int label_table_search(LabelTable* table, char* name)
 {
-    unsigned int i = 0;
-    for (; i < table->size; i++)
-    {
-        if(strcmp(name,table->labels[i].name) == 0)
-        {
-            return i;
-        }
-    }
-    return INVALID_RETURN;
+    return label_table_search_n(table, name, strlen(name));
+}
+
+int label_table_search_n(LabelTable* table, const char* name, size_t length)
+{
+    int index;
+
+    if (table->name_slots == NULL)
+        return INVALID_RETURN;
+
+    index = *name_slot_find(table, name, length);
+    return (index == LABEL_SLOT_EMPTY) ? INVALID_RETURN : index;
 }
 
 int label_table_search_by_address(LabelTable* table, unsigned int address)
 {
-    unsigned int i = 0;
-    for (; i < table->size; i++)
-    {
-        if(table->labels[i].address == address)
-        {
-            return i;
-        }
-    }
-    return INVALID_RETURN;
+    LabelAddressSlot* slot;
+
+    if (table->address_slots == NULL)
+        return INVALID_RETURN;
+
+    slot = address_slot_find(table, address, 0);
+    if (slot == NULL || slot->head == LABEL_SLOT_EMPTY)
+        return INVALID_RETURN;
+
+    return slot->head;
+}
+
+void label_table_set_address(LabelTable* table, int index, unsigned int address)
+{
+    if (table == NULL || index < 0 || (unsigned int)index >= table->size)
+        return;
+
+    if (table->labels[index].address == address)
+        return;
+
+    address_unlink(table, index);
+    table->labels[index].address = address;
+    address_index(table, index);
 }
 
 int label_table_set_node_by_name(LabelTable* table, char* name, unsigned int address, enum LabelType type)
@@ -135,7 +333,7 @@ int label_table_set_node_by_name(LabelTable* table, char* name, unsigned int add
     if((node_index = label_table_search(table,name)) >= 0)
     {
         table->labels[node_index].type      = type;
-        table->labels[node_index].address   = address;
+        label_table_set_address(table, node_index, address);
         return 1;
     }   
     return INVALID_RETURN; 
@@ -4,10 +4,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "arena.h"
 
 /** @brief Default capacity of the label table. */
 #define LABEL_TABLE_DEFAULT_SIZE 10
 
+/** @brief Marks an unused slot in the label table's hash indexes. */
+#define LABEL_SLOT_EMPTY -1
+
 /**
  * @brief Possible types of labels.
  */
@@ -39,8 +43,26 @@ typedef struct LabelNode
 
 } LabelNode;
 
+/**
+ * @brief A slot in the address index, holding every label that shares one address.
+ */
+typedef struct LabelAddressSlot
+{
+    unsigned int address;    /* The address this slot belongs to */
+    int in_use;              /* Non-zero once the slot was claimed by an address */
+    int head;                /* Lowest label index with this address, or LABEL_SLOT_EMPTY */
+    int tail;                /* Highest label index with this address, or LABEL_SLOT_EMPTY */
+} LabelAddressSlot;
+
 /**
  * @brief Manages a dynamic array of LabelNode entries.
+ *
+ * Alongside the array the table keeps two open-addressing hash indexes so that
+ * searching by name or by address is O(1) on average:
+ *  - name_slots maps a label name to its index in 'labels'.
+ *  - address_slots maps an address to the chain of labels that share it, linked
+ *    in ascending label order through address_next/address_prev, so a search by
+ *    address still returns the first label added with that address.
  */
 typedef struct LabelTable
 {
@@ -48,13 +70,24 @@ typedef struct LabelTable
     unsigned int size;       /* Current number of labels */
     unsigned int capacity;   /* Allocated capacity */
 
+    int* name_slots;                 /* Name index, holds label indexes or LABEL_SLOT_EMPTY */
+    LabelAddressSlot* address_slots; /* Address index */
+    unsigned int slot_count;         /* Number of slots in each index (a power of 2) */
+    unsigned int address_used;       /* Occupied slots in the address index, the index is rebuilt at 3/4 */
+    int* address_next;               /* Next label with the same address, per label */
+    int* address_prev;               /* Previous label with the same address, per label */
+
+    Arena* arena;                    /* Arena of the label names, NULL to allocate them on the heap */
+
 } LabelTable;
 
 /**
  * @brief Initializes a label table.
  * @param table Pointer to the LabelTable to initialize.
+ * @param arena Arena to copy the label names into, they are released with the arena.
+ *              NULL copies each of them on the heap.
  */
-void label_table_create(LabelTable* table);
+void label_table_create(LabelTable* table, Arena* arena);
 
 /**
  * @brief Frees resources used by a label table.
@@ -63,13 +96,23 @@ void label_table_create(LabelTable* table);
 void label_table_destroy(LabelTable* table);
 
 /**
- * @brief Adds a label entry to the table.
+ * @brief Adds a label entry to the table, the table keeps its own copy of the name.
  * @param table     Pointer to the LabelTable.
  * @param name      The label name.
  * @param address   The label address.
  * @param type      The label type.
  */
-void label_table_add(LabelTable* table, char* name, unsigned int address, enum LabelType type);
+void label_table_add(LabelTable* table, const char* name, unsigned int address, enum LabelType type);
+
+/**
+ * @brief Adds a label entry whose name is not null terminated, I.E: a token of a line.
+ * @param table     Pointer to the LabelTable.
+ * @param name      The characters of the label name.
+ * @param length    The number of characters in the name.
+ * @param address   The label address.
+ * @param type      The label type.
+ */
+void label_table_add_n(LabelTable* table, const char* name, size_t length, unsigned int address, enum LabelType type);
 
 /**
  * @brief Prints all labels in the table.
@@ -85,6 +128,15 @@ void label_table_print(LabelTable* table);
  */
 int label_table_search(LabelTable* table, char* name);
 
+/**
+ * @brief Searches for a label by a name that is not null terminated, I.E: a token of a line.
+ * @param table     Pointer to the LabelTable.
+ * @param name      The characters of the label name.
+ * @param length    The number of characters in the name.
+ * @return The index of the label if found, otherwise INVALID_RETURN.
+ */
+int label_table_search_n(LabelTable* table, const char* name, size_t length);
+
 /**
  * @brief Searches for a label by address.
  * @param table     Pointer to the LabelTable.
@@ -103,6 +155,14 @@ int label_table_search_by_address(LabelTable* table, unsigned int address);
  */
 int label_table_set_node_by_name(LabelTable* table,char* name, unsigned int address, enum LabelType type);
 
+/**
+ * @brief Updates a label's address by its index, keeping the address index in sync.
+ * @param table     Pointer to the LabelTable.
+ * @param index     The label index, as returned by label_table_search.
+ * @param address   The new address.
+ */
+void label_table_set_address(LabelTable* table, int index, unsigned int address);
+
 /**
  * @brief Sets a label's type by its address.
  * @param table     Pointer to the LabelTable.
@@ -1,28 +1,43 @@
 #include "logger.h"
+#include "job_context.h"
+
+FILE* log_output_stream()
+{
+    JobContext* context = job_context_current();
+    return (context != NULL && context->out != NULL) ? context->out : stdout;
+}
+
+FILE* log_error_stream()
+{
+    JobContext* context = job_context_current();
+    return (context != NULL && context->err != NULL) ? context->err : stderr;
+}
 
 /* Workaround: Use a separate function for formatted output */
 void log_out(const char *file, int line, const char *fmt, ...)
 {
+    FILE* out = log_output_stream();
     va_list args;
     va_start(args, fmt);
 
-    fprintf(stdout, "[LOG] File: %s | Line: %d | Date: %s | Time: %s\n",
+    fprintf(out, "[LOG] File: %s | Line: %d | Date: %s | Time: %s\n",
             file, line, __DATE__, __TIME__);
-    fprintf(stdout, "\tINFO: ");
-    vfprintf(stdout, fmt, args);
+    fprintf(out, "\tINFO: ");
+    vfprintf(out, fmt, args);
 
     va_end(args);
 }
 
 void log_error(const char *file, int line, const char *fmt, ...)
 {
+    FILE* err = log_error_stream();
     va_list args;
     va_start(args, fmt);
 
-    fprintf(stderr, "[LOG] File: %s | Line: %d | Date: %s | Time: %s\n",
+    fprintf(err, "[LOG] File: %s | Line: %d | Date: %s | Time: %s\n",
             file, line, __DATE__, __TIME__);
-    fprintf(stderr, "\tERROR: ");
-    vfprintf(stderr, fmt, args);
+    fprintf(err, "\tERROR: ");
+    vfprintf(err, fmt, args);
 
     va_end(args);
 }
@@ -45,4 +45,24 @@ void log_error(const char *file, int line, const char *fmt, ...);
  */
 void log_file(FILE *fp, const char *file, int line, const char *fmt, ...);
 
+/**
+ * @brief Returns the stream informational output should be written to.
+ *
+ * This is the output stream of the job bound to the calling thread (see job_context.h),
+ * or stdout if no job is bound.
+ *
+ * @return The output stream.
+ */
+FILE* log_output_stream();
+
+/**
+ * @brief Returns the stream error output should be written to.
+ *
+ * This is the error stream of the job bound to the calling thread (see job_context.h),
+ * or stderr if no job is bound.
+ *
+ * @return The error stream.
+ */
+FILE* log_error_stream();
+
 #endif
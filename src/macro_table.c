@@ -11,13 +11,13 @@ void macro_node_print(MacroNode* node)
 {
     if(node != NULL)
     {   
-        printf("macro-name:\n\t    %s\nmacro-definition:\n%s\n", node->macro_name, node->macro_definition);
+        fprintf(log_output_stream(), "macro-name:\n\t    %s\nmacro-definition:\n%s\n", node->macro_name, node->macro_definition);
     }
 }
 
 MacroNode* macro_node_create()
 {
-    MacroNode* node = malloc(sizeof(MacroNode));
+    MacroNode* node = calloc(1, sizeof(MacroNode));
     if(node == NULL)
     {
         log_error(__FILE__,__LINE__,"Failed to allocate memory for Macro Node !\n");
@@ -26,6 +26,60 @@ MacroNode* macro_node_create()
     return node;
 }
 
+/* Frees a single node and the strings it owns */
+static void macro_node_destroy(MacroNode* node)
+{
+    free(node->macro_name);
+    free(node->macro_definition);
+    free(node);
+}
+
+/* Doubles the bucket array and moves every node to its new bucket */
+static int macro_table_rehash(MacroTable* table)
+{
+    size_t i;
+    size_t new_size     = table->size * 2;
+    MacroNode** buckets = calloc(new_size, sizeof(MacroNode*));
+
+    if (buckets == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to grow Macro Table\n");
+        return INVALID_RETURN;
+    }
+
+    for (i = 0; i < table->size; i++)
+    {
+        MacroNode* node = table->buckets[i];
+        while (node != NULL)
+        {
+            MacroNode* next = node->next;
+            size_t index    = node->hash % new_size;
+            node->next      = buckets[index];
+            buckets[index]  = node;
+            node            = next;
+        }
+    }
+
+    free(table->buckets);
+    table->buckets  = buckets;
+    table->size     = new_size;
+    return VALID_RETURN;
+}
+
+/* Returns the node stored under 'key', or NULL */
+static MacroNode* macro_table_find(MacroTable* table, const char* key, unsigned long hash)
+{
+    MacroNode* node = table->buckets[hash % table->size];
+
+    while (node != NULL)
+    {
+        if (node->hash == hash && strcmp(node->macro_name, key) == 0)
+            return node;
+        node = node->next;
+    }
+    return NULL;
+}
+
 /* Create a new hash table */
 MacroTable* macro_table_create(size_t size) 
 {
@@ -37,8 +91,8 @@ MacroTable* macro_table_create(size_t size)
         return NULL;
     }
 
-    table->next_free_index  = 0;
-    table->size             = size;
+    table->count            = 0;
+    table->size             = (size > 0) ? size : DEFAULT_MACRO_TABLE_SIZE;
     table->buckets          = calloc(table->size, sizeof(MacroNode*));
 
     if (table->buckets == NULL) 
@@ -50,91 +104,127 @@ MacroTable* macro_table_create(size_t size)
     return table;
 }
 
-/* Destroy the hash table */
-void macro_table_destroy(MacroTable *table) 
+/* Frees every node, leaving an empty table with the same buckets */
+static void macro_table_clear(MacroTable* table)
 {
     size_t i = 0;
 
-    if (table == NULL)
-        return;
-
     for (; i < table->size; i++) 
     {
         MacroNode *node = table->buckets[i];
-        if(node != NULL) 
+        while (node != NULL) 
         {
-            free(node->macro_name);
-            free(node->macro_definition);
-            free(node);
+            MacroNode* next = node->next;
+            macro_node_destroy(node);
+            node = next;
         }
+        table->buckets[i] = NULL;
     }
+    table->count = 0;
+}
+
+/* Destroy the hash table */
+void macro_table_destroy(MacroTable *table) 
+{
+    if (table == NULL)
+        return;
+
+    macro_table_clear(table);
     free(table->buckets);
     free(table);
 }
 
 /* Insert a key-value pair into the hash table */
 void macro_table_insert(MacroTable *table, const char *key, const char *value) 
+{
+    macro_table_insert_buffer(table, key, value, (value != NULL) ? strlen(value) : 0);
+}
+
+void macro_table_insert_buffer(MacroTable *table, const char *key, const char *value, size_t length) 
 {
     size_t index;
+    unsigned long hash;
+    MacroNode* node;
+
     if (table == NULL || key == NULL)
         return;
 
-    
-    if(macro_table_get(table,key) == NULL)
+    hash = hash_string(key);
+    if (macro_table_find(table, key, hash) != NULL)
     {
-        if (table->next_free_index >= table->size) 
-        {
-            /* Expand or do something else */
-        }
-        else 
+        log_out(__FILE__,__LINE__,"Macro [%s] already exists.\n", key);
+        return;
+    }
+
+    if ((table->count + 1) * MACRO_TABLE_MAX_LOAD_DEN > table->size * MACRO_TABLE_MAX_LOAD_NUM)
+    {
+        if (macro_table_rehash(table) == INVALID_RETURN)
+            return;
+    }
+
+    node = macro_node_create();
+    if (node == NULL)
+        return;
+
+    node->macro_name        = my_strdup(key);
+    node->macro_definition  = NULL;
+    node->definition_length = length;
+    node->hash              = hash;
+    if (value != NULL)
+    {
+        node->macro_definition = malloc(length + 1);
+        if (node->macro_definition == NULL)
         {
-            index = table->next_free_index++;    
-            table->buckets[index] = macro_node_create();
-            table->buckets[index]->macro_name = my_strdup(key);
-            table->buckets[index]->macro_definition = my_strdup(value);
+            log_error(__FILE__,__LINE__,"Failed to allocate memory for macro [%s]\n", key);
+            macro_node_destroy(node);
             return;
-        } 
+        }
+        memcpy(node->macro_definition, value, length);
+        node->macro_definition[length] = NULL_TERMINATOR;
     }
-    log_out(__FILE__,__LINE__,"Macro Node index not empty.\n");
+    index                   = hash % table->size;
+    node->next              = table->buckets[index];
+    table->buckets[index]   = node;
+    table->count++;
 }
 
-/* Retrieve a value associated with a key or NULL if not found */
-const char* macro_table_get(MacroTable *table, const char *key) 
+const MacroNode* macro_table_get_node(MacroTable *table, const char *key) 
 {
-    size_t i;
-
     if (table == NULL || key == NULL)
         return NULL;
     
-    for(i = 0; i < table->size; i++)
-    {
-        MacroNode* node = table->buckets[i];
+    return macro_table_find(table, key, hash_string(key));
+}
 
-        if (node != NULL && strcmp(node->macro_name, key) == 0)
-            return node->macro_definition;
-    }
-    return NULL; /* Key not found */
+/* Retrieve a value associated with a key or NULL if not found */
+const char* macro_table_get(MacroTable *table, const char *key) 
+{
+    const MacroNode* node = macro_table_get_node(table, key);
+    return (node != NULL) ? node->macro_definition : NULL; /* NULL if key not found */
 }
 
 /* Remove a key-value pair from the hash table */
 void macro_table_remove(MacroTable *table, const char *key) 
 {
-    size_t i;
+    MacroNode** link;
+    unsigned long hash;
 
     if (table == NULL || key == NULL)
         return;
     
-    for(i = 0; i < table->size; i++)
+    hash = hash_string(key);
+    link = &table->buckets[hash % table->size];
+    while (*link != NULL)
     {
-        MacroNode* node = table->buckets[i];        
-        if (node != NULL && strcmp(node->macro_name, key) == 0) 
+        MacroNode* node = *link;
+        if (node->hash == hash && strcmp(node->macro_name, key) == 0) 
         {
-            free(node->macro_name);
-            free(node->macro_definition);
-            free(node);
-            table->buckets[i] = NULL;
+            *link = node->next;
+            macro_node_destroy(node);
+            table->count--;
             return;
         }
+        link = &node->next;
     }
 }
 
@@ -150,19 +240,24 @@ void macro_table_print(MacroTable* table)
         log_out(__FILE__,__LINE__,"At Index [%lu]", (unsigned long)i);
         if(node != NULL)
         {
-            printf("\n");
-            macro_node_print(node);
+            fprintf(log_output_stream(), "\n");
+            for (; node != NULL; node = node->next)
+                macro_node_print(node);
         }
         else
         {
-            printf("\t[Empty]\n");
+            fprintf(log_output_stream(), "\t[Empty]\n");
         }
     }
-    printf("\n");
+    fprintf(log_output_stream(), "\n");
 }
 
 void macro_table_reset(MacroTable** table)
 {
-    macro_table_destroy(*table);
-    *table = macro_table_create(DEFAULT_MACRO_TABLE_SIZE);
+    if (*table == NULL)
+    {
+        *table = macro_table_create(DEFAULT_MACRO_TABLE_SIZE);
+        return;
+    }
+    macro_table_clear(*table);
 }
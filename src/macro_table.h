@@ -6,6 +6,10 @@
 /** @brief Default size for the macro hash table. */
 #define DEFAULT_MACRO_TABLE_SIZE 10
 
+/** @brief The table doubles its buckets once count/size goes above MACRO_TABLE_MAX_LOAD_NUM/MACRO_TABLE_MAX_LOAD_DEN. */
+#define MACRO_TABLE_MAX_LOAD_NUM 3
+#define MACRO_TABLE_MAX_LOAD_DEN 4
+
 /**
  * @brief Holds a macro's name and definition.
  */
@@ -13,6 +17,9 @@ typedef struct MacroNode
 {
     char *macro_name;       /* Macro name. */
     char *macro_definition; /* Macro definition. */
+    size_t definition_length; /* Length of macro_definition, not including the null terminator. */
+    unsigned long hash;     /* Cached hash of macro_name, reused when rehashing. */
+    struct MacroNode *next; /* Next node in the same bucket. */
 } MacroNode;
 
 
@@ -30,12 +37,17 @@ MacroNode* macro_node_create();
 
 /**
  * @brief Hash table containing MacroNodes.
+ *
+ * Each bucket holds a chain of the MacroNodes whose name hashes to it. The bucket
+ * array grows (and every node is rehashed) once the load factor passes
+ * MACRO_TABLE_MAX_LOAD_NUM/MACRO_TABLE_MAX_LOAD_DEN, so lookups stay O(1) on average
+ * and there is no limit on the number of macros.
  */
 typedef struct MacroTable 
 {
-    MacroNode **buckets;    /* Array of MacroNode pointers. */
-    size_t size;            /* Current size of the table. */
-    size_t next_free_index; /* Next free index. */
+    MacroNode **buckets;    /* Array of MacroNode chains. */
+    size_t size;            /* Current number of buckets. */
+    size_t count;           /* Number of macros stored. */
 } MacroTable;
 
 /**
@@ -59,6 +71,23 @@ void macro_table_destroy(MacroTable* table);
  */
 void macro_table_insert(MacroTable* table, const char *key, const char *value);
 
+/**
+ * @brief Inserts a key-value pair whose value length is already known.
+ * @param table  Pointer to the MacroTable.
+ * @param key    The macro name.
+ * @param value  The macro definition.
+ * @param length Length of @p value, not including the null terminator.
+ */
+void macro_table_insert_buffer(MacroTable* table, const char *key, const char *value, size_t length);
+
+/**
+ * @brief Retrieves a macro node by key, giving access to the definition's length.
+ * @param table Pointer to the MacroTable.
+ * @param key   The macro name to find.
+ * @return The MacroNode, or NULL if not found.
+ */
+const MacroNode* macro_table_get_node(MacroTable* table, const char *key);
+
 /**
  * @brief Retrieves a value by key from the table.
  * @param table Pointer to the MacroTable.
@@ -82,6 +111,7 @@ void macro_table_print(MacroTable* table);
 
 /**
  * @brief Resets all macro nodes in the table.
+ * Keeps the grown bucket array so the next file does not rehash its way up again.
  * @param pTable Pointer to the pointer of the MacroTable.
  */
 void macro_table_reset(MacroTable** pTable);
@@ -0,0 +1,338 @@
+#define _POSIX_C_SOURCE 200112L
+#include "output_writer.h"
+#include "common.h"
+#include "logger.h"
+#include "hex_encoder.h"
+#include "job_context.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Minimum number of digits of an address, as "%.7d" */
+#define ADDRESS_DIGITS 7
+/* Number of hex digits of a 24-bit word, as "%06x" */
+#define WORD_HEX_DIGITS 6
+/* Characters after the address in a word line: ' ', the hex digits and '\n' */
+#define WORD_LINE_TAIL (WORD_HEX_DIGITS + 2)
+/* Enough characters for any unsigned long in decimal */
+#define MAX_DECIMAL_DIGITS 24
+
+/* "00" to "99", the two digits of n are at 2 * n */
+static const char decimal_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char hex_digits[] = "0123456789abcdef";
+
+const char* const output_file_extensions[OUTPUT_FILE_COUNT] = { ".ob", ".ent", ".ext", ".am" };
+
+/* Formats 'value' in decimal with at least 'min_digits' digits, ending just before 'end', returns the first character */
+static char* format_decimal(char* end, unsigned long value, int min_digits)
+{
+    char* digits = end;
+
+    while (value >= 100)
+    {
+        const char* pair = &decimal_pairs[(value % 100) * 2];
+        value /= 100;
+        *--digits = pair[1];
+        *--digits = pair[0];
+    }
+    if (value >= 10)
+    {
+        *--digits = decimal_pairs[value * 2 + 1];
+        *--digits = decimal_pairs[value * 2];
+    }
+    else
+    {
+        *--digits = (char)('0' + value);
+    }
+    while (end - digits < min_digits)
+        *--digits = '0';
+    return digits;
+}
+
+/* Writes the buffer to the file, the file of a writer opened by path is created by the first write */
+static int write_buffer(OutputWriter* writer)
+{
+    size_t written = 0;
+
+    if (writer->length == 0)
+        return VALID_RETURN;
+
+    if (writer->sink != NULL)
+    {
+        if (writer->sink->write(writer->sink->arg, writer->kind, writer->buffer, writer->length) == INVALID_RETURN)
+        {
+            log_error(__FILE__,__LINE__,"Failed to write an output file\n");
+            writer->failed = 1;
+            return INVALID_RETURN;
+        }
+        writer->length = 0;
+        return VALID_RETURN;
+    }
+    if (writer->file != NULL)
+    {
+        /* anything written to the stream itself goes first */
+        fflush(writer->file);
+    }
+    else if (writer->fd < 0)
+    {
+        writer->fd = open(writer->path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (writer->fd < 0)
+        {
+            log_error(__FILE__, __LINE__, "Failed to open [%s]\n", writer->path);
+            writer->failed = 1;
+            return INVALID_RETURN;
+        }
+    }
+
+    while (written < writer->length)
+    {
+        ssize_t count = write(writer->fd, writer->buffer + written, writer->length - written);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+        {
+            log_error(__FILE__,__LINE__,"Failed to write an output file\n");
+            writer->failed = 1;
+            return INVALID_RETURN;
+        }
+        written += count;
+    }
+    writer->length = 0;
+    return VALID_RETURN;
+}
+
+/* Makes room for 'length' characters, returns where they go or NULL if they don't fit */
+static char* reserve(OutputWriter* writer, size_t length)
+{
+    if (writer->buffer == NULL || writer->failed)
+        return NULL;
+    if (writer->length + length > writer->capacity && write_buffer(writer) == INVALID_RETURN)
+        return NULL;
+    if (length > writer->capacity)
+        return NULL;
+    return writer->buffer + writer->length;
+}
+
+/* Formats a word line with an address wider than "%.7d" pads to, one character at a time */
+static void write_wide_word_line(OutputWriter* writer, unsigned int address, wordfield word)
+{
+    char line[MAX_DECIMAL_DIGITS + WORD_LINE_TAIL];
+    char* end = line + sizeof(line) - WORD_LINE_TAIL;
+    char* start = format_decimal(end, address, ADDRESS_DIGITS);
+    unsigned int value = (unsigned int)wordfield_to_int(word);
+    size_t length = end + WORD_LINE_TAIL - start;
+    char* out;
+    int i;
+
+    end[0] = ' ';
+    for (i = 0; i < WORD_HEX_DIGITS; i++)
+        end[1 + i] = hex_digits[(value >> (4 * (WORD_HEX_DIGITS - 1 - i))) & 0xF];
+    end[WORD_LINE_TAIL - 1] = NEW_LINE;
+
+    if ((out = reserve(writer, length)) == NULL)
+        return;
+    memcpy(out, start, length);
+    writer->length += length;
+}
+
+/* Encodes the words of the run into the buffer */
+static void encode_run(OutputWriter* writer)
+{
+    size_t count = writer->run_count;
+    char* out;
+
+    if (count == 0)
+        return;
+    writer->run_count = 0;
+
+    if (writer->run_address + count <= HEX_ENCODER_ADDRESS_LIMIT)
+    {
+        if ((out = reserve(writer, count * HEX_WORD_LINE_LENGTH)) != NULL)
+            writer->length += hex_encode_word_lines(out, writer->run_address, writer->run, count);
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < count; i++)
+            write_wide_word_line(writer, writer->run_address + i, writer->run[i]);
+    }
+}
+
+/* Allocates the buffer of a writer that has a file, a path or a sink */
+static int writer_init(OutputWriter* writer, FILE* file, char* path, const OutputSink* sink, OutputFileKind kind)
+{
+    writer->file        = file;
+    writer->sink        = sink;
+    writer->kind        = kind;
+    writer->path        = path;
+    writer->fd          = (file != NULL) ? fileno(file) : -1;
+    writer->length      = 0;
+    writer->capacity    = 0;
+    writer->failed      = 0;
+    writer->buffer      = NULL;
+    writer->run_address = 0;
+    writer->run_count   = 0;
+    if (file == NULL && path == NULL && sink == NULL)
+        return VALID_RETURN;
+
+    writer->buffer = malloc(OUTPUT_WRITER_BUFFER_SIZE);
+    if (writer->buffer == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate an output buffer\n");
+        return INVALID_RETURN;
+    }
+    writer->capacity = OUTPUT_WRITER_BUFFER_SIZE;
+    return VALID_RETURN;
+}
+
+int output_writer_open(OutputWriter* writer, FILE* file)
+{
+    return writer_init(writer, file, NULL, NULL, OUTPUT_FILE_OB);
+}
+
+int output_writer_open_path(OutputWriter* writer, char* path)
+{
+    return writer_init(writer, NULL, path, NULL, OUTPUT_FILE_OB);
+}
+
+int output_writer_open_sink(OutputWriter* writer, const OutputSink* sink, OutputFileKind kind)
+{
+    return writer_init(writer, NULL, NULL, sink, kind);
+}
+
+const OutputSink* output_sink_current()
+{
+    JobContext* context = job_context_current();
+    return (context != NULL) ? context->sink : NULL;
+}
+
+/* Frees the buffer and the path, and closes the file of a writer opened by path */
+static void writer_release(OutputWriter* writer)
+{
+    if (writer->file == NULL && writer->fd >= 0)
+        close(writer->fd);
+    free(writer->buffer);
+    free(writer->path);
+    writer->buffer      = NULL;
+    writer->path        = NULL;
+    writer->file        = NULL;
+    writer->sink        = NULL;
+    writer->fd          = -1;
+    writer->length      = 0;
+    writer->capacity    = 0;
+    writer->run_count   = 0;
+}
+
+void output_writer_write(OutputWriter* writer, const char* data, size_t length)
+{
+    encode_run(writer);
+    while (length > 0)
+    {
+        size_t count = (length < writer->capacity) ? length : writer->capacity;
+        char* out = reserve(writer, count);
+        if (out == NULL)
+            return;
+        memcpy(out, data, count);
+        writer->length  += count;
+        data            += count;
+        length          -= count;
+    }
+}
+
+void output_writer_header(OutputWriter* writer, int ICF, int DCF)
+{
+    char line[2 * MAX_DECIMAL_DIGITS + 4];
+    char* end = line + sizeof(line);
+    char* start;
+
+    *--end = NEW_LINE;
+    start = format_decimal(end, (DCF < 0) ? -(unsigned long)DCF : (unsigned long)DCF, 1);
+    if (DCF < 0)
+        *--start = '-';
+    *--start = ' ';
+    start = format_decimal(start, (ICF < 0) ? -(unsigned long)ICF : (unsigned long)ICF, 1);
+    if (ICF < 0)
+        *--start = '-';
+    *--start = '\t';
+    output_writer_write(writer, start, end + 1 - start);
+}
+
+void output_writer_word(OutputWriter* writer, unsigned int address, wordfield word)
+{
+    if (writer->buffer == NULL)
+        return;
+    if (writer->run_count == OUTPUT_WORD_RUN || (writer->run_count > 0 && address != writer->run_address + writer->run_count))
+        encode_run(writer);
+    if (writer->run_count == 0)
+        writer->run_address = address;
+    writer->run[writer->run_count++] = word;
+}
+
+size_t output_word_line_length(unsigned int address)
+{
+    char digits[MAX_DECIMAL_DIGITS];
+    char* end = digits + sizeof(digits);
+
+    if (address < HEX_ENCODER_ADDRESS_LIMIT)
+        return HEX_WORD_LINE_LENGTH;
+    return (end - format_decimal(end, address, ADDRESS_DIGITS)) + WORD_LINE_TAIL;
+}
+
+void output_writer_label(OutputWriter* writer, const char* name, unsigned int address)
+{
+    char line[MAX_DECIMAL_DIGITS + 2];
+    char* end = line + sizeof(line);
+    char* start;
+
+    *--end = NEW_LINE;
+    start = format_decimal(end, address, ADDRESS_DIGITS);
+    *--start = ' ';
+    output_writer_write(writer, name, strlen(name));
+    output_writer_write(writer, start, end + 1 - start);
+}
+
+int output_writer_flush(OutputWriter* writer)
+{
+    if (writer->buffer == NULL || writer->failed)
+        return INVALID_RETURN;
+    encode_run(writer);
+    if (writer->failed)
+        return INVALID_RETURN;
+    return write_buffer(writer);
+}
+
+int output_writer_close(OutputWriter* writer)
+{
+    int flag = VALID_RETURN;
+
+    if (writer->buffer != NULL)
+        flag = output_writer_flush(writer);
+    /* a file that was never created has no records, a file left by an earlier run goes */
+    if (writer->file == NULL && writer->fd < 0 && writer->path != NULL && !writer->failed)
+        remove(writer->path);
+    writer_release(writer);
+    return flag;
+}
+
+void output_writer_discard(OutputWriter* writer)
+{
+    if (writer->sink != NULL)
+        writer->sink->discard(writer->sink->arg, writer->kind);
+    if (writer->path != NULL)
+    {
+        if (writer->fd >= 0)
+        {
+            close(writer->fd);
+            writer->fd = -1;
+        }
+        remove(writer->path);
+    }
+    writer_release(writer);
+}
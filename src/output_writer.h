@@ -0,0 +1,167 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "wordfield.h"
+
+/** @brief Size of the buffer of an OutputWriter, it's written out whenever it fills up. */
+#define OUTPUT_WRITER_BUFFER_SIZE 65536
+
+/** @brief Maximum number of consecutive words an OutputWriter encodes in one batch. */
+#define OUTPUT_WORD_RUN 64
+
+/**
+ * @brief The output files of a source file.
+ */
+typedef enum
+{
+    OUTPUT_FILE_OB,     /* the object file */
+    OUTPUT_FILE_ENT,    /* the entry labels */
+    OUTPUT_FILE_EXT,    /* the references to external labels */
+    OUTPUT_FILE_AM,     /* the expanded source, only with --emit-am */
+    OUTPUT_FILE_COUNT
+} OutputFileKind;
+
+/** @brief The extension of every output file, by OutputFileKind, I.E: ".ob". */
+extern const char* const output_file_extensions[OUTPUT_FILE_COUNT];
+
+/**
+ * @brief Receives the output files instead of build/output_files/.
+ *
+ * A job that binds a sink in its JobContext (see job_context.h) has its output
+ * files handed to the sink in pieces, in order, and no file is created.
+ */
+typedef struct OutputSink
+{
+    /* Appends characters to an output file, returns VALID_RETURN or INVALID_RETURN. */
+    int (*write)(void* arg, OutputFileKind kind, const char* data, size_t length);
+    /* Drops everything an output file received, the assembly of the file failed. */
+    void (*discard)(void* arg, OutputFileKind kind);
+    void* arg;          /* Passed to write and discard. */
+} OutputSink;
+
+/**
+ * @brief Writes the records of an output file (.ob, .ent, .ext) through one large buffer.
+ *
+ * Addresses and words are formatted with digit lookup tables instead of printf,
+ * and the buffer goes to the file with a single write() when it's full or the
+ * writer is closed, instead of one stdio call per record. Words at consecutive
+ * addresses are collected into a run and encoded together (see hex_encoder.h).
+ *
+ * A writer opened by path creates its file at the first write, so a file with
+ * no records is never created, and a file that fits in the buffer is written
+ * with a single open, write and close.
+ */
+typedef struct OutputWriter
+{
+    FILE* file;         /* The stream written to, NULL for a writer opened by path or over a sink. */
+    const OutputSink* sink; /* The sink written to, NULL for a file. */
+    OutputFileKind kind;    /* The output file the sink receives. */
+    char* path;         /* The file created at the first write, owned by the writer, NULL for a stream. */
+    int fd;             /* The descriptor written to, -1 until the file is created. */
+    char* buffer;       /* The formatted records that weren't written yet, NULL makes every record a no-op. */
+    size_t length;      /* Number of characters in the buffer. */
+    size_t capacity;    /* Allocated size of the buffer. */
+    int failed;         /* Non-zero once a write failed, the following records are dropped. */
+    wordfield run[OUTPUT_WORD_RUN]; /* Words at consecutive addresses that weren't encoded yet. */
+    unsigned int run_address;       /* Address of the first word of the run. */
+    size_t run_count;               /* Number of words in the run. */
+} OutputWriter;
+
+/**
+ * @brief Initializes an OutputWriter over an open file.
+ * @param writer    Pointer to the OutputWriter.
+ * @param file      The output file, may be NULL when it couldn't be opened.
+ * @return VALID_RETURN on success, INVALID_RETURN if the buffer couldn't be allocated.
+ */
+int output_writer_open(OutputWriter* writer, FILE* file);
+
+/**
+ * @brief Initializes an OutputWriter whose file is only created once it has records.
+ * @param writer    Pointer to the OutputWriter.
+ * @param path      The path of the file, the writer takes ownership of the allocated string.
+ * @return VALID_RETURN on success, INVALID_RETURN if the buffer couldn't be allocated.
+ */
+int output_writer_open_path(OutputWriter* writer, char* path);
+
+/**
+ * @brief Initializes an OutputWriter that hands its records to a sink instead of a file.
+ * @param writer    Pointer to the OutputWriter.
+ * @param sink      The sink, must outlive the writer.
+ * @param kind      The output file the records belong to.
+ * @return VALID_RETURN on success, INVALID_RETURN if the buffer couldn't be allocated.
+ */
+int output_writer_open_sink(OutputWriter* writer, const OutputSink* sink, OutputFileKind kind);
+
+/**
+ * @brief Returns the sink bound to the job of the calling thread.
+ * @return The sink of the job, or NULL when the output files are written to build/output_files/.
+ */
+const OutputSink* output_sink_current();
+
+/**
+ * @brief Appends characters as they are.
+ * @param writer    Pointer to the OutputWriter.
+ * @param data      The characters.
+ * @param length    The number of characters.
+ */
+void output_writer_write(OutputWriter* writer, const char* data, size_t length);
+
+/**
+ * @brief Appends the header of the .ob file, as "\t%d %d\n".
+ * @param writer    Pointer to the OutputWriter.
+ * @param ICF       Final instruction counter value.
+ * @param DCF       Final data counter value.
+ */
+void output_writer_header(OutputWriter* writer, int ICF, int DCF);
+
+/**
+ * @brief Appends a word line of the .ob file, as "%.7d %06x\n".
+ * @param writer    Pointer to the OutputWriter.
+ * @param address   The address of the word.
+ * @param word      The machine word.
+ */
+void output_writer_word(OutputWriter* writer, unsigned int address, wordfield word);
+
+/**
+ * @brief Returns the number of characters of the word line output_writer_word appends for @p address.
+ * @param address   The address of the word.
+ * @return The length of the line, including its '\n'.
+ */
+size_t output_word_line_length(unsigned int address);
+
+/**
+ * @brief Appends a line of the .ent or .ext file, as "%s %.7d\n".
+ * @param writer    Pointer to the OutputWriter.
+ * @param name      The label name.
+ * @param address   The address of the label, or of the word that references it.
+ */
+void output_writer_label(OutputWriter* writer, const char* name, unsigned int address);
+
+/**
+ * @brief Writes the buffered records to the file, creating it if needed.
+ * @param writer Pointer to the OutputWriter.
+ * @return VALID_RETURN on success, INVALID_RETURN if the file couldn't be created or written.
+ */
+int output_writer_flush(OutputWriter* writer);
+
+/**
+ * @brief Flushes the buffered records and frees the writer.
+ *
+ * A stream is left open. The file of a writer opened by path is closed, or removed
+ * if it has no records, in case an earlier run left one behind.
+ *
+ * @param writer Pointer to the OutputWriter.
+ * @return VALID_RETURN on success, INVALID_RETURN if the file couldn't be created or written.
+ */
+int output_writer_close(OutputWriter* writer);
+
+/**
+ * @brief Drops the buffered records and frees the writer, the file of a writer opened by path is removed,
+ *        and a sink drops what it received.
+ * @param writer Pointer to the OutputWriter.
+ */
+void output_writer_discard(OutputWriter* writer);
+
+#endif /* OUTPUT_WRITER_H */
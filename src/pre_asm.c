@@ -3,12 +3,15 @@
 #include "common.h"
 #include "utility.h"
 #include "macro_table.h"
+#include "string_buffer.h"
 #include "logger.h"
 #include "error_manager.h"
+#include "keyword.h"
+#include "output_writer.h"
 #include <string.h>
 #include <ctype.h>
 
-int parse_macros(FILE* fp, char* filepath, char* output_file, MacroTable* macro_table)
+int parse_macros(SourceReader* source, char* filepath, char* output_file, MacroTable* macro_table, StringBuffer* expanded)
 {
     int position        = 0; /* needed for reading word at a time from a line */
     int flag            = 0; /* tracks errors */
@@ -16,11 +19,12 @@ int parse_macros(FILE* fp, char* filepath, char* output_file, MacroTable* macro_
     char* line          = string_calloc(MAX_LINE, sizeof(char)); /* holds entire lines */
     char* word          = string_calloc(MAX_WORD, sizeof(char)); /* holds specific word within a line */
     char* current_file  = my_strdup(filepath); 
-    FILE* new_fp        = prepare_am_file(current_file,output_file); /* am file is deleted later if we found any errors */
+    int name_flag       = get_am_filename(current_file,output_file); /* the .am file itself is only written on request */
     free(current_file);
     current_file = NULL; 
+    string_buffer_clear(expanded);
     
-    if(new_fp == NULL)
+    if(name_flag == INVALID_RETURN)
     {
         free(word);
         word = NULL;
@@ -30,7 +34,8 @@ int parse_macros(FILE* fp, char* filepath, char* output_file, MacroTable* macro_
         return INVALID_RETURN;
     }
 
-    while(read_line(fp,line) != INVALID_RETURN)
+    /* a file that reached the error limit isn't read any further */
+    while(is_error_limit_reached() == INVALID_RETURN && source_reader_read_line(source,line) != INVALID_RETURN)
     {
         position = 0;
         line_count++;
@@ -43,8 +48,8 @@ int parse_macros(FILE* fp, char* filepath, char* output_file, MacroTable* macro_
         /* skip line if empty or line is a comment */
         if(line[0] == SEMICOLON || (is_line_empty(line) == VALID_RETURN))
         {
-            fprintf(new_fp,"%s",line);
-            fputc(NEW_LINE,new_fp);
+            string_buffer_append_str(expanded,line);
+            string_buffer_append_char(expanded,NEW_LINE);
             continue;
         }
 
@@ -58,21 +63,20 @@ int parse_macros(FILE* fp, char* filepath, char* output_file, MacroTable* macro_
                     we simply 'try' to get the macro definition, if its a label temp == NULL and we continue
                     to add it at lines 74+75. 
                 */
-                if((is_instruction(word) == INVALID_RETURN) && (is_directive(word) == INVALID_RETURN) && 
-                    (is_register(word) == INVALID_RETURN))
+                if(classify_keyword(word,strlen(word),NULL) == KEYWORD_NONE)
                 {
                     /* if its not a register/instruction/directive - check if its a macro call */
-                    const char* temp = macro_table_get(macro_table,word); 
+                    const MacroNode* macro = macro_table_get_node(macro_table,word); 
                     /* try to get the macro */ 
-                    if(temp != NULL)
+                    if(macro != NULL)
                     {
-                        fprintf(new_fp,"%s",temp);    
+                        string_buffer_append(expanded,macro->macro_definition,macro->definition_length);
                         continue;
                     }
                 } 
-                /* if its a register/instruction/directive/label simply add it to the new file */
-                fprintf(new_fp,"%s",line);
-                fputc(NEW_LINE,new_fp);
+                /* if its a register/instruction/directive/label simply add it to the expanded source */
+                string_buffer_append_str(expanded,line);
+                string_buffer_append_char(expanded,NEW_LINE);
             }
         }
         else /* mcro is within the line */
@@ -110,7 +114,7 @@ int parse_macros(FILE* fp, char* filepath, char* output_file, MacroTable* macro_
                             flag = INVALID_RETURN;
                             add_error_entry(ErrorType_ExtraneousText_Macro,filepath,line_count);
                         }
-                        flag = handle_new_macro(fp,macro_table,word,filepath,&line_count);
+                        flag = handle_new_macro(source,macro_table,word,filepath,&line_count);
                     }
 
                 }
@@ -118,11 +122,6 @@ int parse_macros(FILE* fp, char* filepath, char* output_file, MacroTable* macro_
         }
     }
 
-    if(new_fp)
-    {
-        fclose(new_fp);
-        new_fp = NULL;
-    }
     if(word)
     {
         free(word);
@@ -150,20 +149,33 @@ int parse_macros(FILE* fp, char* filepath, char* output_file, MacroTable* macro_
 }
 
 
-int handle_new_macro(FILE* fp,MacroTable* macro_table, char* macro_name,char* filepath, int* line_count)
+int handle_new_macro(SourceReader* source,MacroTable* macro_table, char* macro_name,char* filepath, int* line_count)
 {
     int flag                    = 0;
     char* line                  = string_calloc(MAX_LINE, sizeof(char));
     char* word                  = string_calloc(MAX_WORD, sizeof(char));
-    char* current_macro_value   = string_calloc(MAX_LINE, sizeof(char));
+    StringBuffer current_macro_value; /* grows as needed, appending is O(line length) */
 
-    while(read_line(fp, line) != INVALID_RETURN)
+    if(string_buffer_init(&current_macro_value, DEFAULT_STRING_BUFFER_SIZE) == INVALID_RETURN)
+    {
+        free(line);
+        free(word);
+        add_error_entry(ErrorType_MemoryAllocationFailure,filepath,*line_count);
+        return INVALID_RETURN;
+    }
+
+    while(source_reader_read_line(source, line) != INVALID_RETURN)
     {
         (*line_count)++;
         if(strstr(line,"mcroend") == NULL)
         {
-            strcat(current_macro_value,line);
-            strcat(current_macro_value,"\n");
+            if(string_buffer_append_str(&current_macro_value,line) == INVALID_RETURN ||
+               string_buffer_append_char(&current_macro_value,NEW_LINE) == INVALID_RETURN)
+            {
+                flag = INVALID_RETURN;
+                add_error_entry(ErrorType_MemoryAllocationFailure,filepath,*line_count);
+                break;
+            }
         }
         else
         {
@@ -190,19 +202,17 @@ int handle_new_macro(FILE* fp,MacroTable* macro_table, char* macro_name,char* fi
         }
     }
                 
-    macro_table_insert(macro_table, macro_name, current_macro_value);
+    macro_table_insert_buffer(macro_table, macro_name, current_macro_value.data, current_macro_value.length);
     free(line);
     line = NULL;
     free(word);
     word = NULL;
-    free(current_macro_value);
-    current_macro_value = NULL;
+    string_buffer_free(&current_macro_value);
     return flag;
 }
 
-FILE* prepare_am_file(char* file, char* output_file)
+int get_am_filename(char* file, char* output_file)
 {
-    FILE* new_fp;
     size_t total_length;
     char* file_path;
     char* filename              = get_filename(file);
@@ -216,25 +226,49 @@ FILE* prepare_am_file(char* file, char* output_file)
     {
         log_error(__FILE__,__LINE__, "Memory allocation failed for file_path\n");
         add_error_entry(ErrorType_MemoryAllocationFailure,__FILE__,__LINE__);
-        return NULL;
+        return INVALID_RETURN;
     }
     
     sprintf(file_path, "%s%s",output_path, filename);
+    strcpy(output_file,file_path);
+    free(file_path);
+    file_path = NULL;
+    return VALID_RETURN;
+}
+
+int write_am_file(const char* output_file, const StringBuffer* expanded)
+{
+    FILE* new_fp;
+    const OutputSink* sink = output_sink_current();
 
-    new_fp = fopen(file_path, "w+");
+    if (sink != NULL)
+    {
+        if (sink->write(sink->arg, OUTPUT_FILE_AM, expanded->data, expanded->length) == INVALID_RETURN)
+        {
+            log_error(__FILE__,__LINE__, "Failed to write [%s]\n.", output_file);
+            return INVALID_RETURN;
+        }
+        return VALID_RETURN;
+    }
+
+    new_fp = fopen(output_file, "w");
     if (!new_fp) 
     {
-        log_error(__FILE__,__LINE__, "Failed to open [%s] for pre_asm output\n.", file_path);
+        log_error(__FILE__,__LINE__, "Failed to open [%s] for pre_asm output\n.", output_file);
         add_error_entry(ErrorType_OpenFileFailure,__FILE__,__LINE__);
-        free(file_path);
-        file_path = NULL;
-        return NULL;
+        return INVALID_RETURN;
     }
-    
-    strcpy(output_file,file_path);
-    free(file_path);
-    file_path = NULL;
-    return new_fp;
+
+    /* the whole expanded source is written with a single call */
+    if (fwrite(expanded->data, sizeof(char), expanded->length, new_fp) != expanded->length)
+    {
+        log_error(__FILE__,__LINE__, "Failed to write [%s]\n.", output_file);
+        fclose(new_fp);
+        return INVALID_RETURN;
+    }
+
+    fclose(new_fp);
+    return VALID_RETURN;
 }
 
 int check_line_length(char* line)
@@ -252,23 +286,20 @@ int check_macro_name(const char* macro_name, char* filepath, int* line_count)
         return INVALID_RETURN;
     }
 
-    /* check if its an instruction */
-    if(is_instruction(macro_name) == VALID_RETURN)
+    /* check if its an instruction, a directive or a register */
+    switch (classify_keyword(macro_name,macro_length,NULL))
     {
+    case KEYWORD_INSTRUCTION:
         add_error_entry(ErrorType_InvalidMacroName_Instruction,filepath,*line_count);
         return INVALID_RETURN;
-    }
-    /* check if its a directive */
-    if(is_directive(macro_name) == VALID_RETURN)
-    {
+    case KEYWORD_DIRECTIVE:
         add_error_entry(ErrorType_InvalidMacroName_Directive,filepath,*line_count);
         return INVALID_RETURN;
-    }
-    /* check if its a register */
-    if(is_register(macro_name) != INVALID_RETURN)
-    {
+    case KEYWORD_REGISTER:
         add_error_entry(ErrorType_InvalidMacroName_Register,filepath,*line_count);
         return INVALID_RETURN;
+    default:
+        break;
     }
     return VALID_RETURN;
 }
\ No newline at end of file
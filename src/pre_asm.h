@@ -3,29 +3,43 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "macro_table.h"
+#include "string_buffer.h"
+#include "source_reader.h"
 
 /**
- * @brief Looks for macros in the file
- * @param fp Fp the file to read from.
+ * @brief Looks for macros in the file and expands them into memory
+ * @param source The source to read from.
+ * @param filepath The path of the .as file (needed for error entries)
+ * @param output_file Stores the .am file name, used by the first pass for error entries
+ * @param macro_table Stores the macros defined in the file
+ * @param expanded Receives the expanded source, the contents of the .am file
  * @return 1 on success or -1 when reaching EOF.
  */
-int parse_macros(FILE* fp, char* filepath, char* output_file, MacroTable* macro_table);
+int parse_macros(SourceReader* source, char* filepath, char* output_file, MacroTable* macro_table, StringBuffer* expanded);
 
 /**
  * @brief Add a new macro to the macro table
- * @param fp The file to read from.
+ * @param source The source to read from, positioned after the 'mcro' line.
  * @param macro_table Stores the new macro in this table.
  * @return 1 on success or -1 when reaching EOF.
  */
-int handle_new_macro(FILE* fp,MacroTable* macro_table, char* macro_name,char* filepath, int* line_count);
+int handle_new_macro(SourceReader* source,MacroTable* macro_table, char* macro_name,char* filepath, int* line_count);
 
 /**
- * @brief Opens and prepares the .am file needed for first pass
- * @param filepath The .as file to copy its name from
+ * @brief Builds the name of the .am file for a source file
+ * @param file The .as file to copy its name from (its extension is modified)
  * @param output_file Stores the new .am output file name
- * @return NULL if error occured, new am file to write to on success
+ * @return VALID_RETURN on success, INVALID_RETURN if error occured
  */
-FILE* prepare_am_file(char* file, char* output_file);
+int get_am_filename(char* file, char* output_file);
+
+/**
+ * @brief Writes the expanded source to the .am file, or to the output sink of the job if it has one
+ * @param output_file The .am file name, as built by get_am_filename
+ * @param expanded The expanded source produced by parse_macros
+ * @return VALID_RETURN on success, INVALID_RETURN if the file could not be written
+ */
+int write_am_file(const char* output_file, const StringBuffer* expanded);
 
 /**
  * @brief Check if a given line is greater than 80 characters
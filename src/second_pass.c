@@ -3,6 +3,7 @@
 #include "logger.h"
 #include "common.h"
 #include "utility.h"
+#include "output_writer.h"
 #include <stdio.h>
 
 int prepare_second_pass(const char* filepath,BinaryTable* binary_table, LabelTable* label_table, int ICF, int DCF)
@@ -22,50 +23,18 @@ int prepare_second_pass(const char* filepath,BinaryTable* binary_table, LabelTab
 int execute_second_pass(BinaryTable* binary_table,LabelTable* label_table, int ICF, int DCF,const char* filepath)
 {
     int flag;
-    FILE* ob_file;
-    FILE* ent_file;
-    FILE* ext_file;
-    char* ob_filename   = NULL;
-    char* ent_filename  = NULL;
-    char* ext_filename  = NULL;
-    prepare_output_files(filepath,&ob_file,&ent_file,&ext_file,&ob_filename,&ent_filename,&ext_filename);
+    OutputWriter ob_writer;
+    OutputWriter ent_writer;
+    OutputWriter ext_writer;
+    prepare_output_files(filepath,&ob_writer,&ent_writer,&ext_writer);
 
-    fprintf(ob_file,"\t%d %d\n",ICF,DCF);
-    flag = complete_first_pass(binary_table,label_table,&ob_file,&ext_file);
+    output_writer_header(&ob_writer,ICF,DCF);
+    flag = complete_first_pass(binary_table,label_table,&ob_writer,&ext_writer);
 
     if(flag != INVALID_RETURN)
-        handle_entries(label_table, &ent_file);
+        handle_entries(label_table,&ent_writer);
 
-    if(is_file_empty(ext_file) != INVALID_RETURN || flag == INVALID_RETURN)
-    {
-        fclose(ext_file);
-        ext_file = NULL;
-        remove(ext_filename);
-    }
-    else if(ext_file)
-        fclose(ext_file);
-    
-    if(is_file_empty(ent_file) != INVALID_RETURN || flag == INVALID_RETURN)
-    {
-        fclose(ent_file);
-        ent_file = NULL;
-        remove(ent_filename);
-    }
-    else if(ent_file)    
-        fclose(ent_file);
-    
-    if(is_file_empty(ob_file) != INVALID_RETURN || flag == INVALID_RETURN)
-    {
-        fclose(ob_file);
-        ob_file = NULL;
-        remove(ob_filename);
-    }
-    else if(ob_file)
-        fclose(ob_file);
-
-    free(ob_filename);
-    free(ent_filename);
-    free(ext_filename);
+    close_output_files(flag,&ob_writer,&ent_writer,&ext_writer);
     
     if(is_errors_array_empty() == INVALID_RETURN)
     {
@@ -84,175 +53,206 @@ int execute_second_pass(BinaryTable* binary_table,LabelTable* label_table, int I
     return VALID_RETURN;
 }
 
-/*
- * NOTE: 
- *      We use double pointers (FILE**) so that this function can
- *      initialize the file pointers passed by the caller.
- *      In order to avoid warnings about uninitialized file pointers
- *      and to clarify each function's responsibility.
- */
-void prepare_output_files(const char* filepath, FILE** fp_ob, FILE** fp_ent, FILE** fp_ext,
-    char** ob_filename, char** ent_filename, char** ext_filename)
+/* Opens writers over the sink of the job instead of files */
+static int open_sink_writers(const OutputSink* sink, OutputWriter* ob_writer, OutputWriter* ent_writer, OutputWriter* ext_writer)
+{
+    int flag = VALID_RETURN;
+
+    if(output_writer_open_sink(ob_writer,sink,OUTPUT_FILE_OB) == INVALID_RETURN)
+        flag = INVALID_RETURN;
+    if(output_writer_open_sink(ent_writer,sink,OUTPUT_FILE_ENT) == INVALID_RETURN)
+        flag = INVALID_RETURN;
+    if(output_writer_open_sink(ext_writer,sink,OUTPUT_FILE_EXT) == INVALID_RETURN)
+        flag = INVALID_RETURN;
+    if(flag == INVALID_RETURN)
+        add_error_entry(ErrorType_OpenFileFailure, __FILE__, __LINE__);
+    return flag;
+}
+
+/* Opens a writer over an output file, the file itself is only created once it has records */
+static int open_output_writer(OutputWriter* writer, char* filename)
+{
+    if(output_writer_open_path(writer,filename) == INVALID_RETURN)
+    {
+        log_error(__FILE__, __LINE__, "Failed to open [%s]\n", filename);
+        add_error_entry(ErrorType_OpenFileFailure, __FILE__, __LINE__);
+        return INVALID_RETURN;
+    }
+    return VALID_RETURN;
+}
+
+int prepare_output_files(const char* filepath, OutputWriter* ob_writer, OutputWriter* ent_writer, OutputWriter* ext_writer)
 {
+    int flag = VALID_RETURN;
     size_t total_len;
     char* filename;
+    char* ob_filename;
+    char* ent_filename;
+    char* ext_filename;
+    char* file_path;
     char* output_path       = OUTPUT_PATH;
     size_t filename_length  = strlen(filepath);
+    const OutputSink* sink  = output_sink_current();
+
+    if(sink != NULL)
+        return open_sink_writers(sink,ob_writer,ent_writer,ext_writer);
 
     /* Allocate enough space for modification (filename_length + 3 bytes extra) */
-    char* file_path = string_malloc(filename_length + 3);
+    file_path = string_malloc(filename_length + 3);
     strcpy(file_path, filepath);
 
     filename = get_filename(file_path);
 
-    /* Allocating output filenames */
+    /* Allocating output filenames, the writers own them */
     total_len       = strlen(output_path) + strlen(filename) + 5; /* extra padding */
-    *ob_filename    = string_malloc(total_len);
-    *ent_filename   = string_malloc(total_len);
-    *ext_filename   = string_malloc(total_len);
+    ob_filename     = string_malloc(total_len);
+    ent_filename    = string_malloc(total_len);
+    ext_filename    = string_malloc(total_len);
 
     /* Prepare OB filename */
     file_path[filename_length - 2]  = 'o';
     file_path[filename_length - 1]  = 'b';
     file_path[filename_length]      = NULL_TERMINATOR;
-    sprintf(*ob_filename, "%s%s", output_path, filename);
-    *fp_ob = fopen(*ob_filename, "w+");
-    if(*fp_ob == NULL) 
-    {
-        log_error(__FILE__, __LINE__, "Failed to open [%s]\n", *ob_filename);
-        add_error_entry(ErrorType_OpenFileFailure, __FILE__, __LINE__);
-    }
+    sprintf(ob_filename, "%s%s", output_path, filename);
+    if(open_output_writer(ob_writer,ob_filename) == INVALID_RETURN)
+        flag = INVALID_RETURN;
 
     /* Prepare ENT filename */
     file_path[filename_length - 2]  = 'e';
     file_path[filename_length - 1]  = 'n';
     file_path[filename_length]      = 't';
     file_path[filename_length + 1]  = NULL_TERMINATOR;
-    sprintf(*ent_filename, "%s%s", output_path, filename);
-    *fp_ent = fopen(*ent_filename, "w+");
-    if(*fp_ent == NULL) 
-    {
-        log_error(__FILE__, __LINE__, "Failed to open [%s]\n", *ent_filename);
-        add_error_entry(ErrorType_OpenFileFailure, __FILE__, __LINE__);
-    }
+    sprintf(ent_filename, "%s%s", output_path, filename);
+    if(open_output_writer(ent_writer,ent_filename) == INVALID_RETURN)
+        flag = INVALID_RETURN;
 
     /* Prepare EXT filename */
     file_path[filename_length - 2]  = 'e';
     file_path[filename_length - 1]  = 'x';
     file_path[filename_length]      = 't';
     file_path[filename_length + 1]  = NULL_TERMINATOR;
-    sprintf(*ext_filename, "%s%s", output_path, filename);
-    *fp_ext = fopen(*ext_filename, "w+");
-    if(*fp_ext == NULL) 
-    {
-        log_error(__FILE__, __LINE__, "Failed to open [%s]\n", *ext_filename);
-        add_error_entry(ErrorType_OpenFileFailure, __FILE__, __LINE__);
-    }
+    sprintf(ext_filename, "%s%s", output_path, filename);
+    if(open_output_writer(ext_writer,ext_filename) == INVALID_RETURN)
+        flag = INVALID_RETURN;
 
     free(file_path);
+    return flag;
 }
 
 
 void handle_distance_to_label(BinaryNode* binary_node, LabelNode* node)
 {
     int distance = node->address - (binary_node->address-1);
-    set_wordfield_are_num(binary_node->word,distance,ARE_ABSOLUTE);
+    set_wordfield_are_num(&binary_node->word,distance,ARE_ABSOLUTE);
 }
 
-int complete_first_pass(BinaryTable* binary_table,LabelTable* label_table,FILE** ob_file,FILE** ext_file)
+/* Closes the writer of an output file, the file is created here if its records fit in the buffer */
+static void close_output_writer(int flag, OutputWriter* writer)
 {
-    int i, flag = VALID_RETURN;
+    if(flag == INVALID_RETURN)
+    {
+        output_writer_discard(writer);
+        return;
+    }
+    if(output_writer_close(writer) == INVALID_RETURN)
+        add_error_entry(ErrorType_OpenFileFailure, __FILE__, __LINE__);
+}
+
+void close_output_files(int flag, OutputWriter* ob_writer, OutputWriter* ent_writer, OutputWriter* ext_writer)
+{
+    close_output_writer(flag,ext_writer);
+    close_output_writer(flag,ent_writer);
+    close_output_writer(flag,ob_writer);
+}
+
+void patch_fixup_word(Fixup* fixup, BinaryNode* binary_node, LabelNode* label_node)
+{
+    fixup->resolved = 1;
+    if(fixup->kind == FIXUP_RELATIVE)
+    {
+        handle_distance_to_label(binary_node,label_node);
+        return;
+    }
+
+    switch (label_node->type)
+    {
+    case LABELTYPE_CODE:
+        set_wordfield_are_num(&binary_node->word,label_node->address,ARE_RELOCATABLE);  
+        break;
+    case LABELTYPE_DATA:
+        set_wordfield_are_num(&binary_node->word,label_node->address,ARE_RELOCATABLE);
+        break;
+    case LABELTYPE_EXTERN:
+        set_wordfield_are(&binary_node->word,ARE_EXTERNAL);
+        fixup->kind = FIXUP_EXTERNAL; /* the .ext line is written with the word */
+        break;
+    case LABELTYPE_CODE_ENTRY: /* the .ent line is written later, we fill the necessary bits of the wordfield */
+        set_wordfield_are_num(&binary_node->word,label_node->address,ARE_RELOCATABLE);
+        break;
+    case LABELTYPE_DATA_ENTRY: /* the .ent line is written later, we fill the necessary bits of the wordfield */
+        set_wordfield_are_num(&binary_node->word,label_node->address,ARE_RELOCATABLE);
+        break;
+    default:
+        break;
+    }
+}
+
+void write_binary_node(const FixupList* fixups, const Fixup* fixup, const BinaryNode* binary_node,
+    OutputWriter* ob_writer, OutputWriter* ext_writer)
+{
+    if(fixup != NULL && fixup->resolved && fixup->kind == FIXUP_RELATIVE)
+        return; /* a resolved distance isn't written to the .ob file */
+
+    if(fixup != NULL && fixup->kind == FIXUP_EXTERNAL)
+        output_writer_label(ext_writer,fixups->symbols[fixup->symbol].name,binary_node->address); 
+
+    output_writer_word(ob_writer,binary_node->address,binary_node->word);
+}
+
+int complete_first_pass(BinaryTable* binary_table,LabelTable* label_table,OutputWriter* ob_writer,OutputWriter* ext_writer)
+{
+    int flag = VALID_RETURN;
+    size_t i, next_fixup = 0;
+    FixupList* fixups = &binary_table->fixups;
+
     for (i = 0; i < binary_table->size; i++) 
     {
-        char* hex_str;
-        int index, wordfield_number;
+        Fixup* fixup = NULL;
         BinaryNode* binary_node = binary_table->data[i];
-        if(binary_node->unresolved_label != NULL)
+        if(binary_node == NULL) /* address skipped by the first pass */
+            continue;
+
+        /* the fix-ups are in address order, only the words they point at are patched */
+        if(next_fixup < fixups->count && fixups->data[next_fixup].address == binary_node->address)
         {
-            char* temp_unresolved_label = my_strdup(binary_node->unresolved_label);
-            if(binary_node->unresolved_label[0] == AMPERSAND)
-            {
-                strcpy(temp_unresolved_label,binary_node->unresolved_label);
-                remove_first_character(binary_node->unresolved_label);
-            }
-            else
-            {
-                free(temp_unresolved_label);
-                temp_unresolved_label = NULL;
-            }
+            FixupSymbol* symbol;
+            fixup = &fixups->data[next_fixup++];
+            symbol = &fixups->symbols[fixup->symbol];
 
-            if((index = label_table_search(label_table,binary_node->unresolved_label)) != INVALID_RETURN)
-            {
-                LabelNode label_node = label_table->labels[index];
-
-                if(temp_unresolved_label != NULL && temp_unresolved_label[0] == AMPERSAND)
-                {
-                    handle_distance_to_label(binary_node,&label_node);
-                    
-                    if(temp_unresolved_label != NULL)
-                    {
-                        free(temp_unresolved_label);
-                        free(binary_node->unresolved_label);
-                        binary_node->unresolved_label = NULL;
-                    }
-                    continue;
-                }
-
-                switch (label_node.type)
-                {
-                case LABELTYPE_CODE:
-                    set_wordfield_are_num(binary_node->word,label_node.address,ARE_RELOCATABLE);  
-                    break;
-                case LABELTYPE_DATA:
-                    set_wordfield_are_num(binary_node->word,label_node.address,ARE_RELOCATABLE);
-                    break;
-                case LABELTYPE_EXTERN:
-                    set_wordfield_are(binary_node->word,ARE_EXTERNAL);
-                    if(ext_file && *ext_file)
-                    {
-                        fprintf(*ext_file,"%s %.7d\n",binary_node->unresolved_label,binary_node->address); 
-                    }
-                    break;
-                case LABELTYPE_CODE_ENTRY: /* entries are handled later. */
-                    break;
-                case LABELTYPE_DATA_ENTRY: /* entries are handled later, we fill the necessary bits of the wordfield */
-                    set_wordfield_are_num(binary_node->word,label_node.address,ARE_RELOCATABLE);
-                    break;
-                default:
-                    break;
-                }
-
-                if(binary_node->unresolved_label)
-                {
-                    free(binary_node->unresolved_label);
-                    binary_node->unresolved_label = NULL;
-                }
-            }
-            else
+            /* every symbol is looked up once, however many words reference it */
+            if(symbol->label == FIXUP_SYMBOL_UNRESOLVED)
+                symbol->label = label_table_search(label_table,symbol->name);
+            if(symbol->label == INVALID_RETURN)
             {
                 add_error_entry(ErrorType_InvalidLabel_UndefinedLabel,NULL,binary_node->address);
                 flag = INVALID_RETURN;
             }
-
-            if(temp_unresolved_label != NULL)
+            else
             {
-                free(temp_unresolved_label);
-                temp_unresolved_label = NULL;
+                patch_fixup_word(fixup,binary_node,&label_table->labels[symbol->label]);
             }
         }
-        wordfield_number = wordfield_to_int(binary_node->word);
-        hex_str = int_to_hex(wordfield_number);
-        fprintf(*ob_file,"%.7d %s\n",binary_node->address,hex_str);
-        free(hex_str);
+
+        write_binary_node(fixups,fixup,binary_node,ob_writer,ext_writer);
     }
 
     return flag;
 }
 
-void handle_entries(LabelTable* label_table, FILE** ent_file)
+void handle_entries(LabelTable* label_table, OutputWriter* ent_writer)
 {
     int i;
-    if(ent_file == NULL)
+    if(ent_writer == NULL)
     {
         return;
     }
@@ -263,16 +263,10 @@ void handle_entries(LabelTable* label_table, FILE** ent_file)
         switch (label_node.type)
         {
         case LABELTYPE_CODE_ENTRY:
-            if(*ent_file)
-            {
-                fprintf(*ent_file,"%s %.7d\n",label_node.name,label_node.address);
-            }
+            output_writer_label(ent_writer,label_node.name,label_node.address);
             break;
         case LABELTYPE_DATA_ENTRY:
-            if(*ent_file)
-            {
-                fprintf(*ent_file,"%s %.7d\n",label_node.name,label_node.address);
-            }
+            output_writer_label(ent_writer,label_node.name,label_node.address);
             break;
         default:
             break;
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include "label_table.h"
 #include "binary_table.h"
+#include "output_writer.h"
 
 /**
  * @brief Prepares and initiates the second pass of the assembler.
@@ -36,21 +37,20 @@ int prepare_second_pass(const char* filepath,BinaryTable* binary_table,LabelTabl
 int execute_second_pass(BinaryTable* binary_table,LabelTable* label_table, int ICF, int DCF,const char* filepath);
 
 /**
- * @brief Prepares and opens the output files (.ob, .ent, .ext) based on the input file path.
+ * @brief Prepares the writers of the output files (.ob, .ent, .ext) based on the input file path.
  *
- * Dynamically allocates filenames and initializes file pointers for writing assembler output.
- * Each filename is constructed by modifying the file extension.
+ * Each filename is constructed by modifying the file extension. No file is created here,
+ * a writer creates its file at its first write, so a file without records never exists.
+ * When the job has an output sink (see output_sink_current) the writers hand their records
+ * to the sink instead.
  *
  * @param filepath       The path to the source file.
- * @param fp_ob          Pointer to the object file stream pointer.
- * @param fp_ent         Pointer to the entry file stream pointer.
- * @param fp_ext         Pointer to the extern file stream pointer.
- * @param ob_filename    Pointer to store the dynamically allocated .ob filename.
- * @param ent_filename   Pointer to store the dynamically allocated .ent filename.
- * @param ext_filename   Pointer to store the dynamically allocated .ext filename.
+ * @param ob_writer      Receives the writer of the object file.
+ * @param ent_writer     Receives the writer of the entry file.
+ * @param ext_writer     Receives the writer of the extern file.
+ * @return VALID_RETURN on success, INVALID_RETURN if a writer couldn't be allocated.
  */
-void prepare_output_files(const char* filepath, FILE** fp_ob, FILE** fp_ent, FILE** fp_ext,
-    char** ob_filename,char** ent_filename,char** ext_filename);
+int prepare_output_files(const char* filepath, OutputWriter* ob_writer, OutputWriter* ent_writer, OutputWriter* ext_writer);
 
 /**
  * @brief Computes and encodes the distance to a label for relative addressing mode.
@@ -64,18 +64,56 @@ void prepare_output_files(const char* filepath, FILE** fp_ob, FILE** fp_ent, FIL
 void handle_distance_to_label(BinaryNode* binary_node, LabelNode* node);
 
 /**
- * @brief Completes label resolution for all binary nodes with unresolved labels.
+ * @brief Writes out and closes the output files, or removes all of them if @p flag is INVALID_RETURN.
  *
- * Resolves each label based on its type (code, data, extern), modifies the wordfield accordingly,
- * and outputs the final result to the object and extern files.
+ * A file without records isn't created, and one left by an earlier run is removed.
+ *
+ * @param flag           INVALID_RETURN if the file failed to assemble.
+ * @param ob_writer      Writer of the object file.
+ * @param ent_writer     Writer of the entry file.
+ * @param ext_writer     Writer of the extern file.
+ */
+void close_output_files(int flag, OutputWriter* ob_writer, OutputWriter* ent_writer, OutputWriter* ext_writer);
+
+/**
+ * @brief Patches the word of a fix-up with its label, and marks the fix-up resolved.
+ *
+ * A direct fix-up to an external label becomes FIXUP_EXTERNAL, its .ext line is
+ * written with the word by write_binary_node.
+ *
+ * @param fixup          The fix-up of the word.
+ * @param binary_node    The binary node of the word.
+ * @param label_node     The label the word references.
+ */
+void patch_fixup_word(Fixup* fixup, BinaryNode* binary_node, LabelNode* label_node);
+
+/**
+ * @brief Writes a word to the object file, and its .ext line if it references an external label.
+ *
+ * A resolved distance to a label is not written to the object file.
+ *
+ * @param fixups         The fix-up list the fix-up of the word is in.
+ * @param fixup          The fix-up of the word, NULL if the word has none.
+ * @param binary_node    The binary node of the word.
+ * @param ob_writer      Writer of the object file.
+ * @param ext_writer     Writer of the extern file.
+ */
+void write_binary_node(const FixupList* fixups, const Fixup* fixup, const BinaryNode* binary_node,
+    OutputWriter* ob_writer, OutputWriter* ext_writer);
+
+/**
+ * @brief Completes label resolution for the words in the fix-up list of the binary table.
+ *
+ * Patches only the words the first pass recorded fix-ups for, based on the type of their
+ * label (code, data, extern), and streams every word to the object and extern files.
  *
  * @param binary_table   The binary table to finalize.
  * @param label_table    The label table to search for label definitions.
- * @param ob_file        Output file for object code.
- * @param ext_file       Output file for extern labels.
+ * @param ob_writer      Writer of the object file.
+ * @param ext_writer     Writer of the extern file.
  * @return VALID_RETURN if all labels were resolved successfully, or INVALID_RETURN on failure.
  */
-int complete_first_pass(BinaryTable* binary_table,LabelTable* label_table,FILE** ob_file,FILE** ext_file);
+int complete_first_pass(BinaryTable* binary_table,LabelTable* label_table,OutputWriter* ob_writer,OutputWriter* ext_writer);
 
 /**
  * @brief Writes entries (.entry labels) from the label table into the .ent file.
@@ -84,8 +122,8 @@ int complete_first_pass(BinaryTable* binary_table,LabelTable* label_table,FILE**
  * to the provided .ent output file.
  *
  * @param label_table    Pointer to the label table.
- * @param ent_file       Pointer to the .ent file stream.
+ * @param ent_writer     Writer of the .ent file.
  */
-void handle_entries(LabelTable* label_table, FILE** ent_file);
+void handle_entries(LabelTable* label_table, OutputWriter* ent_writer);
 
 #endif
\ No newline at end of file
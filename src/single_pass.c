@@ -0,0 +1,362 @@
+#include "single_pass.h"
+#include "second_pass.h"
+#include "tokenizer.h"
+#include "error_manager.h"
+#include "logger.h"
+#include "common.h"
+#include "utility.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Returns the label of a symbol, or INVALID_RETURN while it isn't defined.
+ * A label isn't cached until it's found, it may be defined by a later line.
+ */
+static int symbol_label(FixupSymbol* symbol, LabelTable* label_table)
+{
+    if(symbol->label < 0)
+    {
+        int label = label_table_search(label_table,symbol->name);
+        if(label == INVALID_RETURN)
+            return INVALID_RETURN;
+        symbol->label = label;
+    }
+    return symbol->label;
+}
+
+/*
+ * A label is final once no later line can change how a word that references it is encoded:
+ * an external label, or a defined label. A label declared by .entry isn't final until the
+ * end of the file, a later line sets its address and may set its type.
+ */
+static int is_label_final(const LabelNode* label_node)
+{
+    switch (label_node->type)
+    {
+    case LABELTYPE_EXTERN:
+    case LABELTYPE_CODE:
+    case LABELTYPE_DATA:
+    case LABELTYPE_CODE_ENTRY:
+    case LABELTYPE_DATA_ENTRY:
+        return VALID_RETURN;
+    default:
+        return INVALID_RETURN;
+    }
+}
+
+/* Patches the word at 'address' with the label of its fix-up */
+static void patch_word(BinaryTable* binary_table, LabelTable* label_table, Fixup* fixup)
+{
+    int node_index = binary_table_search(binary_table,fixup->address);
+    FixupSymbol* symbol = &binary_table->fixups.symbols[fixup->symbol];
+
+    if(node_index != INVALID_RETURN)
+        patch_fixup_word(fixup,binary_table->data[node_index],&label_table->labels[symbol->label]);
+}
+
+/* Patches a word that was written before its label was final */
+static void patch_pending_word(BinaryTable* binary_table, LabelTable* label_table, PendingWord* pending)
+{
+    FixupSymbol* symbol = &binary_table->fixups.symbols[pending->fixup.symbol];
+    BinaryNode binary_node;
+
+    binary_node.address = pending->fixup.address;
+    binary_node.word    = pending->word;
+    patch_fixup_word(&pending->fixup,&binary_node,&label_table->labels[symbol->label]);
+    pending->word       = binary_node.word;
+}
+
+/* Patches every word in the chain of a symbol whose label became final */
+static void patch_pending_words(SinglePass* pass, BinaryTable* binary_table, LabelTable* label_table, FixupSymbol* symbol)
+{
+    unsigned int next = symbol->pending;
+
+    while(next != 0)
+    {
+        PendingWord* pending = &pass->pending[next - 1];
+        patch_pending_word(binary_table,label_table,pending);
+        next = pending->fixup.next_pending;
+        pending->fixup.next_pending = 0;
+    }
+    symbol->pending = 0;
+}
+
+/* Patches the chain of the label at 'label_index', if any word waits for it */
+static void label_defined(SinglePass* pass, BinaryTable* binary_table, LabelTable* label_table, int label_index)
+{
+    FixupList* fixups = &binary_table->fixups;
+    LabelNode* label_node = &label_table->labels[label_index];
+    int symbol_index;
+    FixupSymbol* symbol;
+
+    if((symbol_index = fixup_list_find_symbol(fixups,label_node->name,strlen(label_node->name))) == INVALID_RETURN)
+        return;
+
+    symbol = &fixups->symbols[symbol_index];
+    if(symbol->pending != 0 && symbol_label(symbol,label_table) != INVALID_RETURN && is_label_final(label_node) == VALID_RETURN)
+        patch_pending_words(pass,binary_table,label_table,symbol);
+}
+
+/* Writes a word whose label isn't final yet, and chains it to its label */
+static void add_pending_word(SinglePass* pass, FixupList* fixups, const Fixup* fixup, const BinaryNode* binary_node)
+{
+    FixupSymbol* symbol = &fixups->symbols[fixup->symbol];
+    PendingWord* pending;
+
+    if(pass->pending_count == pass->pending_capacity)
+    {
+        size_t capacity = pass->pending_capacity ? pass->pending_capacity * 2 : DEFAULT_FIXUP_LIST_SIZE;
+        PendingWord* words = (PendingWord*)realloc(pass->pending, capacity * sizeof(PendingWord));
+        if(!words)
+        {
+            log_error(__FILE__,__LINE__,"Failed to resize the pending words of a single pass");
+            exit(EXIT_FAILURE);
+        }
+        pass->pending = words;
+        pass->pending_capacity = capacity;
+    }
+
+    pending = &pass->pending[pass->pending_count++];
+    pending->fixup      = *fixup;
+    pending->word       = binary_node->word;
+    pending->offset     = -1;
+    pending->externals  = pass->externals_count;
+    pending->fixup.next_pending = symbol->pending;
+    symbol->pending     = (unsigned int)pass->pending_count;
+
+    /* a distance that resolves isn't written, the file fails if it doesn't */
+    if(fixup->kind == FIXUP_RELATIVE)
+        return;
+    pending->offset     = pass->words_length;
+    pass->words_length += (long)output_word_line_length(binary_node->address);
+    output_writer_word(&pass->words_writer,binary_node->address,binary_node->word);
+}
+
+/* Writes and releases the words below 'limit' */
+static void flush_words(SinglePass* pass, BinaryTable* binary_table, unsigned int limit)
+{
+    size_t i, next_fixup = 0;
+    FixupList* fixups = &binary_table->fixups;
+
+    for (i = 0; i < binary_table->size; i++)
+    {
+        Fixup* fixup = NULL;
+        BinaryNode* binary_node = binary_table->data[i];
+        if(binary_node == NULL) /* address skipped by the first pass */
+            continue;
+        if(binary_node->address >= limit)
+            break;
+
+        if(next_fixup < fixups->count && fixups->data[next_fixup].address == binary_node->address)
+            fixup = &fixups->data[next_fixup++];
+        if(fixup != NULL && !fixup->resolved)
+        {
+            add_pending_word(pass,fixups,fixup,binary_node);
+            continue;
+        }
+        if(fixup != NULL && fixup->kind == FIXUP_RELATIVE)
+            continue; /* a resolved distance isn't written to the .ob file */
+
+        if(fixup != NULL && fixup->kind == FIXUP_EXTERNAL)
+            pass->externals_count++;
+        pass->words_length += (long)output_word_line_length(binary_node->address);
+        write_binary_node(fixups,fixup,binary_node,&pass->words_writer,&pass->externals_writer);
+    }
+    binary_table_release(binary_table,limit);
+}
+
+/* Opens a temporary file and its writer, for the part of an output file that is only complete at the end of the file */
+static int open_temporary(FILE** file, OutputWriter* writer, const char* filepath)
+{
+    *file = tmpfile();
+    if(*file == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to open a temporary file for [%s]\n", filepath);
+        add_error_entry(ErrorType_OpenFileFailure,__FILE__,__LINE__);
+    }
+    output_writer_open(writer,*file);
+    return (*file == NULL) ? INVALID_RETURN : VALID_RETURN;
+}
+
+/* Rewrites the records of the words that were patched after they were written */
+static void rewrite_pending_words(SinglePass* pass)
+{
+    size_t i;
+
+    if(pass->words == NULL || output_writer_flush(&pass->words_writer) == INVALID_RETURN)
+        return;
+    for (i = 0; i < pass->pending_count; i++)
+    {
+        PendingWord* pending = &pass->pending[i];
+        if(pending->offset < 0 || !pending->fixup.resolved)
+            continue;
+        if(fseek(pass->words,pending->offset,SEEK_SET) != 0)
+            break;
+        output_writer_word(&pass->words_writer,pending->fixup.address,pending->word);
+        output_writer_flush(&pass->words_writer);
+    }
+}
+
+/* Writes the .ext lines of the words that waited for an external label, up to the one written with the words at 'line' */
+static size_t write_pending_externals(SinglePass* pass, const FixupList* fixups, size_t next, size_t line)
+{
+    for (; next < pass->pending_count && pass->pending[next].externals <= line; next++)
+    {
+        const Fixup* fixup = &pass->pending[next].fixup;
+        if(fixup->kind == FIXUP_EXTERNAL)
+            output_writer_label(&pass->ext_writer,fixups->symbols[fixup->symbol].name,fixup->address);
+    }
+    return next;
+}
+
+/* Writes the .ext file, the lines of the words that waited for a label go between the ones written with the words */
+static void write_externals(SinglePass* pass, const FixupList* fixups)
+{
+    size_t line = 0, next = 0;
+
+    output_writer_close(&pass->externals_writer);
+    if(pass->externals != NULL)
+    {
+        char buffer[BUFSIZ];
+        size_t length;
+        int line_start = 1;
+
+        rewind(pass->externals);
+        while((length = fread(buffer,sizeof(char),sizeof(buffer),pass->externals)) > 0)
+        {
+            const char* start = buffer;
+            const char* end = buffer + length;
+
+            while(start < end)
+            {
+                const char* line_end;
+                if(line_start)
+                    next = write_pending_externals(pass,fixups,next,line);
+                line_end = (const char*)memchr(start,NEW_LINE,end - start);
+                line_start = (line_end != NULL);
+                if(line_end == NULL)
+                    line_end = end - 1;
+                else
+                    line++;
+                output_writer_write(&pass->ext_writer,start,line_end + 1 - start);
+                start = line_end + 1;
+            }
+        }
+        fclose(pass->externals);
+    }
+    write_pending_externals(pass,fixups,next,(size_t)-1);
+}
+
+int single_pass_begin(SinglePass* pass, const char* filepath)
+{
+    int flag = VALID_RETURN;
+
+    if(prepare_output_files(filepath,&pass->ob_writer,&pass->ent_writer,&pass->ext_writer) == INVALID_RETURN)
+        flag = INVALID_RETURN;
+
+    /* the .ob header holds ICF and DCF, and a word may be patched after it was written */
+    if(open_temporary(&pass->words,&pass->words_writer,filepath) == INVALID_RETURN)
+        flag = INVALID_RETURN;
+    /* a word that waited for an external label has its .ext line written at the end */
+    if(open_temporary(&pass->externals,&pass->externals_writer,filepath) == INVALID_RETURN)
+        flag = INVALID_RETURN;
+
+    pass->words_length      = 0;
+    pass->externals_count   = 0;
+    pass->pending           = NULL;
+    pass->pending_count     = 0;
+    pass->pending_capacity  = 0;
+    pass->next_address      = START_ADDRESS;
+    pass->label_count       = 0;
+    return flag;
+}
+
+void single_pass_line(SinglePass* pass, BinaryTable* binary_table, LabelTable* label_table, const char* line, unsigned int TC)
+{
+    FixupList* fixups = &binary_table->fixups;
+    unsigned int i;
+    size_t j;
+    Token token;
+    int label_index;
+
+    /* the words the line added whose label is final are patched, the others wait for it once they are written */
+    for (j = fixups->count; j > 0 && fixups->data[j - 1].address >= pass->next_address; j--)
+    {
+        Fixup* fixup = &fixups->data[j - 1];
+        int label = symbol_label(&fixups->symbols[fixup->symbol],label_table);
+
+        if(label != INVALID_RETURN && is_label_final(&label_table->labels[label]) == VALID_RETURN)
+            patch_word(binary_table,label_table,fixup);
+    }
+
+    /* the labels the line added (a definition or .extern), and the label it defined (.entry ones are added earlier) */
+    for (i = pass->label_count; i < label_table->size; i++)
+        label_defined(pass,binary_table,label_table,(int)i);
+    if(next_token(line,0,&token) != INVALID_RETURN && token_last_char(&token) == COLON &&
+        (label_index = label_table_search_n(label_table,token.text,token.length - 1)) != INVALID_RETURN)
+    {
+        label_defined(pass,binary_table,label_table,label_index);
+    }
+
+    flush_words(pass,binary_table,TC);
+
+    pass->next_address  = TC;
+    pass->label_count   = label_table->size;
+}
+
+int single_pass_end(SinglePass* pass, BinaryTable* binary_table, LabelTable* label_table, int ICF, int DCF)
+{
+    int flag = VALID_RETURN;
+    size_t i;
+    FixupList* fixups = &binary_table->fixups;
+
+    /* the words that still wait for a label are resolved the way the second pass does */
+    flush_words(pass,binary_table,pass->next_address);
+    for (i = 0; i < pass->pending_count; i++)
+    {
+        PendingWord* pending = &pass->pending[i];
+        if(pending->fixup.resolved)
+            continue;
+        if(symbol_label(&fixups->symbols[pending->fixup.symbol],label_table) == INVALID_RETURN)
+        {
+            add_error_entry(ErrorType_InvalidLabel_UndefinedLabel,NULL,pending->fixup.address);
+            flag = INVALID_RETURN;
+        }
+        else
+        {
+            patch_pending_word(binary_table,label_table,pending);
+        }
+    }
+    rewrite_pending_words(pass);
+    output_writer_close(&pass->words_writer);
+
+    if(pass->words != NULL)
+    {
+        char buffer[BUFSIZ];
+        size_t length;
+
+        output_writer_header(&pass->ob_writer,ICF,DCF);
+        rewind(pass->words);
+        while((length = fread(buffer,sizeof(char),sizeof(buffer),pass->words)) > 0)
+            output_writer_write(&pass->ob_writer,buffer,length);
+        fclose(pass->words);
+    }
+    write_externals(pass,fixups);
+    free(pass->pending);
+
+    if(flag != INVALID_RETURN)
+        handle_entries(label_table,&pass->ent_writer);
+
+    close_output_files(flag,&pass->ob_writer,&pass->ent_writer,&pass->ext_writer);
+
+    if(is_errors_array_empty() == INVALID_RETURN)
+    {
+        print_errors_array();
+        clean_errors_array();
+        flag = INVALID_RETURN;
+    }
+
+    binary_table_destroy(binary_table);
+    label_table_destroy(label_table);
+    return flag;
+}
@@ -0,0 +1,91 @@
+#ifndef SINGLE_PASS_H
+#define SINGLE_PASS_H
+
+#include <stdio.h>
+#include "label_table.h"
+#include "binary_table.h"
+#include "output_writer.h"
+
+/**
+ * @brief A word written before the label it references was final.
+ */
+typedef struct PendingWord
+{
+    Fixup fixup;        /* The fix-up of the word, its next_pending links the chain of its label. */
+    wordfield word;     /* The word, patched once its label is final. */
+    long offset;        /* Offset of the record of the word in SinglePass.words, -1 for a distance that isn't written. */
+    size_t externals;   /* Number of .ext lines written before the word. */
+} PendingWord;
+
+/**
+ * @brief The state of a file assembled in a single pass.
+ *
+ * Instead of keeping every word until a second pass, the words of each line are written
+ * to a temporary file as soon as the line is done, and released from the binary table.
+ * A word whose label isn't final yet is written with a record of the same width, and
+ * kept as a PendingWord in the chain of its label (FixupSymbol.pending, linked through
+ * Fixup.next_pending, both hold the index of the word plus 1). The chain is patched as
+ * soon as the label is defined, and the records of the patched words are rewritten in
+ * place at the end of the file. Memory follows the forward references rather than the
+ * size of the program.
+ *
+ * The .ext lines are written with the words, except for the words that waited for an
+ * external label, whose lines are merged in address order at the end of the file.
+ */
+typedef struct SinglePass
+{
+    OutputWriter ob_writer;         /* Writer of the .ob file, it's only written at the end of the file. */
+    OutputWriter ent_writer;        /* Writer of the .ent file, it's only written at the end of the file. */
+    OutputWriter ext_writer;        /* Writer of the .ext file, it's only written at the end of the file. */
+    FILE* words;                    /* The words of the .ob file, copied after its header at the end of the file. */
+    OutputWriter words_writer;      /* Writer of the words. */
+    long words_length;              /* Number of characters written to the words. */
+    FILE* externals;                /* The .ext lines written with the words. */
+    OutputWriter externals_writer;  /* Writer of the .ext lines. */
+    size_t externals_count;         /* Number of .ext lines written with the words. */
+    PendingWord* pending;           /* The words written before their label was final, in address order. */
+    size_t pending_count;
+    size_t pending_capacity;
+    unsigned int next_address;      /* The first address that wasn't added when the last line was done. */
+    unsigned int label_count;       /* Number of labels when the last line was done. */
+} SinglePass;
+
+/**
+ * @brief Prepares the output writers of a file assembled in a single pass.
+ * @param pass      Pointer to the SinglePass.
+ * @param filepath  The source file path, used to derive output filenames.
+ * @return VALID_RETURN on success, INVALID_RETURN if a file couldn't be opened.
+ */
+int single_pass_begin(SinglePass* pass, const char* filepath);
+
+/**
+ * @brief Backpatches after a line of the first pass, and writes the words of the line.
+ *
+ * The words the line added are patched if their label is final, or wait in the chain
+ * of their label. The chains of the labels the line defined are patched.
+ *
+ * @param pass          Pointer to the SinglePass.
+ * @param binary_table  The binary table of the file.
+ * @param label_table   The label table of the file.
+ * @param line          The line that was just assembled.
+ * @param TC            The total counter after the line.
+ */
+void single_pass_line(SinglePass* pass, BinaryTable* binary_table, LabelTable* label_table, const char* line, unsigned int TC);
+
+/**
+ * @brief Resolves the words still waiting for a label, and writes the output files.
+ *
+ * Reports the labels that were never defined, rewrites the records of the patched words,
+ * writes the .ob header and words, the .ent and .ext files, and cleans up the output
+ * files the way the second pass does. Destroys both tables.
+ *
+ * @param pass          Pointer to the SinglePass.
+ * @param binary_table  The binary table of the file.
+ * @param label_table   The label table of the file.
+ * @param ICF           Final instruction counter value.
+ * @param DCF           Final data counter value.
+ * @return VALID_RETURN on success, or INVALID_RETURN if any error occurred.
+ */
+int single_pass_end(SinglePass* pass, BinaryTable* binary_table, LabelTable* label_table, int ICF, int DCF);
+
+#endif /* SINGLE_PASS_H */
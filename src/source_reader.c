@@ -0,0 +1,129 @@
+#define _POSIX_C_SOURCE 200112L
+#include "source_reader.h"
+#include "common.h"
+#include "logger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Reads the rest of 'fd' in SOURCE_READ_BLOCK_SIZE blocks into reader->block_data */
+static int read_blocks(SourceReader* reader, int fd, size_t size_hint)
+{
+    size_t capacity = (size_hint > 0) ? size_hint + 1 : SOURCE_READ_BLOCK_SIZE;
+    size_t length   = 0;
+    char* data      = malloc(capacity);
+    ssize_t count;
+
+    if (data == NULL)
+    {
+        log_error(__FILE__,__LINE__, "Failed to allocate the source buffer.\n");
+        return INVALID_RETURN;
+    }
+
+    for (;;)
+    {
+        if (capacity - length < SOURCE_READ_BLOCK_SIZE)
+        {
+            char* grown = realloc(data, capacity * 2 + SOURCE_READ_BLOCK_SIZE);
+            if (grown == NULL)
+            {
+                log_error(__FILE__,__LINE__, "Failed to grow the source buffer.\n");
+                free(data);
+                return INVALID_RETURN;
+            }
+            data = grown;
+            capacity = capacity * 2 + SOURCE_READ_BLOCK_SIZE;
+        }
+        count = read(fd, data + length, SOURCE_READ_BLOCK_SIZE);
+        if (count < 0)
+        {
+            log_error(__FILE__,__LINE__, "Failed to read the source.\n");
+            free(data);
+            return INVALID_RETURN;
+        }
+        if (count == 0)
+            break;
+        length += count;
+    }
+
+    reader->block_data  = data;
+    reader->data        = data;
+    reader->length      = length;
+    return VALID_RETURN;
+}
+
+/* Opens a source file, mapped when 'map' is set and the file can be mapped, read in blocks otherwise */
+static int open_file(SourceReader* reader, const char* filepath, int map)
+{
+    struct stat info;
+    int fd;
+    int result = VALID_RETURN;
+
+    source_reader_open_buffer(reader, NULL, 0);
+    fd = open(filepath, O_RDONLY);
+    if (fd < 0)
+        return INVALID_RETURN;
+
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 && map)
+    {
+        void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+            reader->mapping = mapping;
+            reader->data    = mapping;
+            reader->length  = (size_t)info.st_size;
+        }
+        else
+        {
+            result = read_blocks(reader, fd, (size_t)info.st_size);
+        }
+    }
+    else
+    {
+        result = read_blocks(reader, fd, 0);
+    }
+
+    close(fd);
+    return result;
+}
+
+int source_reader_open(SourceReader* reader, const char* filepath)
+{
+    return open_file(reader, filepath, 1);
+}
+
+int source_reader_open_copy(SourceReader* reader, const char* filepath)
+{
+    return open_file(reader, filepath, 0);
+}
+
+void source_reader_open_buffer(SourceReader* reader, const char* data, size_t length)
+{
+    reader->data        = data;
+    reader->length      = length;
+    reader->offset      = 0;
+    reader->mapping     = NULL;
+    reader->block_data  = NULL;
+}
+
+void source_reader_close(SourceReader* reader)
+{
+    if (reader->mapping != NULL)
+        munmap(reader->mapping, reader->length);
+    free(reader->block_data);
+    source_reader_open_buffer(reader, NULL, 0);
+}
+
+int source_reader_next_line(SourceReader* reader, LineView* view)
+{
+    return next_line_view(reader->data, reader->length, &reader->offset, view);
+}
+
+int source_reader_read_line(SourceReader* reader, char* line)
+{
+    return read_line_from_buffer(reader->data, reader->length, &reader->offset, line);
+}
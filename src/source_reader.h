@@ -0,0 +1,78 @@
+#ifndef SOURCE_READER_H
+#define SOURCE_READER_H
+
+#include <stddef.h>
+#include "input.h"
+
+/** @brief Size of the blocks a source is read in when it can't be memory mapped. */
+#define SOURCE_READ_BLOCK_SIZE 65536
+
+/**
+ * @brief Hands out the lines of a source file as views into memory.
+ *
+ * The whole source is memory mapped, or read in large blocks when mapping isn't
+ * possible (pipes, empty files), so lines are found with a single scan of the
+ * memory instead of one stdio call per character.
+ */
+typedef struct SourceReader
+{
+    const char* data;       /* the contents of the source */
+    size_t      length;     /* number of characters in the source */
+    size_t      offset;     /* position of the next line */
+    void*       mapping;    /* the mapped source, NULL if it was not mapped */
+    char*       block_data; /* the source read in blocks, NULL if it was mapped */
+} SourceReader;
+
+/**
+ * @brief Opens a source file for reading
+ * @param reader    the reader to initialize
+ * @param filepath  the file to open
+ * @return VALID_RETURN on success, INVALID_RETURN if the file could not be opened or read
+ */
+int source_reader_open(SourceReader* reader, const char* filepath);
+
+/**
+ * @brief Opens a source file by reading it into memory, it's never mapped
+ *
+ * A mapped file that is truncated while it's read raises SIGBUS, so a process
+ * that must survive the files it reads changing under it (the daemon, the watch)
+ * reads a copy instead.
+ *
+ * @param reader    the reader to initialize
+ * @param filepath  the file to open
+ * @return VALID_RETURN on success, INVALID_RETURN if the file could not be opened or read
+ */
+int source_reader_open_copy(SourceReader* reader, const char* filepath);
+
+/**
+ * @brief Reads a source that is already in memory, the buffer is not copied
+ * @param reader    the reader to initialize
+ * @param data      the source, must outlive the reader
+ * @param length    number of characters in the source
+ */
+void source_reader_open_buffer(SourceReader* reader, const char* data, size_t length);
+
+/**
+ * @brief Releases the memory of the source, the line views become invalid
+ * @param reader the reader to close
+ */
+void source_reader_close(SourceReader* reader);
+
+/**
+ * @brief Returns the next line of the source without copying it
+ * @param reader    the reader
+ * @param view      receives the line, of any length
+ * @return VALID_RETURN on success or INVALID_RETURN when reaching the end of the source.
+ */
+int source_reader_next_line(SourceReader* reader, LineView* view);
+
+/**
+ * @brief Reads the next line into a line buffer, with the same truncation and
+ *        end of file behaviour as read_line
+ * @param reader    the reader
+ * @param line      receives the line, must hold MAX_LINE characters
+ * @return VALID_RETURN on success or INVALID_RETURN when reaching the end of the source.
+ */
+int source_reader_read_line(SourceReader* reader, char* line);
+
+#endif
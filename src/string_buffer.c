@@ -0,0 +1,83 @@
+#include "string_buffer.h"
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "logger.h"
+
+/* Makes room for 'extra' more characters plus the null terminator */
+static int string_buffer_reserve(StringBuffer* buffer, size_t extra)
+{
+    char* new_data;
+    size_t new_capacity = buffer->capacity;
+
+    if (buffer->length + extra < buffer->capacity)
+        return VALID_RETURN;
+
+    while (buffer->length + extra >= new_capacity)
+        new_capacity *= 2;
+
+    new_data = realloc(buffer->data, new_capacity);
+    if (new_data == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to grow StringBuffer\n");
+        return INVALID_RETURN;
+    }
+
+    buffer->data = new_data;
+    buffer->capacity = new_capacity;
+    return VALID_RETURN;
+}
+
+int string_buffer_init(StringBuffer* buffer, size_t initial_capacity)
+{
+    buffer->length   = 0;
+    buffer->capacity = (initial_capacity > 0) ? initial_capacity : DEFAULT_STRING_BUFFER_SIZE;
+    buffer->data     = malloc(buffer->capacity);
+    if (buffer->data == NULL)
+    {
+        log_error(__FILE__,__LINE__,"Failed to allocate StringBuffer\n");
+        buffer->capacity = 0;
+        return INVALID_RETURN;
+    }
+    buffer->data[0] = NULL_TERMINATOR;
+    return VALID_RETURN;
+}
+
+void string_buffer_free(StringBuffer* buffer)
+{
+    if (buffer == NULL)
+        return;
+
+    free(buffer->data);
+    buffer->data     = NULL;
+    buffer->length   = 0;
+    buffer->capacity = 0;
+}
+
+void string_buffer_clear(StringBuffer* buffer)
+{
+    buffer->length = 0;
+    if (buffer->data)
+        buffer->data[0] = NULL_TERMINATOR;
+}
+
+int string_buffer_append(StringBuffer* buffer, const char* str, size_t length)
+{
+    if (buffer->data == NULL || string_buffer_reserve(buffer, length) == INVALID_RETURN)
+        return INVALID_RETURN;
+
+    memcpy(buffer->data + buffer->length, str, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = NULL_TERMINATOR;
+    return VALID_RETURN;
+}
+
+int string_buffer_append_str(StringBuffer* buffer, const char* str)
+{
+    return string_buffer_append(buffer, str, strlen(str));
+}
+
+int string_buffer_append_char(StringBuffer* buffer, char ch)
+{
+    return string_buffer_append(buffer, &ch, 1);
+}
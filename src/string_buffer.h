@@ -0,0 +1,67 @@
+#ifndef STRING_BUFFER_H
+#define STRING_BUFFER_H
+
+#include <stddef.h>
+
+/** @brief Default capacity for a StringBuffer. */
+#define DEFAULT_STRING_BUFFER_SIZE 128
+
+/**
+ * @brief A growable, null-terminated character buffer with a tracked length.
+ *
+ * Appending never rescans the existing contents and the capacity doubles when
+ * full, so building a buffer of n bytes costs O(n) in total.
+ */
+typedef struct StringBuffer
+{
+    char* data;         /* The characters, always null-terminated. */
+    size_t length;      /* Number of characters stored, not including the null terminator. */
+    size_t capacity;    /* Allocated size of data. */
+} StringBuffer;
+
+/**
+ * @brief Initializes an empty StringBuffer.
+ * @param buffer            Pointer to the StringBuffer.
+ * @param initial_capacity  Initial capacity (DEFAULT_STRING_BUFFER_SIZE if 0).
+ * @return VALID_RETURN on success, INVALID_RETURN if the allocation failed.
+ */
+int string_buffer_init(StringBuffer* buffer, size_t initial_capacity);
+
+/**
+ * @brief Frees the memory owned by a StringBuffer.
+ * @param buffer Pointer to the StringBuffer.
+ */
+void string_buffer_free(StringBuffer* buffer);
+
+/**
+ * @brief Empties a StringBuffer, keeping its capacity.
+ * @param buffer Pointer to the StringBuffer.
+ */
+void string_buffer_clear(StringBuffer* buffer);
+
+/**
+ * @brief Appends @p length characters of @p str to the end of the buffer.
+ * @param buffer Pointer to the StringBuffer.
+ * @param str    The characters to append.
+ * @param length Number of characters to append.
+ * @return VALID_RETURN on success, INVALID_RETURN if the buffer could not grow.
+ */
+int string_buffer_append(StringBuffer* buffer, const char* str, size_t length);
+
+/**
+ * @brief Appends a null-terminated string to the end of the buffer.
+ * @param buffer Pointer to the StringBuffer.
+ * @param str    The string to append.
+ * @return VALID_RETURN on success, INVALID_RETURN if the buffer could not grow.
+ */
+int string_buffer_append_str(StringBuffer* buffer, const char* str);
+
+/**
+ * @brief Appends a single character to the end of the buffer.
+ * @param buffer Pointer to the StringBuffer.
+ * @param ch     The character to append.
+ * @return VALID_RETURN on success, INVALID_RETURN if the buffer could not grow.
+ */
+int string_buffer_append_char(StringBuffer* buffer, char ch);
+
+#endif /* STRING_BUFFER_H */
@@ -0,0 +1,184 @@
+#include "tokenizer.h"
+#include "common.h"
+#include "logger.h"
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+static TokenKind get_token_kind(char first)
+{
+    switch (first)
+    {
+    case '.':           return TOKEN_KIND_DIRECTIVE;
+    case HASHTAG:       return TOKEN_KIND_IMMEDIATE;
+    case AMPERSAND:     return TOKEN_KIND_RELATIVE;
+    case DOUBLE_QUOTE:  return TOKEN_KIND_STRING;
+    case COMMA:         return TOKEN_KIND_COMMA;
+    default:            return TOKEN_KIND_WORD;
+    }
+}
+
+int next_token(const char* line, int position, Token* token)
+{
+    int i = position;
+
+    token->text     = line;
+    token->length   = 0;
+    token->end      = INVALID_RETURN;
+    token->kind     = TOKEN_KIND_WORD;
+    if (i < 0)
+        return INVALID_RETURN;
+
+    while (line[i] != NULL_TERMINATOR && isspace((unsigned char)line[i]))
+        i++;
+
+    token->text = line + i;
+    while (line[i] != NULL_TERMINATOR && !isspace((unsigned char)line[i]))
+        i++;
+
+    token->length = (int)(line + i - token->text);
+    if (token->length == 0)
+        return INVALID_RETURN;
+
+    token->end  = i;
+    token->kind = get_token_kind(token->text[0]);
+    return i;
+}
+
+void token_drop_first(Token* token)
+{
+    if (token->length == 0)
+        return;
+    token->text++;
+    token->length--;
+    token->kind = (token->length > 0) ? get_token_kind(token->text[0]) : TOKEN_KIND_WORD;
+}
+
+void token_drop_last(Token* token)
+{
+    if (token->length > 0)
+        token->length--;
+}
+
+char token_last_char(const Token* token)
+{
+    return (token->length > 0) ? token->text[token->length - 1] : NULL_TERMINATOR;
+}
+
+int token_equals(const Token* token, const char* str)
+{
+    return strncmp(token->text, str, token->length) == 0 && str[token->length] == NULL_TERMINATOR;
+}
+
+char* token_strdup(const Token* token)
+{
+    char* copy = malloc(token->length + 1);
+    if (copy == NULL)
+    {
+        log_error(__FILE__,__LINE__, "Failed to allocate a copy of a token.\n");
+        return NULL;
+    }
+    memcpy(copy, token->text, token->length);
+    copy[token->length] = NULL_TERMINATOR;
+    return copy;
+}
+
+int token_to_int(const Token* token)
+{
+    /* follows strtol, which atoi is defined by: out of range values saturate */
+    unsigned long limit;
+    unsigned long value = 0;
+    int negative        = 0;
+    int overflow        = 0;
+    int i               = 0;
+
+    if (i < token->length && (token->text[i] == DASH || token->text[i] == '+'))
+        negative = (token->text[i++] == DASH);
+    limit = negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+
+    for (; i < token->length && isdigit((unsigned char)token->text[i]); i++)
+    {
+        unsigned long digit = token->text[i] - '0';
+        if (overflow || value > (limit - digit) / 10)
+            overflow = 1;
+        else
+            value = value * 10 + digit;
+    }
+
+    if (overflow)
+        return (int)(negative ? LONG_MIN : LONG_MAX);
+    return (int)(negative ? -(long)(value - 1) - 1 : (long)value);
+}
+
+KeywordKind token_classify(const Token* token, Keyword* keyword)
+{
+    return classify_keyword(token->text, token->length, keyword);
+}
+
+int token_is_instruction(const Token* token)
+{
+    return (token_classify(token, NULL) == KEYWORD_INSTRUCTION) ? VALID_RETURN : INVALID_RETURN;
+}
+
+int token_is_directive(const Token* token)
+{
+    return (token_classify(token, NULL) == KEYWORD_DIRECTIVE) ? VALID_RETURN : INVALID_RETURN;
+}
+
+int token_is_register(const Token* token)
+{
+    return (token_classify(token, NULL) == KEYWORD_REGISTER) ? VALID_RETURN : INVALID_RETURN;
+}
+
+int token_is_label(const Token* token)
+{
+    const char* text = token->text;
+    int i;
+
+    if ((token->length + 1) > MAX_LABEL_LENGTH) /* + 1 for '\0' */
+        return INVALID_RETURN;
+
+    if (token->length == 1)
+        return (isalpha((unsigned char)text[0]) && text[0] != UNDERSCORE) ? VALID_RETURN : INVALID_RETURN;
+
+    if (token->length == 0 || token_is_register(token) != INVALID_RETURN)
+        return INVALID_RETURN;
+
+    if (!isalpha((unsigned char)text[0]) && text[0] != UNDERSCORE) /* make sure first letter is legal */
+        return INVALID_RETURN;
+
+    /* check other letters not including the last letter, as is_label */
+    for (i = 1; i < token->length - 1; i++)
+    {
+        if (!isalpha((unsigned char)text[i]) && !isdigit((unsigned char)text[i]) && text[i] != UNDERSCORE)
+            return INVALID_RETURN;
+    }
+    return VALID_RETURN;
+}
+
+int token_is_valid_number(const Token* token)
+{
+    int i = 0;
+
+    if (token->length == 0)
+        return INVALID_RETURN;
+
+    if (token->text[0] == DASH)
+    {
+        i++;
+        if (token->length == 1)
+            return INVALID_RETURN;
+    }
+
+    for (; i < token->length; i++)
+    {
+        if (!isdigit((unsigned char)token->text[i]))
+        {
+            log_error(__FILE__,__LINE__,"Error reading immediate value, NAN.\n");
+            return INVALID_RETURN;
+        }
+    }
+    return VALID_RETURN;
+}
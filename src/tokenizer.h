@@ -0,0 +1,120 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <stddef.h>
+#include "keyword.h"
+
+/** @brief Lexical kind of a token, decided by its first character. */
+typedef enum
+{
+    TOKEN_KIND_WORD,        /* a label, an instruction, a register or a number */
+    TOKEN_KIND_DIRECTIVE,   /* starts with '.', I.E: .data */
+    TOKEN_KIND_IMMEDIATE,   /* starts with '#', I.E: #-5 */
+    TOKEN_KIND_RELATIVE,    /* starts with '&', I.E: &LOOP */
+    TOKEN_KIND_STRING,      /* starts with '"' */
+    TOKEN_KIND_COMMA        /* starts with ',', I.E: , or ,r3 */
+} TokenKind;
+
+/**
+ * @brief A whitespace separated token, as a view into the line it was read from.
+ *
+ * The characters are never copied: @p text points into the line and is not null
+ * terminated, so a token is only valid as long as its line is.
+ */
+typedef struct Token
+{
+    const char* text;   /* first character of the token, inside the line */
+    int         length; /* number of characters in the token */
+    int         end;    /* position in the line right after the token */
+    TokenKind   kind;   /* lexical kind of the token */
+} Token;
+
+/**
+ * @brief Reads the next token from a line, the zero-copy counterpart of read_word_from_line.
+ * @param line      The line to read from.
+ * @param position  The position in the line to start reading from.
+ * @param token     Receives the token. When no token is left it is set to an empty token.
+ * @return The position in the line after the token, or INVALID_RETURN if no more tokens are found.
+ */
+int next_token(const char* line, int position, Token* token);
+
+/**
+ * @brief Returns a token without its first character, I.E: '#5' -> '5'.
+ * @param token The token to narrow, an empty token is left empty.
+ */
+void token_drop_first(Token* token);
+
+/**
+ * @brief Returns a token without its last character, I.E: 'MAIN:' -> 'MAIN'.
+ * @param token The token to narrow, an empty token is left empty.
+ */
+void token_drop_last(Token* token);
+
+/**
+ * @brief Returns the last character of a token.
+ * @param token The token.
+ * @return The last character, or NULL_TERMINATOR for an empty token.
+ */
+char token_last_char(const Token* token);
+
+/**
+ * @brief Compares a token with a string.
+ * @param token The token.
+ * @param str   The string to compare with.
+ * @return 1 if they are equal, 0 otherwise.
+ */
+int token_equals(const Token* token, const char* str);
+
+/**
+ * @brief Copies a token into a newly allocated string, for tokens that are stored (label names).
+ * @param token The token to copy.
+ * @return The allocated string, the caller is responsible for freeing it.
+ */
+char* token_strdup(const Token* token);
+
+/**
+ * @brief Converts a token to an integer, exactly like atoi does for the same characters.
+ * @param token The token.
+ * @return The integer value of the leading digits (with an optional sign), 0 if there are none.
+ */
+int token_to_int(const Token* token);
+
+/**
+ * @brief Classifies a token as an instruction, a directive, a register or none of them.
+ * @param token     The token.
+ * @param keyword   Receives the classified word, may be NULL when only the kind is needed.
+ * @return The kind of the token, KEYWORD_NONE if it is not a reserved word.
+ */
+KeywordKind token_classify(const Token* token, Keyword* keyword);
+
+/**
+ * @brief Checks if a token is an instruction name (case insensitive), like is_instruction.
+ * @return VALID_RETURN if it is, INVALID_RETURN otherwise.
+ */
+int token_is_instruction(const Token* token);
+
+/**
+ * @brief Checks if a token is a directive name (with or without the dot), like is_directive.
+ * @return VALID_RETURN if it is, INVALID_RETURN otherwise.
+ */
+int token_is_directive(const Token* token);
+
+/**
+ * @brief Checks if a token is a register name (r0 - r7), like is_register.
+ * @return VALID_RETURN if it is, INVALID_RETURN otherwise.
+ */
+int token_is_register(const Token* token);
+
+/**
+ * @brief Checks if a token is a valid label name, like is_label.
+ * @return VALID_RETURN if it is, INVALID_RETURN otherwise.
+ */
+int token_is_label(const Token* token);
+
+/**
+ * @brief Checks if a token is a valid decimal number with an optional '-', like is_valid_number.
+ * @return VALID_RETURN if it is, INVALID_RETURN otherwise.
+ */
+int token_is_valid_number(const Token* token);
+
+#endif /* TOKENIZER_H */
@@ -4,6 +4,7 @@
 #include <string.h>
 #include "logger.h"
 #include "error_manager.h"
+#include "keyword.h"
 
 char* get_filename(char* file)
 {
@@ -125,6 +126,22 @@ char* my_strdup(const char* s)
     return copy;
 }
 
+char* my_strndup(const char* s, size_t length)
+{
+    char *copy = NULL;
+
+    if (s == NULL) 
+        return NULL;
+
+    copy = malloc(length + 1);
+    if (copy) 
+    {
+        memcpy(copy, s, length);
+        copy[length] = NULL_TERMINATOR;
+    }
+    return copy;
+}
+
 void remove_last_character(char *s)
 {
     int len = strlen(s);
@@ -194,6 +211,23 @@ char* int_to_hex(int number)
     return hex_str;
 }
 
+unsigned long hash_string(const char* str)
+{
+    return hash_string_n(str, strlen(str));
+}
+
+unsigned long hash_string_n(const char* str, size_t length)
+{
+    unsigned long hash = 2166136261UL;
+    size_t i = 0;
+    for (; i < length; i++)
+    {
+        hash ^= (unsigned char)str[i];
+        hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return hash;
+}
+
 void str_to_lower(char* str)
 {
     int i = 0;
@@ -271,78 +305,23 @@ int is_label(const char* word)
 
 int is_register(const char* word)
 {
-    int i;
-    char* str = my_strdup(word);
-    static char* registers[MAX_REGISTERS] = { "r0", "r1","r2", "r3", "r4", "r5", "r6", "r7"};
-
     if(word == NULL)
-    {
-        free(str);
         return INVALID_RETURN;
-    }
-    
-    for(i = 0; i < MAX_REGISTERS; i++)
-    {   
-        str_to_lower(str);
-        if(strcmp(word,registers[i]) == 0)
-        {
-            free(str);
-            return VALID_RETURN;
-        }   
-    }
-    free(str);
-    return INVALID_RETURN;
+    return (classify_keyword(word,strlen(word),NULL) == KEYWORD_REGISTER) ? VALID_RETURN : INVALID_RETURN;
 }
 
 int is_instruction(const char* word)
 {
-    int i;
-    char* str = my_strdup(word);
-    static const char* instructions[MAX_INSTRUCTIONS] = 
-    { "mov", "cmp","add", "sub", "lea", "clr", "not", "inc", "dec", "jmp", "bne", "jsr", "red", "prn", "rts", "stop"};
-    
     if(word == NULL)
-    {
-        free(str);
         return INVALID_RETURN;
-    }
-
-    for(i = 0; i < MAX_INSTRUCTIONS; i++)
-    {   
-        str_to_lower(str);
-        if(strcmp(str,instructions[i]) == 0)
-        {
-            free(str);
-            return VALID_RETURN;
-        }   
-    }
-    free(str);
-    return INVALID_RETURN;
+    return (classify_keyword(word,strlen(word),NULL) == KEYWORD_INSTRUCTION) ? VALID_RETURN : INVALID_RETURN;
 }
 
 int is_directive(const char* word)
 {
-    int i;
-    char* str = my_strdup(word);
-    static const char* directives[MAX_DIRECTIVES] = 
-    { ".data", ".string",".extern", ".entry", "data", "string", "extern", "entry"};
-    
     if(word == NULL)
-    {
-        free(str);
         return INVALID_RETURN;
-    }
-
-    for(i = 0; i < MAX_DIRECTIVES; i++)
-    {   
-        if(strcmp(word,directives[i]) == 0)
-        {
-            free(str);
-            return VALID_RETURN;
-        }   
-    }
-    free(str);
-    return INVALID_RETURN;
+    return (classify_keyword(word,strlen(word),NULL) == KEYWORD_DIRECTIVE) ? VALID_RETURN : INVALID_RETURN;
 }
 
 int is_line_empty(char* line) 
@@ -61,6 +61,14 @@ char* string_malloc(size_t size);
  */
 char* my_strdup(const char* src);
 
+/**
+ * @brief Duplicates the first @p length characters of a string into a new null terminated string.
+ * @param src       The characters to duplicate, not necessarily null terminated.
+ * @param length    The number of characters to duplicate.
+ * @return A pointer to the newly allocated copy, or NULL on failure.
+ */
+char* my_strndup(const char* src, size_t length);
+
 /**
  * @brief Removes the last character from a string.
  * @param s The string to modify.
@@ -88,6 +96,22 @@ char* strncpy_from_pos(char* src, unsigned int pos);
  */
 char* int_to_hex(int number);
 
+/**
+ * @brief Hashes a string with 32-bit FNV-1a, used by the label and macro tables.
+ * @param str The string to hash.
+ * @return The hash value of @p str.
+ */
+unsigned long hash_string(const char* str);
+
+/**
+ * @brief Hashes the first @p length characters of a string with 32-bit FNV-1a,
+ *        giving the same value hash_string gives for a string of those characters.
+ * @param str       The characters to hash, not necessarily null terminated.
+ * @param length    The number of characters to hash.
+ * @return The hash value.
+ */
+unsigned long hash_string_n(const char* str, size_t length);
+
 /**
  * @brief Converts a char* to lowercase letters
  * @param str newly allocated string holding the hex representation, or NULL on failure.  
@@ -4,54 +4,74 @@
 #include "logger.h"
 #include <stdlib.h>
 
-void print_wordfield(wordfield* w)
+/* prints the 'bits' low bits of a field, most significant first */
+static void print_field_bits(FILE* out, unsigned int field, int bits)
 {
     int i;
-    
-    if(w == NULL)
-        return;
-    
-    printf("|");
-    for (i = 5; i >= 0; i--) { printf("%d", (w->opcode >> i) & 1); }
-    printf("|");
-    for (i = 1; i >= 0; i--) { printf("%d", (w->src_mode >> i) & 1); }
-    printf("|");
-    for (i = 2; i >= 0; i--) { printf("%d", (w->src_reg >> i) & 1); }
-    printf("|");
-    for (i = 1; i >= 0; i--) { printf("%d", (w->dest_mode >> i) & 1); }
-    printf("|");
-    for (i = 2; i >= 0; i--) { printf("%d", (w->dest_reg >> i) & 1); }
-    printf("|");
-    for (i = 4; i >= 0; i--) { printf("%d", (w->funct >> i) & 1); }
-    printf("|");
-    for (i = 2; i >= 0; i--) { printf("%d", (w->are >> i) & 1); }
-    printf("|");
-    printf("\n");
+    for (i = bits - 1; i >= 0; i--) { fprintf(out, "%u", (field >> i) & 1); }
+    fputc('|', out);
 }
 
-wordfield* init_wordfield()
+void print_wordfield(wordfield w)
 {
-    wordfield* word = calloc(1,sizeof(wordfield));
-    if (word == NULL)
-    {
-        log_error(__FILE__,__LINE__,"Failed to allocate memory for wordfield\n");
-        return NULL;
-    }
-    return word;
+    FILE* out = log_output_stream();
+
+    fputc('|', out);
+    print_field_bits(out, WORD_FIELD(w, WORD_OPCODE_SHIFT, MASK_SIX_BITS), 6);
+    print_field_bits(out, WORD_FIELD(w, WORD_SRC_MODE_SHIFT, MASK_TWO_BITS), 2);
+    print_field_bits(out, WORD_FIELD(w, WORD_SRC_REG_SHIFT, MASK_THREE_BITS), 3);
+    print_field_bits(out, WORD_FIELD(w, WORD_DEST_MODE_SHIFT, MASK_TWO_BITS), 2);
+    print_field_bits(out, WORD_FIELD(w, WORD_DEST_REG_SHIFT, MASK_THREE_BITS), 3);
+    print_field_bits(out, WORD_FIELD(w, WORD_FUNCT_SHIFT, MASK_FIVE_BITS), 5);
+    print_field_bits(out, WORD_FIELD(w, WORD_ARE_SHIFT, MASK_THREE_BITS), 3);
+    fputc('\n', out);
 }
 
+/* The operand slots an instruction accepts, OPERAND_NONE stands for an operand it doesn't have */
+#define TEMPLATE_SRC_SLOTS(operands, src_modes) \
+    ((src_modes) | (((operands) < TWO_OPERANDS_INSTRUCTION) ? ISA_MODE(OPERAND_NONE) : 0u))
+#define TEMPLATE_DEST_SLOTS(operands, dest_modes) \
+    ((dest_modes) | (((operands) == NO_OPERANDS_INSTRUCTION) ? ISA_MODE(OPERAND_NONE) : 0u))
+
+/* The template of one combination, the mode bits of a missing operand are zero */
+#define TEMPLATE_WORD(opcode, funct, operands, src_modes, dest_modes, src, dest) \
+    ((((TEMPLATE_SRC_SLOTS(operands, src_modes) >> (src)) & (TEMPLATE_DEST_SLOTS(operands, dest_modes) >> (dest))) & 1u) ? \
+        (((wordfield)(opcode) << WORD_OPCODE_SHIFT) | \
+         ((wordfield)((src) % OPERAND_NONE) << WORD_SRC_MODE_SHIFT) | \
+         ((wordfield)((dest) % OPERAND_NONE) << WORD_DEST_MODE_SHIFT) | \
+         ((wordfield)(funct) << WORD_FUNCT_SHIFT) | ARE_ABSOLUTE) : \
+        WORD_TEMPLATE_ILLEGAL)
+
+#define TEMPLATE_ROW(opcode, funct, operands, src_modes, dest_modes, src) \
+    { TEMPLATE_WORD(opcode, funct, operands, src_modes, dest_modes, src, OPERAND_TYPE_IMMEDIATE), \
+      TEMPLATE_WORD(opcode, funct, operands, src_modes, dest_modes, src, OPERAND_TYPE_DIRECT), \
+      TEMPLATE_WORD(opcode, funct, operands, src_modes, dest_modes, src, OPERAND_TYPE_RELATIVE), \
+      TEMPLATE_WORD(opcode, funct, operands, src_modes, dest_modes, src, OPERAND_TYPE_REGISTER), \
+      TEMPLATE_WORD(opcode, funct, operands, src_modes, dest_modes, src, OPERAND_NONE) },
+
+#define TEMPLATE_ENTRY(id, name, opcode, funct, operands, src_modes, dest_modes) \
+    { TEMPLATE_ROW(opcode, funct, operands, src_modes, dest_modes, OPERAND_TYPE_IMMEDIATE) \
+      TEMPLATE_ROW(opcode, funct, operands, src_modes, dest_modes, OPERAND_TYPE_DIRECT) \
+      TEMPLATE_ROW(opcode, funct, operands, src_modes, dest_modes, OPERAND_TYPE_RELATIVE) \
+      TEMPLATE_ROW(opcode, funct, operands, src_modes, dest_modes, OPERAND_TYPE_REGISTER) \
+      TEMPLATE_ROW(opcode, funct, operands, src_modes, dest_modes, OPERAND_NONE) },
+
+/* built from the ISA at compile time, so every worker reads the same table without setting it up */
+const wordfield instruction_templates[ISA_INSTRUCTION_COUNT][OPERAND_SLOTS][OPERAND_SLOTS] =
+{
+    ISA_INSTRUCTIONS(TEMPLATE_ENTRY)
+};
+
+/* the rows above list every operand slot */
+typedef char template_slots_check[(OPERAND_SLOTS == 5 && OPERAND_NONE == OPERAND_TYPE_REGISTER + 1) ? 1 : -1];
+
 void set_wordfield_are_num(wordfield* wf, unsigned int num, unsigned int are)
 {
     if (!wf) 
         return;
 
-    wf->opcode      = (num >> 15) & MASK_SIX_BITS;  /* Extract bits 3-8 (6 bits) */
-    wf->src_mode    = (num >> 13) & MASK_TWO_BITS;  /* Extract bits 9-10 (2 bits) */
-    wf->src_reg     = (num >> 10) & MASK_THREE_BITS;  /* Extract bits 11-13 (3 bits) */
-    wf->dest_mode   = (num >> 8)  & MASK_TWO_BITS;  /* Extract bits 14-15 (2 bits) */
-    wf->dest_reg    = (num >> 5)  & MASK_THREE_BITS;  /* Extract bits 16-18 (3 bits) */
-    wf->funct       = (num >> 0)  & MASK_FIVE_BITS;  /* Extract bits 19-23 (5 bits) */
-    wf->are         = are;                   /* Manually set first 3 bits */
+    /* the 21 bits of num fill every field above the ARE bits, bits 23 to 3 */
+    *wf = ((num << WORD_FUNCT_SHIFT) & MASK_WORD) | (are & MASK_THREE_BITS);
 }
 
 void set_wordfield_by_num(wordfield* wf, unsigned int num)
@@ -59,26 +79,8 @@ void set_wordfield_by_num(wordfield* wf, unsigned int num)
     if (!wf) 
         return;
 
-    /* Extract 6 bits (0x3F is binary 111111),  bits 23 to 18. */
-    wf->opcode      = (num >> 18) & MASK_SIX_BITS;  
-
-    /* Extract 2 bits (0x03 is binary 11), bits 17 to 16. */
-    wf->src_mode    = (num >> 16) & MASK_TWO_BITS;  
-
-    /* Extract 3 bits ( 0x07 is binary 111), bits 15 to 13. */
-    wf->src_reg     = (num >> 13) & MASK_THREE_BITS;
-
-    /* Extract 2 bits (0x03 is binary 11), bits 12 to 11. */
-    wf->dest_mode   = (num >> 11)  & MASK_TWO_BITS;
-
-    /* Extract 3 bits (0x07 is binary 11), bits 10 to 8. */
-    wf->dest_reg    = (num >> 8)  & MASK_THREE_BITS;
-
-    /* Extract 5 bits (0x1F is binary 11111), bits 7 to 3. */
-    wf->funct       = (num >> 3)  & MASK_FIVE_BITS; 
-
-    /* Extract 3 bits (0x03 is binary 11), bits 2 to 0. */
-    wf->are         = (num >> 0)  & MASK_THREE_BITS; 
+    /* all 24 bits, bits 23 to 0 */
+    *wf = num & MASK_WORD;
 }
 
 void set_wordfield_op_funct(wordfield* word, unsigned int opcode, unsigned int funct)
@@ -89,8 +91,8 @@ void set_wordfield_op_funct(wordfield* word, unsigned int opcode, unsigned int f
         return;
     }
 
-    word->opcode    = opcode;  /* 000000 */
-    word->funct     = funct;  /* 00000 */
+    *word = WORD_WITH_FIELD(*word, WORD_OPCODE_SHIFT, MASK_SIX_BITS, opcode);  /* 000000 */
+    *word = WORD_WITH_FIELD(*word, WORD_FUNCT_SHIFT, MASK_FIVE_BITS, funct);   /* 00000 */
 }
 
 void set_wordfield_src(wordfield* word, unsigned int src_mode, unsigned int src_reg)
@@ -101,8 +103,8 @@ void set_wordfield_src(wordfield* word, unsigned int src_mode, unsigned int src_
         return;
     }
 
-    word->src_mode  = src_mode;  /* 00 */
-    word->src_reg   = src_reg;  /* 000 */
+    *word = WORD_WITH_FIELD(*word, WORD_SRC_MODE_SHIFT, MASK_TWO_BITS, src_mode);  /* 00 */
+    *word = WORD_WITH_FIELD(*word, WORD_SRC_REG_SHIFT, MASK_THREE_BITS, src_reg);  /* 000 */
 }
 
 void set_wordfield_dest(wordfield* word, unsigned int dest_mode, unsigned int dest_reg)
@@ -113,8 +115,8 @@ void set_wordfield_dest(wordfield* word, unsigned int dest_mode, unsigned int de
         return;
     }
 
-    word->dest_mode = dest_mode;  /* 00 */
-    word->dest_reg  = dest_reg;  /* 000 */
+    *word = WORD_WITH_FIELD(*word, WORD_DEST_MODE_SHIFT, MASK_TWO_BITS, dest_mode);  /* 00 */
+    *word = WORD_WITH_FIELD(*word, WORD_DEST_REG_SHIFT, MASK_THREE_BITS, dest_reg);  /* 000 */
 }
 
 void set_wordfield_are(wordfield* word, unsigned int are)
@@ -124,46 +126,18 @@ void set_wordfield_are(wordfield* word, unsigned int are)
         log_error(__FILE__,__LINE__,"Can't set wordfield, word is NULL!\n");
         return;
     }
-    word->are = are;  /* 000 */
+    *word = WORD_WITH_FIELD(*word, WORD_ARE_SHIFT, MASK_THREE_BITS, are);  /* 000 */
 }
 
-wordfield* create_wordfield_by_opname(char* str, InstructionTable* instruction_table)
+wordfield instruction_template(const IsaInstruction* instruction, int src_mode, int dest_mode)
 {
-    InstructionNode* node;
-    wordfield* wf;
-
-    if(str == NULL)
-    {
-        log_error(__FILE__,__LINE__,"Can't create wordfield by op, str is NULL!\n");
-        return NULL;
-    }
-    else if(instruction_table == NULL)
-    {
-        log_error(__FILE__,__LINE__,"Can't create wordfield by op, instruction_table is NULL!\n");
-        return NULL;
-    }
+    if(instruction == NULL || src_mode < 0 || src_mode >= OPERAND_SLOTS || dest_mode < 0 || dest_mode >= OPERAND_SLOTS)
+        return WORD_TEMPLATE_ILLEGAL;
 
-    wf = init_wordfield();
-    node = instruction_table_get(instruction_table,str);
-    
-    if(node && (is_instruction(str) == VALID_RETURN))
-    {
-        set_wordfield_op_funct(wf,node->op_code,node->funct);
-        return wf;
-    }
-
-    free(wf); 
-    return NULL;
+    return instruction_templates[instruction - isa_instructions][src_mode][dest_mode];
 }
 
-
-int wordfield_to_int(wordfield* wf) 
+int wordfield_to_int(wordfield wf) 
 {
-    return (wf->opcode    << 18) |  /* Opcode into bits 23-18*/
-           (wf->src_mode  << 16) |  /* Src Mode into bits 17-16*/
-           (wf->src_reg   << 13) |  /* Src Reg into bits 15-13*/
-           (wf->dest_mode << 11) |  /* Dest Mode into bits 12-11*/
-           (wf->dest_reg  << 8)  |  /* Dest Reg into bits 10-8*/
-           (wf->funct     << 3)  |  /* Funct into bits 7-3*/
-           (wf->are);               /* ARE into bits 2-0*/
+    return (int)(wf & MASK_WORD);
 }
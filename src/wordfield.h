@@ -2,7 +2,7 @@
 #define WORDFIELD_H
 
 #include <stdio.h>
-#include "instruction_table.h"
+#include "isa.h"
 
 /** 
  * @brief A bitmasks for extracting two,three,five,six bits.
@@ -12,45 +12,80 @@
 #define MASK_THREE_BITS 0x07
 #define MASK_TWO_BITS   0x03
 
+/**
+ * @brief Position of each field in a packed 24 bit word.
+ */
+#define WORD_OPCODE_SHIFT       18  /* bits 23-18 */
+#define WORD_SRC_MODE_SHIFT     16  /* bits 17-16 */
+#define WORD_SRC_REG_SHIFT      13  /* bits 15-13 */
+#define WORD_DEST_MODE_SHIFT    11  /* bits 12-11 */
+#define WORD_DEST_REG_SHIFT     8   /* bits 10-8 */
+#define WORD_FUNCT_SHIFT        3   /* bits 7-3 */
+#define WORD_ARE_SHIFT          0   /* bits 2-0 */
+#define MASK_WORD               0xFFFFFF /* all 24 bits of a word */
+
+/**
+ * @brief Reads a field of a packed word, I.E: WORD_FIELD(word, WORD_FUNCT_SHIFT, MASK_FIVE_BITS).
+ */
+#define WORD_FIELD(word, shift, mask) (((word) >> (shift)) & (mask))
+
+/**
+ * @brief Returns a packed word with one of its fields replaced by @p value (truncated to the field).
+ */
+#define WORD_WITH_FIELD(word, shift, mask, value) \
+    (((word) & ~((wordfield)(mask) << (shift))) | (((wordfield)(value) & (mask)) << (shift)))
+
+/**
+ * @brief The register fields of an instruction word, OR'd into its encoding template.
+ */
+#define WORD_SRC_REGISTER(reg)  (((wordfield)(reg) & MASK_THREE_BITS) << WORD_SRC_REG_SHIFT)
+#define WORD_DEST_REGISTER(reg) (((wordfield)(reg) & MASK_THREE_BITS) << WORD_DEST_REG_SHIFT)
+
+/**
+ * @brief Operand slot of an encoding template for an operand the instruction doesn't have.
+ */
+#define OPERAND_NONE ADDRESSING_MODES
+#define OPERAND_SLOTS (ADDRESSING_MODES + 1) /* the addressing modes and OPERAND_NONE */
+
+/**
+ * @brief The encoding template of an illegal combination of operands, above every 24 bit word.
+ */
+#define WORD_TEMPLATE_ILLEGAL (~(wordfield)0)
 
 /**
- * @brief A structure representing the instruction format in a bitfield of 24 bits.
+ * @brief A 24 bit machine word in the instruction format, packed into the low bits of an unsigned int:
+ * | opcode (6) | src mode (2) | src reg (3) | dest mode (2) | dest reg (3) | funct (5) | A-R-E (3) |
+ * A word is a plain value, it is stored inline and copied by assignment.
  */
-typedef struct 
-{
-    unsigned int opcode      : 6;  /* Opcode field (6 bits). */
-    unsigned int src_mode    : 2;  /* Source Addressing Mode (2 bits). */
-    unsigned int src_reg     : 3;  /* Source Register (3 bits). */
-    unsigned int dest_mode   : 2;  /* Destination Addressing Mode (2 bits). */
-    unsigned int dest_reg    : 3;  /* Destination Register (3 bits). */
-    unsigned int funct       : 5;  /* Function Code (5 bits). */
-    unsigned int are         : 3;  /* A-R-E bits (Absolute, Relocatable, External) (3 bits). */
-} wordfield;
+typedef unsigned int wordfield;
 
 /**
  * @brief Prints the binary representation of each bit in the given wordfield in a grouped format.
- * @param[in] word A pointer to the wordfield structure to print.
+ * @param[in] word The wordfield to print.
  */
-void print_wordfield(wordfield* word);
+void print_wordfield(wordfield word);
 
 /**
- * @brief Allocates and initializes a new wordfield structure to all zeros.
- * If the allocation fails, it logs an error and returns NULL.
- * @return Pointer to the newly allocated wordfield, or NULL on failure.
+ * @brief The encoding templates of the instruction words, indexed by [IsaIndex][source slot][destination slot].
+ *
+ * A template holds the opcode, funct, addressing modes and ARE bits of the instruction word for one
+ * legal combination of operands, the registers are OR'd in (WORD_SRC_REGISTER, WORD_DEST_REGISTER).
+ * A combination the instruction doesn't accept holds WORD_TEMPLATE_ILLEGAL.
  */
-wordfield* init_wordfield();
+extern const wordfield instruction_templates[ISA_INSTRUCTION_COUNT][OPERAND_SLOTS][OPERAND_SLOTS];
 
 /**
- * @brief Creates and initializes a new wordfield based on an instruction name using the given instruction table.
- * @param[in] str               A C-string representing the name of the instruction (e.g., "mov", "add").
- * @param[in] instruction_table A pointer to an 'InstructionTable' that contains instruction definitions.
- * @return Pointer to a newly allocated and initialized wordfield, or NULL on failure.
+ * @brief Looks up the encoding template of an instruction word.
+ * @param[in] instruction The instruction, as described by the ISA (e.g., mov, add).
+ * @param[in] src_mode    The addressing mode of the source operand, OPERAND_NONE if there is none.
+ * @param[in] dest_mode   The addressing mode of the destination operand, OPERAND_NONE if there is none.
+ * @return The template, or WORD_TEMPLATE_ILLEGAL if the instruction doesn't accept these operands.
  */
-wordfield* create_wordfield_by_opname(char* str, InstructionTable* instruction_table);
+wordfield instruction_template(const IsaInstruction* instruction, int src_mode, int dest_mode);
 
 /**
  * @brief Sets the fields of the given wordfield from a 21-bit number, and separately sets its ARE bits.
- * @param[out] wf  A pointer to the wordfield structure to modify.
+ * @param[out] wf  A pointer to the wordfield to modify.
  * @param[in]  num A 21-bit integer representing the desired fields.
  * @param[in]  are The ARE bits to set (3 bits).
  */
@@ -58,14 +93,14 @@ void set_wordfield_are_num(wordfield* wf, unsigned int num, unsigned int are);
 
 /**
  * @brief Sets the fields of the given wordfield from a 24-bit integer (containing all fields including ARE).
- * @param[out] wf  A pointer to the wordfield structure to modify.
+ * @param[out] wf  A pointer to the wordfield to modify.
  * @param[in]  num A 24-bit integer representing the desired fields.
  */
 void set_wordfield_by_num(wordfield* wf, unsigned int num);
 
 /**
  * @brief Sets the opcode and function code fields in the specified wordfield.
- * @param[out] word   A pointer to the wordfield structure to modify.
+ * @param[out] word   A pointer to the wordfield to modify.
  * @param[in]  opcode The opcode value (6 bits).
  * @param[in]  funct  The function code value (5 bits).
  */
@@ -73,7 +108,7 @@ void set_wordfield_op_funct(wordfield* word, unsigned int opcode, unsigned int f
 
 /**
  * @brief Sets the source addressing mode and source register fields in the specified wordfield.
- * @param[out] word     A pointer to the wordfield structure to modify.
+ * @param[out] word     A pointer to the wordfield to modify.
  * @param[in]  src_mode The source addressing mode (2 bits).
  * @param[in]  src_reg  The source register (3 bits).
  */
@@ -81,7 +116,7 @@ void set_wordfield_src(wordfield* word, unsigned int src_mode, unsigned int src_
 
 /**
  * @brief Sets the destination addressing mode and destination register fields in the specified wordfield.
- * @param[out] word       A pointer to the wordfield structure to modify.
+ * @param[out] word       A pointer to the wordfield to modify.
  * @param[in]  dest_mode  The destination addressing mode (2 bits).
  * @param[in]  dest_reg   The destination register (3 bits).
  */
@@ -89,16 +124,16 @@ void set_wordfield_dest(wordfield* word, unsigned int dest_mode, unsigned int de
 
 /**
  * @brief Sets the A-R-E bits in the specified wordfield.
- * @param[out] word A pointer to the wordfield structure to modify.
- * @param[in]  are  The A-R-E bits (3 bits) to set in the structure.
+ * @param[out] word A pointer to the wordfield to modify.
+ * @param[in]  are  The A-R-E bits (3 bits) to set in the word.
  */
 void set_wordfield_are(wordfield* word, unsigned int are);
 
 /**
- * @brief Converts all fields of a wordfield into a single 24-bit integer.
- * @param[in] wf A pointer to the wordfield structure whose fields should be combined.
+ * @brief Converts a wordfield into a single 24-bit integer.
+ * @param[in] wf The wordfield.
  * @return A 24-bit integer representing the entire wordfield.
  */
-int wordfield_to_int(wordfield* wf);
+int wordfield_to_int(wordfield wf);
 
 #endif
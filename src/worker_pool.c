@@ -0,0 +1,103 @@
+#define _POSIX_C_SOURCE 200112L
+#include "worker_pool.h"
+#include "common.h"
+#include "logger.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+typedef struct WorkerPool
+{
+    pthread_mutex_t     lock;
+    pthread_cond_t      job_done;
+    int                 job_count;
+    int                 next_job;   /* index of the next job a worker will take */
+    char*               done;       /* done[i] is set once job i has finished */
+    WorkerJobFunction   run;
+    void*               arg;
+} WorkerPool;
+
+static void* worker_main(void* data)
+{
+    WorkerPool* pool = (WorkerPool*)data;
+    int job;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->lock);
+        job = pool->next_job++;
+        pthread_mutex_unlock(&pool->lock);
+        if (job >= pool->job_count)
+            break;
+
+        pool->run(job, pool->arg);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->done[job] = 1;
+        pthread_cond_broadcast(&pool->job_done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+int worker_pool_run(int job_count, int thread_count, WorkerJobFunction run, WorkerJobFunction finish, void* arg)
+{
+    WorkerPool pool;
+    pthread_t threads[MAX_WORKER_THREADS];
+    int started = 0;
+    int i;
+
+    if (job_count <= 0)
+        return VALID_RETURN;
+    if (thread_count < 1)
+        thread_count = 1;
+    if (thread_count > MAX_WORKER_THREADS)
+        thread_count = MAX_WORKER_THREADS;
+    if (thread_count > job_count)
+        thread_count = job_count;
+
+    pool.done = calloc(job_count, sizeof(char));
+    if (pool.done == NULL)
+    {
+        log_error(__FILE__,__LINE__, "Failed to allocate the worker pool.\n");
+        return INVALID_RETURN;
+    }
+    pool.job_count = job_count;
+    pool.next_job = 0;
+    pool.run = run;
+    pool.arg = arg;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.job_done, NULL);
+
+    for (; started < thread_count; started++)
+    {
+        if (pthread_create(&threads[started], NULL, worker_main, &pool) != 0)
+            break;
+    }
+    if (started == 0)
+    {
+        log_error(__FILE__,__LINE__, "Failed to start a worker thread.\n");
+        pthread_cond_destroy(&pool.job_done);
+        pthread_mutex_destroy(&pool.lock);
+        free(pool.done);
+        return INVALID_RETURN;
+    }
+
+    /* Report the jobs in order while the workers keep going */
+    for (i = 0; i < job_count; i++)
+    {
+        pthread_mutex_lock(&pool.lock);
+        while (!pool.done[i])
+            pthread_cond_wait(&pool.job_done, &pool.lock);
+        pthread_mutex_unlock(&pool.lock);
+        if (finish != NULL)
+            finish(i, arg);
+    }
+
+    for (i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+
+    pthread_cond_destroy(&pool.job_done);
+    pthread_mutex_destroy(&pool.lock);
+    free(pool.done);
+    return VALID_RETURN;
+}
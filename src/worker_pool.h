@@ -0,0 +1,31 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+/** @brief Upper bound on the number of worker threads. */
+#define MAX_WORKER_THREADS 64
+
+/**
+ * @brief A function run for a single job.
+ * @param job_index The index of the job, between 0 and job_count - 1.
+ * @param arg       The argument given to worker_pool_run.
+ */
+typedef void (*WorkerJobFunction)(int job_index, void* arg);
+
+/**
+ * @brief Runs jobs concurrently on a pool of worker threads.
+ *
+ * Workers take the next job index as soon as they are free and call @p run for it.
+ * Meanwhile the calling thread calls @p finish for each job in index order, as soon
+ * as that job and every job before it are done, so results can be reported in the
+ * same order a serial run would report them.
+ *
+ * @param job_count     Number of jobs to run.
+ * @param thread_count  Number of worker threads (clamped to 1..MAX_WORKER_THREADS).
+ * @param run           Called on a worker thread for every job.
+ * @param finish        Called on the calling thread for every job, in order (may be NULL).
+ * @param arg           Passed to @p run and @p finish.
+ * @return VALID_RETURN on success, INVALID_RETURN if no worker thread could be started.
+ */
+int worker_pool_run(int job_count, int thread_count, WorkerJobFunction run, WorkerJobFunction finish, void* arg);
+
+#endif /* WORKER_POOL_H */
@@ -0,0 +1,801 @@
+#define _POSIX_C_SOURCE 200112L /* pthread, nanosleep */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <utime.h>
+#include "../test_framework.h"
+#include "../../src/common.h"
+#include "../../src/asm_context.h"
+#include "../../src/asm_protocol.h"
+#include "../../src/asm_server.h"
+#include "../../src/asm_watch.h"
+
+#define TEST_THREADS 4
+#define TEST_ROUNDS 10
+#define TEST_MAX_OUTPUT 65536
+#define TEST_SOCKET "test_asm_context.sock"
+#define TEST_WATCH_DIRECTORY "build/watch"
+
+/* A context assembling the same file over and over on its own thread */
+typedef struct ContextJob
+{
+    const char* name;       /* the input file, without the .as extension */
+    int         max_errors;
+    int         expected;   /* the result every round should have */
+    int         mismatches; /* rounds with a different result */
+    char*       errors;     /* everything the context reported, NULL terminated */
+} ContextJob;
+
+/* Function prototypes */
+void test_asm_context_serial();
+void test_asm_context_concurrent();
+void test_asm_context_buffer();
+void test_asm_context_single_pass();
+void test_asm_cache();
+void test_asm_server();
+void test_asm_watch();
+
+int main()
+{
+    test_asm_context_serial();
+    test_asm_context_concurrent();
+    test_asm_context_buffer();
+    test_asm_context_single_pass();
+    test_asm_cache();
+    test_asm_server();
+    test_asm_watch();
+    return 0;
+}
+
+/* Reads a whole file into a NULL terminated buffer, returns NULL if it can't be read */
+static char* read_file(const char* path)
+{
+    char* data;
+    size_t length;
+    FILE* file = fopen(path, "r");
+
+    if (file == NULL)
+        return NULL;
+    data = malloc(TEST_MAX_OUTPUT + 1);
+    length = fread(data, 1, TEST_MAX_OUTPUT, file);
+    data[length] = NULL_TERMINATOR;
+    fclose(file);
+    return data;
+}
+
+/* Reads what a tmpfile received */
+static char* read_stream(FILE* stream)
+{
+    char* data = malloc(TEST_MAX_OUTPUT + 1);
+    size_t length;
+
+    rewind(stream);
+    length = fread(data, 1, TEST_MAX_OUTPUT, stream);
+    data[length] = NULL_TERMINATOR;
+    return data;
+}
+
+/* =======================
+   Test: A Context Reused Across Files
+   ======================= */
+void test_asm_context_serial()
+{
+    static const char* valid[] = { "../../input_files/valid1", "../../input_files/valid2", "../../input_files/valid3" };
+    FILE* out = tmpfile();
+    AsmContext* context = asm_context_create(NULL, out, out);
+    int i, failed = 0;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - A Context Reused Across Files in asm_context.h\n");
+
+    if (context == NULL)
+    {
+        log_test("Test_asm_context_serial", TEST_FAIL, "Couldn't create the context.");
+        return;
+    }
+    /* an invalid file in between leaves nothing behind for the valid ones */
+    for (i = 0; i < 3; i++)
+    {
+        failed |= asm_context_assemble(context, valid[i]) != VALID_RETURN;
+        failed |= asm_context_assemble(context, "../../input_files/firstpass_invalid1") != INVALID_RETURN;
+    }
+    failed |= asm_context_assemble(context, "../../input_files/no_such_file") != INVALID_RETURN;
+    asm_context_destroy(context);
+    fclose(out);
+
+    if (!failed)
+        log_test("Test_asm_context_serial", TEST_PASS, "Every file has the result it has on its own.");
+    else
+        log_test("Test_asm_context_serial", TEST_FAIL, "A file's result depends on the files before it.");
+
+    log_out(__FILE__,__LINE__, "Done - Testing A Context Reused Across Files\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* Runs on its own thread: assembles the file of the job every round */
+static void* run_context_job(void* arg)
+{
+    ContextJob* job = (ContextJob*)arg;
+    AsmOptions options;
+    AsmContext* context;
+    FILE* stream = tmpfile();
+    int round;
+
+    options.emit_am = 0;
+    options.single_pass = 0;
+    options.max_errors = job->max_errors;
+    context = asm_context_create(&options, stream, stream);
+    if (context == NULL || stream == NULL)
+    {
+        job->mismatches = TEST_ROUNDS;
+        return NULL;
+    }
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        if (asm_context_assemble(context, job->name) != job->expected)
+            job->mismatches++;
+    }
+    asm_context_destroy(context);
+    job->errors = read_stream(stream);
+    fclose(stream);
+    return NULL;
+}
+
+/* =======================
+   Test: Contexts on Concurrent Threads
+   ======================= */
+void test_asm_context_concurrent()
+{
+    ContextJob jobs[TEST_THREADS] = {
+        { "../../input_files/valid1", 0, VALID_RETURN, 0, NULL },
+        { "../../input_files/valid2", 0, VALID_RETURN, 0, NULL },
+        { "../../input_files/valid3", 0, VALID_RETURN, 0, NULL },
+        { "../../input_files/firstpass_invalid1", 1, INVALID_RETURN, 0, NULL }
+    };
+    pthread_t threads[TEST_THREADS];
+    char* expected_ob;
+    char* actual_ob;
+    AsmContext* context;
+    int i, failed = 0, isolated = 1;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Contexts on Concurrent Threads in asm_context.h\n");
+
+    /* the object file of a context that runs alone */
+    context = asm_context_create(NULL, NULL, NULL);
+    asm_context_assemble(context, "../../input_files/valid1");
+    asm_context_destroy(context);
+    expected_ob = read_file("build/output_files/valid1.ob");
+
+    for (i = 0; i < TEST_THREADS; i++)
+        pthread_create(&threads[i], NULL, run_context_job, &jobs[i]);
+    for (i = 0; i < TEST_THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    for (i = 0; i < TEST_THREADS; i++)
+    {
+        failed |= jobs[i].mismatches != 0 || jobs[i].errors == NULL;
+        /* only the invalid file reports errors, and only it has a limit */
+        if (jobs[i].errors != NULL && (strstr(jobs[i].errors, "found at") != NULL) != (jobs[i].expected == INVALID_RETURN))
+            isolated = 0;
+        if (jobs[i].errors != NULL && (strstr(jobs[i].errors, "Reached the limit") != NULL) != (jobs[i].max_errors > 0))
+            isolated = 0;
+        free(jobs[i].errors);
+    }
+    actual_ob = read_file("build/output_files/valid1.ob");
+    failed |= expected_ob == NULL || actual_ob == NULL || strcmp(expected_ob, actual_ob) != 0;
+
+    if (!failed)
+        log_test("Test_asm_context_concurrent_results", TEST_PASS, "Concurrent contexts produce the results of a single one.");
+    else
+        log_test("Test_asm_context_concurrent_results", TEST_FAIL, "Concurrent contexts produce different results.");
+    if (isolated)
+        log_test("Test_asm_context_concurrent_errors", TEST_PASS, "Every context reports its own errors only.");
+    else
+        log_test("Test_asm_context_concurrent_errors", TEST_FAIL, "Errors leak between contexts.");
+
+    free(expected_ob);
+    free(actual_ob);
+    log_out(__FILE__,__LINE__, "Done - Testing Contexts on Concurrent Threads\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* Checks that an in-memory output file holds what the assembled file holds, or is absent with it */
+static int same_output(const AsmBuffer* buffer, const char* path)
+{
+    char* expected = read_file(path);
+    int same = (expected == NULL) ? buffer->data == NULL :
+        buffer->data != NULL && buffer->length == strlen(expected) && strcmp(buffer->data, expected) == 0;
+    free(expected);
+    return same;
+}
+
+/* =======================
+   Test: Assembling From Memory
+   ======================= */
+void test_asm_context_buffer()
+{
+    static const char* names[] = { "valid1", "valid2", "valid3", "secondpass_invalid1", "firstpass_invalid1", "preproc_invalid1" };
+    static const char* extensions[OUTPUT_FILE_COUNT] = { ".ob", ".ent", ".ext", ".am" };
+    char details[128];
+    char path[MAX_FILENAME];
+    int single_pass, i, kind;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Assembling From Memory in asm_context.h\n");
+
+    for (single_pass = 0; single_pass <= 1; single_pass++)
+    {
+        AsmOptions options;
+        AsmContext* context;
+        FILE* stream = tmpfile();
+        int failed = 0;
+
+        options.emit_am = 1;
+        options.single_pass = single_pass;
+        options.max_errors = 0;
+        context = asm_context_create(&options, stream, stream);
+
+        for (i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++)
+        {
+            AsmOutput output;
+            char* source;
+            int file_flag, buffer_flag;
+
+            for (kind = 0; kind < OUTPUT_FILE_COUNT; kind++)
+            {
+                sprintf(path, "build/output_files/%s%s", names[i], extensions[kind]);
+                remove(path);
+            }
+            sprintf(path, "../../input_files/%s.as", names[i]);
+            source = read_file(path);
+            sprintf(path, "../../input_files/%s", names[i]);
+            buffer_flag = asm_context_assemble_buffer(context, path, source, strlen(source), &output);
+            free(source);
+
+            /* nothing was written, then the files are assembled for comparison */
+            for (kind = 0; kind < OUTPUT_FILE_COUNT; kind++)
+            {
+                char* written;
+                sprintf(path, "build/output_files/%s%s", names[i], extensions[kind]);
+                written = read_file(path);
+                failed |= written != NULL;
+                free(written);
+            }
+            sprintf(path, "../../input_files/%s", names[i]);
+            file_flag = asm_context_assemble(context, path);
+
+            failed |= file_flag != buffer_flag;
+            for (kind = 0; kind < OUTPUT_FILE_COUNT; kind++)
+            {
+                sprintf(path, "build/output_files/%s%s", names[i], extensions[kind]);
+                failed |= !same_output(&output.files[kind], path);
+            }
+            asm_output_free(&output);
+        }
+        asm_context_destroy(context);
+        fclose(stream);
+
+        sprintf(details, "%s output files in memory are the assembled files.", single_pass ? "Single-pass" : "Two-pass");
+        log_test("Test_asm_context_buffer", failed ? TEST_FAIL : TEST_PASS, details);
+    }
+
+    log_out(__FILE__,__LINE__, "Done - Testing Assembling From Memory\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* Checks that two in-memory output files are the same, or both absent */
+static int same_buffer(const AsmBuffer* first, const AsmBuffer* second)
+{
+    if (first->data == NULL || second->data == NULL)
+        return first->data == second->data;
+    return first->length == second->length && memcmp(first->data, second->data, first->length) == 0;
+}
+
+/* =======================
+   Test: Single Pass Against Two Passes
+   ======================= */
+void test_asm_context_single_pass()
+{
+    static const char* names[] = { "valid1", "valid2", "valid3", "secondpass_invalid1", "firstpass_invalid1",
+        "firstpass_invalid2", "firstpass_invalid3", "firstpass_invalid4", "preproc_invalid1", "preproc_invalid2", NULL };
+    /* words that wait for a label defined later, some of them for an external one */
+    static const char* late_labels =
+        "MAIN:  mov X, r1\n"
+        "       lea Y, r2\n"
+        ".extern Y\n"
+        "       mov Y, r3\n"
+        "       jmp &END\n"
+        "       mov X, r4\n"
+        "       lea LIST, r5\n"
+        "END:  stop\n"
+        ".extern X\n"
+        "LIST:  .data 4, -2\n"
+        ".entry MAIN\n"
+        ".entry LIST\n";
+    char details[128];
+    char path[MAX_FILENAME];
+    AsmContext* contexts[2];
+    FILE* stream = tmpfile();
+    int mismatches = 0;
+    int single_pass, i, kind;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Single Pass Against Two Passes in asm_context.h\n");
+
+    for (single_pass = 0; single_pass <= 1; single_pass++)
+    {
+        AsmOptions options;
+        options.emit_am = 1;
+        options.single_pass = single_pass;
+        options.max_errors = 0;
+        contexts[single_pass] = asm_context_create(&options, stream, stream);
+    }
+
+    for (i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++)
+    {
+        AsmOutput outputs[2];
+        int flags[2];
+        char* source;
+
+        if (names[i] != NULL)
+        {
+            sprintf(path, "../../input_files/%s.as", names[i]);
+            source = read_file(path);
+            sprintf(path, "../../input_files/%s", names[i]);
+        }
+        else
+        {
+            source = (char*)malloc(strlen(late_labels) + 1);
+            strcpy(source, late_labels);
+            strcpy(path, "build/late_labels");
+        }
+        if (source == NULL)
+        {
+            mismatches++;
+            continue;
+        }
+
+        for (single_pass = 0; single_pass <= 1; single_pass++)
+            flags[single_pass] = asm_context_assemble_buffer(contexts[single_pass], path, source, strlen(source), &outputs[single_pass]);
+        free(source);
+
+        if (flags[0] != flags[1])
+            mismatches++;
+        for (kind = 0; kind < OUTPUT_FILE_COUNT; kind++)
+        {
+            if (!same_buffer(&outputs[0].files[kind], &outputs[1].files[kind]))
+            {
+                log_out(__FILE__,__LINE__, "The single pass changed the %s of [%s]\n", output_file_extensions[kind], path);
+                mismatches++;
+            }
+        }
+        asm_output_free(&outputs[0]);
+        asm_output_free(&outputs[1]);
+    }
+    asm_context_destroy(contexts[0]);
+    asm_context_destroy(contexts[1]);
+    fclose(stream);
+
+    sprintf(details, "%d output files differ between the two modes.", mismatches);
+    log_test("Test_asm_context_single_pass", mismatches ? TEST_FAIL : TEST_PASS, mismatches ? details :
+        "A single pass writes the output files of two passes.");
+
+    log_out(__FILE__,__LINE__, "Done - Testing Single Pass Against Two Passes\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* Removes a directory an earlier run left, with everything in it */
+static void remove_tree(const char* directory)
+{
+    char command[MAX_FILENAME];
+    sprintf(command, "rm -rf %s", directory);
+    if (system(command) != 0)
+        log_out(__FILE__,__LINE__, "Couldn't clear [%s]\n", directory);
+}
+
+/* Assembles a file with a context that restores it from a cache, returns 1 if it was a hit */
+static int cache_hit(AsmContext* context, AsmCache* cache, const char* name)
+{
+    AsmCacheStats before, after;
+    char path[MAX_FILENAME];
+
+    sprintf(path, "../../input_files/%s", name);
+    asm_cache_stats(cache, &before);
+    asm_context_assemble(context, path);
+    asm_cache_stats(cache, &after);
+    return after.hits == before.hits + 1;
+}
+
+/* =======================
+   Test: Build Cache
+   ======================= */
+void test_asm_cache()
+{
+    static const char* names[] = { "valid1", "valid2", "valid3", "secondpass_invalid1", "firstpass_invalid1" };
+    static const char* directory = "build/cache";
+    static const char* stray[] = { "0123456789abcdef-0000000000000010.ent", "0123456789abcdef-0000000000000010.ob.12.0.tmp",
+        "notes.txt" };
+    char* expected[sizeof(names) / sizeof(names[0])][OUTPUT_FILE_COUNT];
+    char path[MAX_FILENAME];
+    FILE* stream = tmpfile();
+    AsmContext* context = asm_context_create(NULL, stream, stream);
+    AsmCacheStats stats;
+    AsmCache* cache;
+    int count = (int)(sizeof(names) / sizeof(names[0]));
+    int failed = 0;
+    int i, kind;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Build Cache in asm_cache.h\n");
+
+    remove_tree(directory);
+    cache = asm_cache_open(directory, 0);
+    if (cache == NULL || context == NULL)
+    {
+        log_test("Test_asm_cache_restore", TEST_FAIL, "Couldn't open the cache.");
+        asm_cache_close(cache);
+        asm_context_destroy(context);
+        fclose(stream);
+        return;
+    }
+    asm_context_set_cache(context, cache);
+
+    /* the first run assembles and stores the valid files */
+    for (i = 0; i < count; i++)
+    {
+        sprintf(path, "../../input_files/%s", names[i]);
+        asm_context_assemble(context, path);
+        for (kind = 0; kind < OUTPUT_FILE_AM; kind++)
+        {
+            sprintf(path, "build/output_files/%s%s", names[i], output_file_extensions[kind]);
+            expected[i][kind] = read_file(path);
+        }
+    }
+    asm_cache_stats(cache, &stats);
+    failed |= stats.hits != 0 || stats.misses != 5 || stats.stores != 3;
+
+    /* the second restores them, an output file the entry doesn't have is removed as an assembly removes it */
+    for (i = 0; i < count; i++)
+    {
+        for (kind = 0; kind < OUTPUT_FILE_AM; kind++)
+        {
+            FILE* stale;
+            sprintf(path, "build/output_files/%s%s", names[i], output_file_extensions[kind]);
+            if ((stale = fopen(path, "w")) != NULL)
+            {
+                fputs("stale\n", stale);
+                fclose(stale);
+            }
+        }
+        failed |= cache_hit(context, cache, names[i]) != (i < 3);
+        for (kind = 0; kind < OUTPUT_FILE_AM; kind++)
+        {
+            char* actual;
+            sprintf(path, "build/output_files/%s%s", names[i], output_file_extensions[kind]);
+            actual = read_file(path);
+            failed |= (actual == NULL || expected[i][kind] == NULL) ? actual != expected[i][kind] :
+                strcmp(actual, expected[i][kind]) != 0;
+            free(actual);
+            free(expected[i][kind]);
+        }
+    }
+    asm_cache_stats(cache, &stats);
+    failed |= stats.hits != 3 || stats.misses != 7 || stats.stores != 3 || stats.evictions != 0;
+    log_test("Test_asm_cache_restore", failed ? TEST_FAIL : TEST_PASS,
+        "Unchanged sources are restored with the assembled output files.");
+    asm_context_set_cache(context, NULL);
+    asm_cache_close(cache);
+
+    /*
+     * valid3 is 554 bytes of output files and the others 441, two entries fit in 1200 bytes,
+     * and an eviction goes down to 1080, so only the least recently used goes
+     */
+    failed = 0;
+    remove_tree(directory);
+    cache = asm_cache_open(directory, 1200);
+    asm_context_set_cache(context, cache);
+    for (i = 0; i < 3; i++)
+        failed |= cache_hit(context, cache, names[i]);
+    failed |= !cache_hit(context, cache, "valid3");
+    failed |= cache_hit(context, cache, "valid1");
+    failed |= !cache_hit(context, cache, "valid3");
+    failed |= cache_hit(context, cache, "valid2");
+    asm_cache_stats(cache, &stats);
+    failed |= stats.evictions != 3;
+    log_test("Test_asm_cache_evict", failed ? TEST_FAIL : TEST_PASS,
+        "Past the size limit the least recently used entries are evicted.");
+    asm_context_set_cache(context, NULL);
+    asm_cache_close(cache);
+
+    /* files of stores that never finished are removed once they are old, files that aren't the cache's are kept */
+    failed = 0;
+    for (i = 0; i < (int)(sizeof(stray) / sizeof(stray[0])); i++)
+    {
+        struct utimbuf old;
+        FILE* file;
+        sprintf(path, "%s/%s", directory, stray[i]);
+        if ((file = fopen(path, "w")) != NULL)
+        {
+            fputs("stray\n", file);
+            fclose(file);
+        }
+        old.actime = old.modtime = time(NULL) - 3600;
+        utime(path, &old);
+    }
+    cache = asm_cache_open(directory, 1200);
+    asm_context_set_cache(context, cache);
+    for (i = 0; i < (int)(sizeof(stray) / sizeof(stray[0])); i++)
+    {
+        sprintf(path, "%s/%s", directory, stray[i]);
+        failed |= (access(path, F_OK) == 0) != (i == 2);
+    }
+    failed |= !cache_hit(context, cache, "valid3");
+    asm_context_set_cache(context, NULL);
+    asm_cache_close(cache);
+    log_test("Test_asm_cache_stray", failed ? TEST_FAIL : TEST_PASS,
+        "Files of unfinished stores are removed when the cache is opened.");
+
+    asm_context_destroy(context);
+    fclose(stream);
+    log_out(__FILE__,__LINE__, "Done - Testing Build Cache\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* Runs the daemon until the test stops it */
+static void* run_server(void* arg)
+{
+    *(int*)arg = asm_server_run(TEST_SOCKET, NULL);
+    return NULL;
+}
+
+/* Connects to the daemon, waiting for it to start listening */
+static int connect_server()
+{
+    int attempt, fd = INVALID_RETURN;
+    for (attempt = 0; attempt < 200 && fd == INVALID_RETURN; attempt++)
+    {
+        struct timespec pause;
+        if ((fd = asm_protocol_connect(TEST_SOCKET)) != INVALID_RETURN)
+            break;
+        pause.tv_sec = 0;
+        pause.tv_nsec = 10000000;
+        nanosleep(&pause, NULL);
+    }
+    return fd;
+}
+
+/* Waits up to 5 seconds for a file to be removed */
+static int wait_for_removal(const char* path)
+{
+    int attempt;
+    for (attempt = 0; attempt < 500; attempt++)
+    {
+        struct timespec pause;
+        if (access(path, F_OK) != 0)
+            return 1;
+        pause.tv_sec = 0;
+        pause.tv_nsec = 10000000;
+        nanosleep(&pause, NULL);
+    }
+    return 0;
+}
+
+/* =======================
+   Test: Assembler Daemon
+   ======================= */
+void test_asm_server()
+{
+    AsmRequest request;
+    AsmResponse response;
+    pthread_t thread;
+    int server_result = INVALID_RETURN;
+    int fd, idle, failed;
+    char idle_byte;
+    char* source;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Assembler Daemon in asm_server.h\n");
+
+    pthread_create(&thread, NULL, run_server, &server_result);
+    if ((fd = connect_server()) == INVALID_RETURN)
+    {
+        log_test("Test_asm_server_path", TEST_FAIL, "Couldn't connect to the daemon.");
+        pthread_join(thread, NULL);
+        return;
+    }
+    memset(&request, 0, sizeof(request));
+
+    /* a file by path, its output files are listed */
+    request.kind = ASM_REQUEST_PATH;
+    request.name = "../../input_files/valid3";
+    failed = asm_protocol_call(fd, &request, &response) == INVALID_RETURN || response.result != VALID_RETURN ||
+        response.files == NULL || strstr(response.files, "/build/output_files/valid3.ob\n") == NULL ||
+        strstr(response.files, "/build/output_files/valid3.ent\n") == NULL ||
+        strstr(response.files, "/build/output_files/valid3.ext\n") == NULL;
+    asm_protocol_free_response(&response);
+    log_test("Test_asm_server_path", failed ? TEST_FAIL : TEST_PASS, "A file by path is assembled and its output files listed.");
+
+    /* an inline source, with its diagnostics */
+    source = read_file("../../input_files/firstpass_invalid1.as");
+    request.kind = ASM_REQUEST_SOURCE;
+    request.name = "inline_invalid";
+    request.source = source;
+    request.source_length = (source != NULL) ? strlen(source) : 0;
+    failed = asm_protocol_call(fd, &request, &response) == INVALID_RETURN || response.result != INVALID_RETURN ||
+        response.out == NULL || strstr(response.out, "found at [build/output_files/inline_invalid.am") == NULL;
+    asm_protocol_free_response(&response);
+    free(source);
+    log_test("Test_asm_server_source", failed ? TEST_FAIL : TEST_PASS, "An inline source is assembled with its diagnostics.");
+
+    /* a second daemon doesn't take the socket of a running one */
+    failed = asm_server_run(TEST_SOCKET, NULL) != INVALID_RETURN;
+    request.kind = ASM_REQUEST_PATH;
+    request.name = "../../input_files/valid1";
+    request.source = NULL;
+    request.source_length = 0;
+    failed |= asm_protocol_call(fd, &request, &response) == INVALID_RETURN || response.result != VALID_RETURN;
+    asm_protocol_free_response(&response);
+    log_test("Test_asm_server_taken", failed ? TEST_FAIL : TEST_PASS, "A second daemon on the same socket fails and the first keeps serving.");
+
+    /* a stop request ends the daemon, a client that keeps an idle connection open doesn't hold it */
+    idle = connect_server();
+    request.kind = ASM_REQUEST_STOP;
+    request.source = NULL;
+    request.source_length = 0;
+    failed = idle == INVALID_RETURN || asm_protocol_call(fd, &request, &response) == INVALID_RETURN;
+    asm_protocol_free_response(&response);
+    /* the idle connection was ended by the daemon, not by this test */
+    if (!wait_for_removal(TEST_SOCKET))
+        failed = 1;
+    else
+        failed |= idle != INVALID_RETURN && read(idle, &idle_byte, 1) != 0;
+    if (idle != INVALID_RETURN)
+        close(idle);
+    close(fd);
+    pthread_join(thread, NULL);
+    failed |= server_result != VALID_RETURN || access(TEST_SOCKET, F_OK) == 0;
+    log_test("Test_asm_server_stop", failed ? TEST_FAIL : TEST_PASS,
+        "A stop request ends the daemon and its idle connections, and removes its socket.");
+
+    log_out(__FILE__,__LINE__, "Done - Testing Assembler Daemon\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* Runs the watch until the test interrupts it */
+static void* run_watch(void* arg)
+{
+    AsmOptions options = { 0, 0, 0 };
+    *(int*)arg = asm_watch_run(TEST_WATCH_DIRECTORY, &options, 2, NULL);
+    return NULL;
+}
+
+/* Writes 'data' to 'path', followed by 'extra' */
+static void write_source(const char* path, const char* data, const char* extra)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+        return;
+    fputs(data, file);
+    fputs(extra, file);
+    fclose(file);
+}
+
+/* Waits up to 5 seconds for a file to be created */
+static int wait_for_file(const char* path)
+{
+    int attempt;
+    for (attempt = 0; attempt < 500; attempt++)
+    {
+        struct timespec pause;
+        if (access(path, F_OK) == 0)
+            return 1;
+        pause.tv_sec = 0;
+        pause.tv_nsec = 10000000;
+        nanosleep(&pause, NULL);
+    }
+    return 0;
+}
+
+/* Waits up to 5 seconds for a file to hold 'expected' */
+static int wait_for_content(const char* path, const char* expected)
+{
+    int attempt;
+    for (attempt = 0; attempt < 500; attempt++)
+    {
+        struct timespec pause;
+        char* actual = read_file(path);
+        int same = actual != NULL && strcmp(actual, expected) == 0;
+        free(actual);
+        if (same)
+            return 1;
+        pause.tv_sec = 0;
+        pause.tv_nsec = 10000000;
+        nanosleep(&pause, NULL);
+    }
+    return 0;
+}
+
+/* =======================
+   Test: Watching a Directory
+   ======================= */
+void test_asm_watch()
+{
+    char* source = read_file("../../input_files/valid1.as");
+    char* assembled = NULL;
+    char* watch_output;
+    FILE* captured;
+    int saved_stdout;
+    AsmContext* context;
+    AsmOutput output;
+    pthread_t thread;
+    int watch_result = INVALID_RETURN;
+    int failed;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Watching a Directory in asm_watch.h\n");
+
+    remove_tree(TEST_WATCH_DIRECTORY);
+    if (system("mkdir -p " TEST_WATCH_DIRECTORY) != 0 || source == NULL)
+    {
+        log_test("Test_asm_watch_initial", TEST_FAIL, "Couldn't create the watched sources.");
+        free(source);
+        return;
+    }
+    write_source(TEST_WATCH_DIRECTORY "/watched1.as", source, "");
+    write_source(TEST_WATCH_DIRECTORY "/watched2.as", source, "");
+    remove("build/output_files/watched1.ob");
+    remove("build/output_files/watched2.ob");
+
+    /* every source is assembled when the watch starts */
+    pthread_create(&thread, NULL, run_watch, &watch_result);
+    failed = !wait_for_file("build/output_files/watched1.ob") || !wait_for_file("build/output_files/watched2.ob");
+    log_test("Test_asm_watch_initial", failed ? TEST_FAIL : TEST_PASS, "Every source is assembled when the watch starts.");
+
+    /* only the source that changed is assembled again, without errors: a comment doesn't change its words */
+    context = asm_context_create(NULL, NULL, NULL);
+    if (context != NULL && asm_context_assemble_buffer(context, "watched", source, strlen(source), &output) == VALID_RETURN)
+    {
+        assembled = output.files[OUTPUT_FILE_OB].data;
+        output.files[OUTPUT_FILE_OB].data = NULL;
+        asm_output_free(&output);
+    }
+    asm_context_destroy(context);
+    remove("build/output_files/watched1.ob");
+    remove("build/output_files/watched2.ob");
+
+    /* the output of the watch goes to a file until it stops, to check the batch reported no errors */
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    if ((captured = fopen("build/watch_output.txt", "w")) != NULL)
+        dup2(fileno(captured), STDOUT_FILENO);
+
+    write_source(TEST_WATCH_DIRECTORY "/watched2.as", source, "\n; changed\n");
+    failed = assembled == NULL || !wait_for_content("build/output_files/watched2.ob", assembled) ||
+        access("build/output_files/watched1.ob", F_OK) == 0;
+
+    pthread_kill(thread, SIGINT);
+    pthread_join(thread, NULL);
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    if (captured != NULL)
+        fclose(captured);
+    watch_output = read_file("build/watch_output.txt");
+    failed |= watch_output == NULL || strstr(watch_output, "ErrorType_") != NULL;
+    free(watch_output);
+    remove("build/watch_output.txt");
+    log_test("Test_asm_watch_changed", failed ? TEST_FAIL : TEST_PASS,
+        "Only the changed source is assembled again, without errors.");
+    log_test("Test_asm_watch_interrupt", (watch_result == VALID_RETURN) ? TEST_PASS : TEST_FAIL,
+        "An interrupt ends the watch.");
+    free(assembled);
+    free(source);
+
+    log_out(__FILE__,__LINE__, "Done - Testing Watching a Directory\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../test_framework.h"
+#include "../../src/logger.h"
+#include "../../src/common.h"
+#include "../../src/arena.h"
+#include "../../src/binary_table.h"
+#include "../../src/label_table.h"
+
+#define BENCH_RUNS 4
+
+void bench_job_allocations();
+
+int main()
+{
+    bench_job_allocations();
+    return 0;
+}
+
+/*
+ * Allocates what one file of 'lines' source lines allocates, the way the first pass
+ * does for "LOOPn: add r3, LIST": a label, an instruction word and an "Address of
+ * Label" word with its unresolved label, then releases all of it as the second pass
+ * does. With 'arena' set everything comes from the arena and is released by a reset,
+ * and 'objects' receives the number of objects, each one a malloc of its own without it.
+ */
+static double assemble_job(unsigned int lines, Arena* arena, size_t* objects)
+{
+    unsigned int i, TC = START_ADDRESS;
+    char name[MAX_LABEL_LENGTH];
+    clock_t start;
+    double ms;
+    LabelTable label_table;
+    BinaryTable* binary_table;
+
+    start = clock();
+    label_table_create(&label_table, arena);
+    binary_table = binary_table_create(5, arena);
+    for (i = 0; i < lines; i++)
+    {
+        sprintf(name, "LOOP%u", i);
+        label_table_add(&label_table, name, TC, LABELTYPE_CODE);
+        binary_node_add(binary_table, TC++, NODE_TEXT_LINE);
+        binary_node_add_label(binary_table, TC++, NODE_TEXT_LABEL_ADDRESS, "LIST", 4);
+    }
+    binary_table_destroy(binary_table);
+    label_table_destroy(&label_table);
+    if (arena != NULL)
+    {
+        *objects = arena->allocations;
+        arena_reset(arena);
+    }
+    ms = elapsed_ms(start);
+    return ms;
+}
+
+void bench_job_allocations()
+{
+    unsigned int lines;
+    int run;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Bench - per-object malloc vs. the job arena in arena.h\n");
+
+    printf("%10s | %12s | %12s | %12s | %12s | %12s\n", "lines", "heap mallocs", "heap (ms)", "arena mallocs", "arena (ms)", "arena KB");
+    for (lines = 10000; lines <= 1000000; lines *= 10)
+    {
+        double heap_ms = -1, arena_ms = -1;
+        size_t objects = 0, blocks = 0, bytes = 0;
+
+        for (run = 0; run < BENCH_RUNS; run++)
+        {
+            Arena arena;
+            clock_t start;
+            double ms = assemble_job(lines, NULL, &objects);
+            if (heap_ms < 0 || ms < heap_ms)
+                heap_ms = ms;
+
+            /* a fresh arena every run, so allocating and freeing its blocks is timed as well */
+            arena_init(&arena, DEFAULT_ARENA_BLOCK_SIZE);
+            ms = assemble_job(lines, &arena, &objects);
+            blocks = arena.blocks;
+            start = clock();
+            arena_destroy(&arena);
+            ms += elapsed_ms(start);
+            if (arena_ms < 0 || ms < arena_ms)
+                arena_ms = ms;
+        }
+
+        bytes = blocks * DEFAULT_ARENA_BLOCK_SIZE;
+        printf("%10u | %12lu | %12.3f | %12lu | %12.3f | %12lu\n", lines, (unsigned long)objects, heap_ms,
+            (unsigned long)blocks, arena_ms, (unsigned long)(bytes / 1024));
+    }
+
+    log_out(__FILE__,__LINE__, "Done - Job Arena Bench\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
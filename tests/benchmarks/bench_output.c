@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../test_framework.h"
+#include "../../src/logger.h"
+#include "../../src/common.h"
+#include "../../src/utility.h"
+#include "../../src/wordfield.h"
+#include "../../src/output_writer.h"
+
+#define BENCH_RUNS 3
+#define BENCH_WORDS 1000000
+/* every n-th word references an external label, and gets a .ext line */
+#define BENCH_EXTERN_EVERY 16
+
+void bench_output_writer();
+
+int main()
+{
+    bench_output_writer();
+    return 0;
+}
+
+/* The word at 'address' of the bench program, spread over all 24 bits */
+static wordfield bench_word(unsigned int address)
+{
+    return (wordfield)((address * 2654435761u) & MASK_WORD);
+}
+
+/*
+ * Writes the .ob and .ext records of a BENCH_WORDS program with one of two paths and returns the time taken:
+ * 0 - int_to_hex and fprintf per record (complete_first_pass before the output writer)
+ * 1 - OutputWriter, lookup table formatting into one buffer flushed with write()
+ */
+static double write_program(int mode, FILE* ob_file, FILE* ext_file)
+{
+    unsigned int address;
+    clock_t start = clock();
+
+    if (mode == 0)
+    {
+        fprintf(ob_file, "\t%d %d\n", BENCH_WORDS, 0);
+        for (address = START_ADDRESS; address < START_ADDRESS + BENCH_WORDS; address++)
+        {
+            char* hex_str = int_to_hex(wordfield_to_int(bench_word(address)));
+            if (address % BENCH_EXTERN_EVERY == 0)
+                fprintf(ext_file, "%s %.7d\n", "EXTERNAL", address);
+            fprintf(ob_file, "%.7d %s\n", address, hex_str);
+            free(hex_str);
+        }
+        fflush(ob_file);
+        fflush(ext_file);
+    }
+    else
+    {
+        OutputWriter ob_writer, ext_writer;
+        output_writer_open(&ob_writer, ob_file);
+        output_writer_open(&ext_writer, ext_file);
+        output_writer_header(&ob_writer, BENCH_WORDS, 0);
+        for (address = START_ADDRESS; address < START_ADDRESS + BENCH_WORDS; address++)
+        {
+            if (address % BENCH_EXTERN_EVERY == 0)
+                output_writer_label(&ext_writer, "EXTERNAL", address);
+            output_writer_word(&ob_writer, address, bench_word(address));
+        }
+        output_writer_close(&ob_writer);
+        output_writer_close(&ext_writer);
+    }
+    return elapsed_ms(start);
+}
+
+/* Returns the contents of 'file' in a new buffer, and its size in 'length' */
+static char* read_back(FILE* file, long* length)
+{
+    char* data;
+
+    fseek(file, 0, SEEK_END);
+    *length = ftell(file);
+    rewind(file);
+    data = malloc(*length + 1);
+    if (data != NULL && fread(data, 1, *length, file) != (size_t)*length)
+        *length = -1;
+    return data;
+}
+
+void bench_output_writer()
+{
+    static const char* paths[] = { "fprintf", "output writer" };
+    char* output[2] = { NULL, NULL };
+    long ob_bytes[2] = { 0, 0 };
+    long bytes = 0;
+    int run, mode;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Bench - .ob/.ext records in output_writer.h\n");
+
+    printf("%10s | %14s | %12s | %10s\n", "words", "path", "time (ms)", "MB/s");
+    for (mode = 0; mode < 2; mode++)
+    {
+        double best = -1;
+        for (run = 0; run < BENCH_RUNS; run++)
+        {
+            double ms;
+            long ext_bytes;
+            FILE* ob_file = tmpfile();
+            FILE* ext_file = tmpfile();
+            if (ob_file == NULL || ext_file == NULL)
+            {
+                log_error(__FILE__,__LINE__, "Failed to create the bench output files\n");
+                return;
+            }
+
+            ms = write_program(mode, ob_file, ext_file);
+            if (best < 0 || ms < best)
+                best = ms;
+
+            free(output[mode]);
+            output[mode] = read_back(ob_file, &ob_bytes[mode]);
+            free(read_back(ext_file, &ext_bytes));
+            bytes = ob_bytes[mode] + ext_bytes;
+            fclose(ob_file);
+            fclose(ext_file);
+        }
+        printf("%10d | %14s | %12.3f | %10.1f\n", BENCH_WORDS, paths[mode], best,
+            (bytes / 1048576.0) / (best / 1000.0));
+    }
+
+    if (output[0] != NULL && output[1] != NULL && ob_bytes[0] == ob_bytes[1] &&
+        memcmp(output[0], output[1], ob_bytes[0]) == 0)
+        log_test("Bench_output_writer_identical", TEST_PASS, "Both paths wrote the same records.");
+    else
+        log_test("Bench_output_writer_identical", TEST_FAIL, "The output writer records differ from fprintf.");
+    printf("%ld bytes per program\n", bytes);
+
+    free(output[0]);
+    free(output[1]);
+    log_out(__FILE__,__LINE__, "Done - Output Writer Bench\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
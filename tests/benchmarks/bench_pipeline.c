@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../test_framework.h"
+#include "../../src/logger.h"
+#include "../../src/common.h"
+#include "../../src/input.h"
+#include "../../src/pre_asm.h"
+#include "../../src/macro_table.h"
+#include "../../src/string_buffer.h"
+#include "../../src/source_reader.h"
+
+#define BENCH_RUNS 3
+#define BENCH_AM_FILE "bench_pipeline.am"
+#define BENCH_SOURCE_FILE "bench_pipeline.as"
+
+void bench_am_round_trip();
+
+int main()
+{
+    bench_am_round_trip();
+    return 0;
+}
+
+/* Writes a source of 'lines' lines, a tenth of them macro calls, and returns its size in bytes */
+static long write_source(FILE* fp, unsigned int lines)
+{
+    unsigned int i;
+
+    fputs("mcro a_mc\n            cmp K       ,  #-6\n            bne &END\nmcroend\n", fp);
+    for (i = 0; i < lines; i++)
+    {
+        if (i % 10 == 0)
+            fputs("            a_mc\n", fp);
+        else
+            fprintf(fp, "LOOP%u:      add r%u ,  LIST\n", i, i % 8);
+    }
+    fflush(fp);
+    return ftell(fp);
+}
+
+/* 
+ * Runs the pre-assembler and hands every expanded line to a reader, the way the
+ * first pass consumes them, and returns the time spent on the hand-off alone.
+ * With 'round_trip' set the expanded source is written to a .am file and read
+ * back with read_line, as the first pass did before it read from memory.
+ */
+static double expand_and_read(int round_trip, unsigned int* lines_read, double* expand_ms)
+{
+    char line[MAX_LINE];
+    char output_file[MAX_FILENAME];
+    char filepath[] = BENCH_SOURCE_FILE;
+    SourceReader source;
+    clock_t start;
+    double ms;
+    StringBuffer expanded;
+    MacroTable* macro_table = macro_table_create(DEFAULT_MACRO_TABLE_SIZE);
+
+    string_buffer_init(&expanded, DEFAULT_STRING_BUFFER_SIZE);
+    *lines_read = 0;
+
+    start = clock();
+    source_reader_open(&source, filepath);
+    parse_macros(&source, filepath, output_file, macro_table, &expanded);
+    source_reader_close(&source);
+    *expand_ms = elapsed_ms(start);
+
+    start = clock();
+    if (round_trip)
+    {
+        FILE* am_fp;
+        write_am_file(BENCH_AM_FILE, &expanded);
+        am_fp = fopen(BENCH_AM_FILE, "r");
+        while (am_fp && read_line(am_fp, line) != INVALID_RETURN)
+            (*lines_read)++;
+        if (am_fp)
+            fclose(am_fp);
+    }
+    else
+    {
+        size_t offset = 0;
+        while (read_line_from_buffer(expanded.data, expanded.length, &offset, line) != INVALID_RETURN)
+            (*lines_read)++;
+    }
+    ms = elapsed_ms(start);
+
+    remove(BENCH_AM_FILE);
+    string_buffer_free(&expanded);
+    macro_table_destroy(macro_table);
+    return ms;
+}
+
+void bench_am_round_trip()
+{
+    unsigned int lines;
+    int run, mode;
+    long bytes;
+    FILE* source;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Bench - pre-assembler to first pass hand-off\n");
+
+    printf("%10s | %10s | %16s | %12s | %14s | %10s\n", "lines", "source KB", "path", "expand (ms)", "hand-off (ms)", "MB/s");
+    for (lines = 10000; lines <= 1000000; lines *= 10)
+    {
+        source = fopen(BENCH_SOURCE_FILE, "w");
+        if (source == NULL)
+        {
+            log_error(__FILE__,__LINE__, "Failed to create the bench source\n");
+            return;
+        }
+        bytes = write_source(source, lines);
+        fclose(source);
+
+        for (mode = 0; mode < 2; mode++)
+        {
+            unsigned int lines_read = 0;
+            double best = -1, best_expand = -1, expand_ms;
+            for (run = 0; run < BENCH_RUNS; run++)
+            {
+                double ms = expand_and_read(mode, &lines_read, &expand_ms);
+                if (best < 0 || ms < best)
+                    best = ms;
+                if (best_expand < 0 || expand_ms < best_expand)
+                    best_expand = expand_ms;
+            }
+            /* throughput of the hand-off, in MB of source per second */
+            printf("%10u | %10ld | %16s | %12.3f | %14.3f | %10.1f\n", lines, bytes / 1024,
+                mode ? ".am round trip" : "in memory", best_expand, best, (bytes / 1048576.0) / (best / 1000.0));
+        }
+        remove(BENCH_SOURCE_FILE);
+    }
+
+    log_out(__FILE__,__LINE__, "Done - Pre-Assembler Hand-off Bench\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../test_framework.h"
+#include "../../src/logger.h"
+#include "../../src/common.h"
+#include "../../src/input.h"
+#include "../../src/source_reader.h"
+
+#define BENCH_RUNS 3
+#define BENCH_SOURCE_FILE "bench_reader.as"
+#define BENCH_SOURCE_MB 100
+
+void bench_source_reader();
+
+int main()
+{
+    bench_source_reader();
+    return 0;
+}
+
+/* Writes about 'megabytes' MB of assembly source and returns its size in bytes */
+static long write_source(const char* filepath, unsigned int megabytes)
+{
+    unsigned long i = 0;
+    long bytes;
+    FILE* fp = fopen(filepath, "w");
+
+    if (fp == NULL)
+        return INVALID_RETURN;
+    while (ftell(fp) < (long)megabytes * 1048576L)
+    {
+        switch (i % 4)
+        {
+        case 0: fprintf(fp, "LOOP%lu:      add r%lu ,  LIST\n", i, i % 8); break;
+        case 1: fputs("            prn #48\n", fp); break;
+        case 2: fputs("; a comment line that the first pass skips over entirely\n", fp); break;
+        default: fputs("            bne &LOOP\n", fp); break;
+        }
+        i++;
+    }
+    bytes = ftell(fp);
+    fclose(fp);
+    return bytes;
+}
+
+/* 
+ * Reads every line of the source with one of three paths and returns the time taken:
+ * 0 - read_line, one getc per character (the pre-assembler before the source reader)
+ * 1 - source_reader_read_line, the line copied into a MAX_LINE buffer
+ * 2 - source_reader_next_line, line views with no copy at all
+ */
+static double read_source(int mode, unsigned long* lines_read)
+{
+    char line[MAX_LINE];
+    clock_t start = clock();
+    *lines_read = 0;
+
+    if (mode == 0)
+    {
+        FILE* fp = fopen(BENCH_SOURCE_FILE, "r");
+        while (fp && read_line(fp, line) != INVALID_RETURN)
+            (*lines_read)++;
+        if (fp)
+            fclose(fp);
+    }
+    else
+    {
+        SourceReader source;
+        LineView view;
+        if (source_reader_open(&source, BENCH_SOURCE_FILE) == INVALID_RETURN)
+            return -1;
+        if (mode == 1)
+        {
+            while (source_reader_read_line(&source, line) != INVALID_RETURN)
+                (*lines_read)++;
+        }
+        else
+        {
+            while (source_reader_next_line(&source, &view) != INVALID_RETURN)
+                (*lines_read)++;
+        }
+        source_reader_close(&source);
+    }
+    return elapsed_ms(start);
+}
+
+void bench_source_reader()
+{
+    static const char* paths[] = { "getc read_line", "reader, copied", "reader, views" };
+    unsigned long lines_read;
+    long bytes;
+    int run, mode;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Bench - source line reading in source_reader.h\n");
+
+    bytes = write_source(BENCH_SOURCE_FILE, BENCH_SOURCE_MB);
+    if (bytes == INVALID_RETURN)
+    {
+        log_error(__FILE__,__LINE__, "Failed to create the bench source\n");
+        return;
+    }
+
+    printf("%10s | %16s | %12s | %10s\n", "source MB", "path", "time (ms)", "MB/s");
+    for (mode = 0; mode < 3; mode++)
+    {
+        double best = -1;
+        for (run = 0; run < BENCH_RUNS; run++)
+        {
+            double ms = read_source(mode, &lines_read);
+            if (best < 0 || ms < best)
+                best = ms;
+        }
+        printf("%10.1f | %16s | %12.3f | %10.1f\n", bytes / 1048576.0, paths[mode], best,
+            (bytes / 1048576.0) / (best / 1000.0));
+    }
+    printf("%lu lines per read\n", lines_read);
+
+    remove(BENCH_SOURCE_FILE);
+    log_out(__FILE__,__LINE__, "Done - Source Reader Bench\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
@@ -0,0 +1,184 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime, fork */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "../test_framework.h"
+#include "../../src/logger.h"
+#include "../../src/common.h"
+#include "../../src/asm_protocol.h"
+
+#define BENCH_REQUESTS 200
+#define BENCH_ASSEMBLER "../../build/assembler"
+#define BENCH_SOCKET "bench_server.sock"
+#define BENCH_SOURCE "../../input_files/valid3"
+/* How long the daemon gets to start listening, in milliseconds */
+#define BENCH_START_TIMEOUT 2000
+
+void bench_server_latency();
+
+int main()
+{
+    bench_server_latency();
+    return 0;
+}
+
+/* Returns a monotonic time in milliseconds */
+static double now_ms()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+/* Starts build/assembler with 'argv' and its output discarded, returns its pid */
+static pid_t spawn_assembler(char* const argv[])
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        execv(BENCH_ASSEMBLER, argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+/* Reads a whole file, returns NULL if it can't be read */
+static char* read_source(const char* path, size_t* length)
+{
+    char* data = malloc(1 << 16);
+    FILE* file = fopen(path, "r");
+    if (file == NULL || data == NULL)
+    {
+        free(data);
+        if (file != NULL)
+            fclose(file);
+        return NULL;
+    }
+    *length = fread(data, 1, 1 << 16, file);
+    fclose(file);
+    return data;
+}
+
+/* Sends BENCH_REQUESTS requests, on a single connection or a connection each, returns the total time or -1 */
+static double run_requests(const AsmRequest* request, int connection_per_request)
+{
+    AsmResponse response;
+    double start = now_ms();
+    int fd = -1, i;
+
+    for (i = 0; i < BENCH_REQUESTS; i++)
+    {
+        if (fd < 0 && (fd = asm_protocol_connect(BENCH_SOCKET)) < 0)
+            return -1;
+        if (asm_protocol_call(fd, request, &response) == INVALID_RETURN)
+        {
+            close(fd);
+            return -1;
+        }
+        asm_protocol_free_response(&response);
+        if (connection_per_request)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd >= 0)
+        close(fd);
+    return now_ms() - start;
+}
+
+/* Prints a row of the results */
+static void print_row(const char* mode, double total_ms)
+{
+    if (total_ms < 0)
+        printf("%-32s | %12s | %16s\n", mode, "failed", "-");
+    else
+        printf("%-32s | %12.1f | %16.1f\n", mode, total_ms, total_ms * 1000.0 / BENCH_REQUESTS);
+}
+
+void bench_server_latency()
+{
+    char* exec_argv[] = { "assembler", BENCH_SOURCE, NULL };
+    char* serve_argv[] = { "assembler", "--serve", BENCH_SOCKET, NULL };
+    AsmRequest request;
+    AsmResponse response;
+    double start, total;
+    pid_t daemon;
+    int fd = -1, i;
+    size_t length = 0;
+    char* source = read_source(BENCH_SOURCE ".as", &length);
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Bench - assembler daemon against fork/exec per file\n");
+
+    /* the output files go under the working directory, for both the executable and the daemon */
+    mkdir("build", 0777);
+    mkdir("build/output_files", 0777);
+    printf("%-32s | %12s | %16s\n", "mode", "total (ms)", "per request (us)");
+
+    start = now_ms();
+    for (i = 0; i < BENCH_REQUESTS; i++)
+    {
+        int status;
+        pid_t pid = spawn_assembler(exec_argv);
+        if (pid < 0 || waitpid(pid, &status, 0) < 0)
+            break;
+    }
+    print_row("fork/exec build/assembler", i == BENCH_REQUESTS ? now_ms() - start : -1);
+
+    daemon = spawn_assembler(serve_argv);
+    for (start = now_ms(); daemon > 0 && now_ms() - start < BENCH_START_TIMEOUT; )
+    {
+        struct timespec pause;
+        if ((fd = asm_protocol_connect(BENCH_SOCKET)) >= 0)
+            break;
+        pause.tv_sec = 0;
+        pause.tv_nsec = 10000000;
+        nanosleep(&pause, NULL);
+    }
+    if (fd < 0)
+    {
+        log_error(__FILE__,__LINE__, "The daemon didn't start listening on [%s]\n", BENCH_SOCKET);
+        free(source);
+        return;
+    }
+
+    memset(&request, 0, sizeof(request));
+    request.kind = ASM_REQUEST_PATH;
+    request.name = BENCH_SOURCE;
+    /* the first request warms up the daemon's context */
+    if (asm_protocol_call(fd, &request, &response) != INVALID_RETURN)
+        asm_protocol_free_response(&response);
+
+    total = run_requests(&request, 0);
+    print_row("daemon, path, one connection", total);
+    total = run_requests(&request, 1);
+    print_row("daemon, path, connection each", total);
+
+    request.kind = ASM_REQUEST_SOURCE;
+    request.source = source;
+    request.source_length = length;
+    total = run_requests(&request, 0);
+    print_row("daemon, inline source", total);
+
+    request.kind = ASM_REQUEST_STOP;
+    request.source = NULL;
+    request.source_length = 0;
+    if (asm_protocol_call(fd, &request, &response) != INVALID_RETURN)
+        asm_protocol_free_response(&response);
+    close(fd);
+    waitpid(daemon, NULL, 0);
+    free(source);
+
+    log_out(__FILE__,__LINE__, "Done - Assembler Daemon Bench\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../test_framework.h"
+#include "../../src/logger.h"
+#include "../../src/common.h"
+#include "../../src/binary_table.h"
+#include "../../src/wordfield.h"
+#include "../../src/label_table.h"
+#include "../../src/utility.h"
+
+#define BENCH_RUNS 4
+
+void bench_binary_table();
+void bench_label_table();
+
+int main()
+{
+    bench_binary_table();
+    bench_label_table();
+    return 0;
+}
+
+/* =======================
+   Bench: Binary Table
+   ======================= */
+
+/*
+ * Emits 'words' machine words the way the first pass does: every instruction adds
+ * its own node and sets its wordfield, then adds an extra "Address of Label" word
+ * that is resolved in the second pass.
+ */
+static double emit_first_pass_words(unsigned int words)
+{
+    unsigned int TC;
+    clock_t start;
+    double ms;
+    wordfield wf = 0;
+    BinaryTable* table = binary_table_create(5, NULL);
+
+    start = clock();
+    for (TC = START_ADDRESS; TC < START_ADDRESS + words; TC++)
+    {
+        if ((TC - START_ADDRESS) % 2 == 0)
+        {
+            set_wordfield_op_funct(&wf, 2, 1);
+            binary_node_add(table, TC, NODE_TEXT_LINE);
+        }
+        else
+        {
+            set_wordfield_by_num(&wf, 0);
+            binary_node_add_label(table, TC, NODE_TEXT_LABEL_ADDRESS, "LIST", 4);
+        }
+        set_binary_node_wordfield(table, TC, wf);
+    }
+    /* the register operand of the last instruction is patched afterwards */
+    set_wordfield_dest(&wf, OPERAND_TYPE_REGISTER, 3);
+    set_binary_node_wordfield(table, START_ADDRESS, wf);
+    ms = elapsed_ms(start);
+
+    binary_table_destroy(table);
+    return ms;
+}
+
+void bench_binary_table()
+{
+    unsigned int words;
+    int run;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Bench - first-pass word emission into binary_table.h\n");
+
+    printf("%12s | %12s | %12s\n", "words", "time (ms)", "ns / word");
+    for (words = 1000; words <= 1000000; words *= 10)
+    {
+        double best = -1;
+        for (run = 0; run < BENCH_RUNS; run++)
+        {
+            double ms = emit_first_pass_words(words);
+            if (best < 0 || ms < best)
+                best = ms;
+        }
+        printf("%12u | %12.3f | %12.1f\n", words, best, best * 1000000.0 / words);
+    }
+
+    log_out(__FILE__,__LINE__, "Done - Binary Table Bench\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* =======================
+   Bench: Label Table
+   ======================= */
+
+/* The linear scan label_table_search used before the table was hash indexed */
+static int linear_label_search(LabelTable* table, char* name)
+{
+    unsigned int i = 0;
+    for (; i < table->size; i++)
+    {
+        if(strcmp(name,table->labels[i].name) == 0)
+            return i;
+    }
+    return INVALID_RETURN;
+}
+
+/*
+ * Defines 'labels' labels and resolves one reference to each of them, the same
+ * add/search mix handle_labels and complete_first_pass produce.
+ * When 'linear' is set the references are resolved with a linear scan instead.
+ */
+static double resolve_labels(unsigned int labels, int linear)
+{
+    unsigned int i;
+    char name[MAX_LABEL_LENGTH];
+    clock_t start;
+    double ms;
+    LabelTable table;
+
+    label_table_create(&table, NULL);
+    start = clock();
+    for (i = 0; i < labels; i++)
+    {
+        sprintf(name, "LABEL_%u", i);
+        label_table_add(&table, name, START_ADDRESS + i, LABELTYPE_CODE);
+        label_table_set_label_type(&table, START_ADDRESS + i, LABELTYPE_CODE);
+    }
+    for (i = 0; i < labels; i++)
+    {
+        sprintf(name, "LABEL_%u", (i * 7919) % labels);
+        if ((linear ? linear_label_search(&table, name) : label_table_search(&table, name)) == INVALID_RETURN)
+            log_error(__FILE__,__LINE__, "Label %s was not found\n", name);
+    }
+    ms = elapsed_ms(start);
+
+    label_table_destroy(&table);
+    return ms;
+}
+
+void bench_label_table()
+{
+    unsigned int labels;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Bench - label definition and resolution in label_table.h\n");
+
+    printf("%12s | %14s | %14s\n", "labels", "hashed (ms)", "linear (ms)");
+    for (labels = 500; labels <= 50000; labels *= 10)
+    {
+        printf("%12u | %14.3f | %14.3f\n", labels, resolve_labels(labels, 0), resolve_labels(labels, 1));
+    }
+    /* the linear scan alone takes minutes past this point */
+    printf("%12u | %14.3f | %14s\n", 500000, resolve_labels(500000, 0), "-");
+
+    log_out(__FILE__,__LINE__, "Done - Label Table Bench\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../test_framework.h"
+#include "../../src/logger.h"
+#include "../../src/common.h"
+#include "../../src/wordfield.h"
+#include "../../src/hex_encoder.h"
+#include "../../src/output_writer.h"
+
+#define TEST_IMAGES 200
+#define TEST_MAX_WORDS 300
+
+/* Function prototypes */
+void test_hex_encoder();
+void test_output_writer();
+void test_output_writer_path();
+
+int main()
+{
+    srand(12345);
+    test_hex_encoder();
+    test_output_writer();
+    test_output_writer_path();
+    return 0;
+}
+
+/* A random word, with bits above the 24 of a word set sometimes */
+static wordfield random_word()
+{
+    return ((wordfield)rand() << 16) ^ (wordfield)rand();
+}
+
+/* The lines the way complete_first_pass wrote them with printf */
+static size_t reference_lines(char* out, unsigned int address, const wordfield* words, size_t count)
+{
+    size_t i, length = 0;
+    for (i = 0; i < count; i++)
+        length += sprintf(out + length, "%.7d %06x\n", address + (unsigned int)i, wordfield_to_int(words[i]));
+    return length;
+}
+
+/* =======================
+   Test: Hex Encoder
+   ======================= */
+void test_hex_encoder()
+{
+    static const char* names[] = { "scalar", "SSE2", "AVX2" };
+    static wordfield words[TEST_MAX_WORDS];
+    static char expected[TEST_MAX_WORDS * HEX_WORD_LINE_LENGTH + 1];
+    static char actual[TEST_MAX_WORDS * HEX_WORD_LINE_LENGTH + 1];
+    char details[128];
+    int kind, image;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Word Line Encoders in hex_encoder.h\n");
+
+    for (kind = 0; kind < HEX_ENCODER_COUNT; kind++)
+    {
+        int failed = 0;
+
+        if (hex_encoder_supported((HexEncoderKind)kind) == INVALID_RETURN)
+        {
+            sprintf(details, "%s encoder isn't supported here, skipped.", names[kind]);
+            log_test("Test_hex_encoder_identical", TEST_OTHER, details);
+            continue;
+        }
+
+        /* random images at random addresses, including ones whose digits carry up to the last address */
+        for (image = 0; image < TEST_IMAGES && !failed; image++)
+        {
+            size_t i, count = (size_t)(rand() % TEST_MAX_WORDS) + 1;
+            unsigned int address;
+            size_t length;
+
+            if (image % 4 == 0)
+                address = HEX_ENCODER_ADDRESS_LIMIT - (unsigned int)count;
+            else if (image % 4 == 1)
+                address = START_ADDRESS;
+            else
+                address = (unsigned int)(rand() % (HEX_ENCODER_ADDRESS_LIMIT - TEST_MAX_WORDS));
+
+            for (i = 0; i < count; i++)
+                words[i] = random_word();
+            length = reference_lines(expected, address, words, count);
+            failed = hex_encode_word_lines_with((HexEncoderKind)kind, actual, address, words, count) != length ||
+                memcmp(expected, actual, length) != 0;
+        }
+
+        sprintf(details, "%s encoder over %d random images.", names[kind], TEST_IMAGES);
+        log_test("Test_hex_encoder_identical", failed ? TEST_FAIL : TEST_PASS, details);
+    }
+
+    log_out(__FILE__,__LINE__, "Done - Testing Word Line Encoders\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* =======================
+   Test: Output Writer
+   ======================= */
+void test_output_writer()
+{
+    static char expected[1 << 20];
+    static char actual[1 << 20];
+    FILE* file = tmpfile();
+    OutputWriter writer;
+    unsigned int address = START_ADDRESS;
+    size_t expected_length = 0, actual_length;
+    int lengths_match = 1;
+    int i;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Output Writer in output_writer.h\n");
+
+    if (file == NULL || output_writer_open(&writer, file) == INVALID_RETURN)
+    {
+        log_test("Test_output_writer_records", TEST_FAIL, "Couldn't open the writer.");
+        return;
+    }
+
+    output_writer_header(&writer, 25, -3);
+    expected_length += sprintf(expected + expected_length, "\t%d %d\n", 25, -3);
+    /* runs of words with gaps between them, labels in between and addresses past 7 digits */
+    for (i = 0; i < 20000; i++)
+    {
+        wordfield word = random_word();
+        if (i % 97 == 0)
+            address += 1 + rand() % 3;
+        if (i == 15000)
+            address = HEX_ENCODER_ADDRESS_LIMIT - 40;
+        if (i % 1000 == 0)
+        {
+            output_writer_label(&writer, "LABEL", address);
+            expected_length += sprintf(expected + expected_length, "%s %.7d\n", "LABEL", address);
+        }
+        output_writer_word(&writer, address, word);
+        actual_length = sprintf(expected + expected_length, "%.7d %06x\n", address, wordfield_to_int(word));
+        lengths_match &= output_word_line_length(address) == actual_length;
+        expected_length += actual_length;
+        address++;
+    }
+    output_writer_close(&writer);
+
+    rewind(file);
+    actual_length = fread(actual, 1, sizeof(actual), file);
+    fclose(file);
+    if (actual_length == expected_length && memcmp(expected, actual, expected_length) == 0)
+        log_test("Test_output_writer_records", TEST_PASS, "Records match the printf formats.");
+    else
+        log_test("Test_output_writer_records", TEST_FAIL, "Records differ from the printf formats.");
+    if (lengths_match)
+        log_test("Test_output_word_line_length", TEST_PASS, "Word line lengths match the records.");
+    else
+        log_test("Test_output_word_line_length", TEST_FAIL, "Word line lengths differ from the records.");
+
+    log_out(__FILE__,__LINE__, "Done - Testing Output Writer\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* Checks if a file exists */
+static int file_exists(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+        return 0;
+    fclose(file);
+    return 1;
+}
+
+/* A heap copy of a path, the writer takes ownership of it */
+static char* copy_path(const char* path)
+{
+    char* copy = malloc(strlen(path) + 1);
+    strcpy(copy, path);
+    return copy;
+}
+
+/* =======================
+   Test: Output Writer by Path
+   ======================= */
+void test_output_writer_path()
+{
+    static const char* path = "test_output_writer.tmp";
+    char actual[64];
+    size_t actual_length = 0;
+    OutputWriter writer;
+    FILE* file;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Output Writer by Path in output_writer.h\n");
+
+    /* a file left by an earlier run, with no records it's removed and not recreated */
+    file = fopen(path, "w");
+    if (file != NULL)
+    {
+        fputs("stale\n", file);
+        fclose(file);
+    }
+    output_writer_open_path(&writer, copy_path(path));
+    if (output_writer_close(&writer) == VALID_RETURN && !file_exists(path))
+        log_test("Test_output_writer_path_empty", TEST_PASS, "A writer without records leaves no file.");
+    else
+        log_test("Test_output_writer_path_empty", TEST_FAIL, "A writer without records left a file.");
+
+    /* records create the file when the writer is closed */
+    output_writer_open_path(&writer, copy_path(path));
+    output_writer_label(&writer, "LABEL", 100);
+    output_writer_close(&writer);
+    if ((file = fopen(path, "r")) != NULL)
+    {
+        actual_length = fread(actual, 1, sizeof(actual), file);
+        fclose(file);
+    }
+    if (actual_length == strlen("LABEL 0000100\n") && memcmp(actual, "LABEL 0000100\n", actual_length) == 0)
+        log_test("Test_output_writer_path_records", TEST_PASS, "The file is created with the records.");
+    else
+        log_test("Test_output_writer_path_records", TEST_FAIL, "The file doesn't hold the records.");
+
+    /* a discarded writer removes the file even after it was created */
+    output_writer_open_path(&writer, copy_path(path));
+    output_writer_header(&writer, 1, 2);
+    output_writer_flush(&writer);
+    output_writer_discard(&writer);
+    if (!file_exists(path))
+        log_test("Test_output_writer_path_discard", TEST_PASS, "A discarded writer leaves no file.");
+    else
+        log_test("Test_output_writer_path_discard", TEST_FAIL, "A discarded writer left a file.");
+    remove(path);
+
+    log_out(__FILE__,__LINE__, "Done - Testing Output Writer by Path\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
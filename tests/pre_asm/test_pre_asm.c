@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../test_framework.h"
+#include "../../src/logger.h"
+#include "../../src/common.h"
+#include "../../src/pre_asm.h"
+#include "../../src/macro_table.h"
+#include "../../src/error_manager.h"
+#include "../../src/input.h"
+#include "../../src/source_reader.h"
+#include "../../src/string_buffer.h"
+
+#define LARGE_MACRO_LINES 10000
+#define READER_TEST_FILE "test_source_reader.as"
+#define LIMIT_TEST_FILE "test_error_limit.as"
+#define LIMIT_TEST_LINES 50
+#define LIMIT_TEST_ERRORS 5
+
+void test_large_macro_body();
+void test_source_reader();
+void test_error_limit();
+
+int main()
+{
+    test_large_macro_body();
+    test_source_reader();
+    test_error_limit();
+    return 0;
+}
+
+/* =======================
+   Test: handle_new_macro()
+   ======================= */
+
+/* 
+ * Feeds handle_new_macro a macro whose body is LARGE_MACRO_LINES lines long,
+ * far beyond a single MAX_LINE buffer, and checks that the whole body is stored.
+ */
+void test_large_macro_body()
+{
+    SourceReader source;
+    StringBuffer input;
+    char line[MAX_LINE];
+    int i, flag;
+    int line_count          = 1; /* the 'mcro' line itself was already read */
+    size_t expected_length  = 0;
+    char* expected          = NULL;
+    const MacroNode* node;
+    MacroTable* table       = macro_table_create(DEFAULT_MACRO_TABLE_SIZE);
+    clock_t start;
+    char details[MAX_LINE * 2];
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - handle_new_macro function in pre_asm.h\n");
+
+    if (string_buffer_init(&input, DEFAULT_STRING_BUFFER_SIZE) == INVALID_RETURN || table == NULL)
+    {
+        log_test("Test_handle_new_macro_large_body", TEST_OTHER, "Could not create the input or table.");
+        macro_table_destroy(table);
+        return;
+    }
+
+    expected = malloc(LARGE_MACRO_LINES * MAX_LINE);
+    for (i = 0; i < LARGE_MACRO_LINES; i++)
+    {
+        sprintf(line, "            add r%d , LIST_%d\n", i % 8, i);
+        string_buffer_append_str(&input, line);
+        strcpy(expected + expected_length, line);
+        expected_length += strlen(line);
+    }
+    string_buffer_append_str(&input, "            mcroend\n");
+    string_buffer_append_str(&input, "            stop\n");
+    source_reader_open_buffer(&source, input.data, input.length);
+
+    start = clock();
+    flag = handle_new_macro(&source, table, "big_mc", "large_macro.as", &line_count);
+    sprintf(details, "Stored %d lines in %.3f ms.", LARGE_MACRO_LINES,
+        (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+
+    node = macro_table_get_node(table, "big_mc");
+    if (flag != INVALID_RETURN && node != NULL && node->definition_length == expected_length &&
+        strcmp(node->macro_definition, expected) == 0)
+        log_test("Test_handle_new_macro_large_body", TEST_PASS, details);
+    else
+        log_test("Test_handle_new_macro_large_body", TEST_FAIL, "Macro body was truncated or corrupted.");
+
+    if (line_count == LARGE_MACRO_LINES + 2)
+        log_test("Test_handle_new_macro_line_count", TEST_PASS, "Line count includes the body and 'mcroend'.");
+    else
+        log_test("Test_handle_new_macro_line_count", TEST_FAIL, "Line count is wrong after the macro.");
+
+    if (source_reader_read_line(&source, line) != INVALID_RETURN && strstr(line, "stop") != NULL)
+        log_test("Test_handle_new_macro_stops_at_mcroend", TEST_PASS, "Reading resumes after 'mcroend'.");
+    else
+        log_test("Test_handle_new_macro_stops_at_mcroend", TEST_FAIL, "Lines after 'mcroend' were consumed.");
+
+    clean_errors_array();
+    free(expected);
+    source_reader_close(&source);
+    string_buffer_free(&input);
+    macro_table_destroy(table);
+    log_out(__FILE__,__LINE__, "Done - Testing handle_new_macro\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* =======================
+   Test: source_reader.h
+   ======================= */
+
+/*
+ * Reads a file with a line longer than MAX_LINE, an empty line and no new line at
+ * the end with both read_line and the source reader, and checks they agree line by line.
+ */
+void test_source_reader()
+{
+    FILE* fp;
+    SourceReader source;
+    LineView view;
+    char expected[MAX_LINE];
+    char line[MAX_LINE];
+    int i, lines = 0, same = 1;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - source_reader.h against read_line\n");
+
+    fp = fopen(READER_TEST_FILE, "w");
+    if (fp == NULL)
+    {
+        log_test("Test_source_reader_matches_read_line", TEST_OTHER, "Could not create the input file.");
+        return;
+    }
+    fputs("MAIN:   add r3, LIST\n\n", fp);
+    for (i = 0; i < MAX_LINE * 3; i++)
+        fputc('x', fp);
+    fputs("\n        stop", fp);
+    fclose(fp);
+
+    fp = fopen(READER_TEST_FILE, "r");
+    if (fp == NULL || source_reader_open(&source, READER_TEST_FILE) == INVALID_RETURN)
+    {
+        log_test("Test_source_reader_matches_read_line", TEST_OTHER, "Could not open the input file.");
+        if (fp)
+            fclose(fp);
+        remove(READER_TEST_FILE);
+        return;
+    }
+
+    while (read_line(fp, expected) != INVALID_RETURN)
+    {
+        lines++;
+        if (source_reader_read_line(&source, line) == INVALID_RETURN || strcmp(expected, line) != 0)
+            same = 0;
+    }
+    if (source_reader_read_line(&source, line) != INVALID_RETURN)
+        same = 0;
+
+    if (same && lines == 4)
+        log_test("Test_source_reader_matches_read_line", TEST_PASS, "Lines, truncation and EOF match read_line.");
+    else
+        log_test("Test_source_reader_matches_read_line", TEST_FAIL, "The source reader and read_line disagree.");
+
+    /* a line view keeps the full length of a line longer than MAX_LINE */
+    source.offset = 0;
+    source_reader_next_line(&source, &view);
+    source_reader_next_line(&source, &view);
+    source_reader_next_line(&source, &view);
+    if (view.length == MAX_LINE * 3)
+        log_test("Test_source_reader_line_view_length", TEST_PASS, "Line views are not truncated.");
+    else
+        log_test("Test_source_reader_line_view_length", TEST_FAIL, "Line view has the wrong length.");
+
+    fclose(fp);
+    source_reader_close(&source);
+
+    /* a copied source is the same text, and it survives the file being truncated while it's read */
+    if (source_reader_open_copy(&source, READER_TEST_FILE) == VALID_RETURN && source.mapping == NULL &&
+        (fp = fopen(READER_TEST_FILE, "w")) != NULL)
+    {
+        fclose(fp);
+        lines = 0;
+        while (source_reader_read_line(&source, line) != INVALID_RETURN)
+            lines++;
+        source_reader_close(&source);
+        log_test("Test_source_reader_copy", (lines == 4) ? TEST_PASS : TEST_FAIL,
+            "A copied source is read whole after the file is truncated.");
+    }
+    else
+    {
+        log_test("Test_source_reader_copy", TEST_FAIL, "Could not copy the input file.");
+    }
+    remove(READER_TEST_FILE);
+    log_out(__FILE__,__LINE__, "Done - Testing source_reader.h\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* =======================
+   Test: Error Limit
+   ======================= */
+void test_error_limit()
+{
+    FILE* fp;
+    SourceReader source;
+    StringBuffer expanded;
+    MacroTable* macro_table;
+    char filepath[MAX_FILENAME] = LIMIT_TEST_FILE;
+    char output_file[MAX_FILENAME];
+    size_t i, lines = 0;
+    int flag;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Error limit in error_manager.h\n");
+
+    /* every macro named after a register is an error, every 'stop' goes to the expanded source */
+    fp = fopen(LIMIT_TEST_FILE, "w");
+    if (fp == NULL)
+    {
+        log_test("Test_error_limit_stops_reading", TEST_OTHER, "Could not create the input file.");
+        return;
+    }
+    for (i = 0; i < LIMIT_TEST_LINES; i++)
+        fputs("mcro r1\nstop\n", fp);
+    fclose(fp);
+
+    macro_table = macro_table_create(10);
+    if (macro_table == NULL || string_buffer_init(&expanded, DEFAULT_STRING_BUFFER_SIZE) == INVALID_RETURN ||
+        source_reader_open(&source, LIMIT_TEST_FILE) == INVALID_RETURN)
+    {
+        log_test("Test_error_limit_stops_reading", TEST_OTHER, "Could not set up the input.");
+        remove(LIMIT_TEST_FILE);
+        return;
+    }
+
+    set_error_limit(LIMIT_TEST_ERRORS);
+    reset_error_limit();
+    flag = parse_macros(&source, filepath, output_file, macro_table, &expanded);
+    for (i = 0; i < expanded.length; i++)
+        lines += expanded.data[i] == NEW_LINE;
+
+    /* the line of the last error is the last one read, so one 'stop' less than errors */
+    if (flag == INVALID_RETURN && is_error_limit_reached() == VALID_RETURN && lines == LIMIT_TEST_ERRORS - 1)
+        log_test("Test_error_limit_stops_reading", TEST_PASS, "The file stopped being read at the limit.");
+    else
+        log_test("Test_error_limit_stops_reading", TEST_FAIL, "The file was read past the error limit.");
+
+    /* a new file starts under the limit, and later errors are only counted */
+    reset_error_limit();
+    for (i = 0; i < LIMIT_TEST_ERRORS; i++)
+        add_error_entry(ErrorType_InvalidLineLength, LIMIT_TEST_FILE, (int)i);
+    add_error_entry(ErrorType_InvalidLineLength, NULL, 0);
+    if (is_error_limit_reached() == VALID_RETURN && is_errors_array_empty() == INVALID_RETURN)
+        log_test("Test_error_limit_counts_past_limit", TEST_PASS, "Errors past the limit still count.");
+    else
+        log_test("Test_error_limit_counts_past_limit", TEST_FAIL, "Errors past the limit were lost.");
+    clean_errors_array();
+    set_error_limit(0);
+    reset_error_limit();
+
+    source_reader_close(&source);
+    string_buffer_free(&expanded);
+    macro_table_destroy(macro_table);
+    remove(LIMIT_TEST_FILE);
+    log_out(__FILE__,__LINE__, "Done - Testing Error limit\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
@@ -6,18 +6,38 @@
 #include "../../src/macro_table.h"
 #include "../../src/instruction_table.h"
 #include "../../src/label_table.h"
+#include "../../src/utility.h"
+#include "../../src/keyword.h"
+#include "../../src/isa.h"
+#include "../../src/wordfield.h"
+#include "../../src/arena.h"
+#include "../../src/fixup_list.h"
+#include "../../src/common.h"
 
 void test_macro_table();
 void test_macro_table_advanced();
+void test_macro_table_growth();
 void test_instruction_table();
 void test_label_table();
+void test_label_table_index();
+void test_keyword_classifier();
+void test_isa();
+void test_arena();
+void test_fixup_list();
 
 int main()
 {
     test_macro_table();
     test_macro_table_advanced();
+    test_macro_table_growth();
     test_instruction_table();
     test_label_table();
+    test_label_table_index();
+    test_keyword_classifier();
+    test_isa();
+    test_arena();
+    test_fixup_list();
+    return 0;
 }
 
 /* =======================
@@ -211,6 +231,54 @@ void test_macro_table_advanced()
             "#---------------------------------------------------------#\n\n");
 }
 
+/* 
+ * Inserts far more macros than the initial bucket count, the table must grow
+ * instead of dropping macros, and every macro must still be found afterwards.
+ */
+void test_macro_table_growth()
+{
+    char name[MAX_MACRO_LENGTH];
+    char definition[MAX_WORD];
+    const char* value;
+    MacroTable* table = NULL;
+    int i, failed = 0;
+
+    log_out(__FILE__, __LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__, __LINE__, "Starting Test - Macro Table Growth\n\n");
+
+    table = macro_table_create(DEFAULT_MACRO_TABLE_SIZE);
+    for (i = 0; i < 1000; i++)
+    {
+        sprintf(name, "m_%d", i);
+        sprintf(definition, "inc r%d\n", i % 8);
+        macro_table_insert(table, name, definition);
+    }
+
+    for (i = 0; i < 1000 && !failed; i++)
+    {
+        sprintf(name, "m_%d", i);
+        sprintf(definition, "inc r%d\n", i % 8);
+        value = macro_table_get(table, name);
+        failed = (value == NULL || strcmp(value, definition) != 0);
+    }
+
+    if (!failed && table->count == 1000 && table->size > DEFAULT_MACRO_TABLE_SIZE)
+        log_test("Growth_macro_table_insert_get", TEST_PASS, "All 1000 macros stored and retrieved.");
+    else
+        log_test("Growth_macro_table_insert_get", TEST_FAIL, "Macros were dropped or retrieved incorrectly.");
+
+    /* resetting keeps the grown buckets but no macros */
+    macro_table_reset(&table);
+    if (table->count == 0 && macro_table_get(table, "m_1") == NULL)
+        log_test("Growth_macro_table_reset", TEST_PASS, "Reset emptied the grown table.");
+    else
+        log_test("Growth_macro_table_reset", TEST_FAIL, "Reset left macros behind.");
+
+    macro_table_destroy(table);
+    log_out(__FILE__, __LINE__, "Done - Macro Table Growth Testing\n");
+    log_out(__FILE__, __LINE__, "#---------------------------------------------------------#\n\n");
+}
+
 /* =======================
    Test: Instruction Table
    ======================= */
@@ -227,17 +295,26 @@ void test_instruction_table()
     /* No need for pointer checks since it's stack allocated */
     log_test("Test_instruction_table_create", TEST_PASS, "Instruction table initialized successfully.");
 
-    instruction_table_insert(&table, "ADD", 1, 10);
-    instruction_table_insert(&table, "SUB", 2, 20);
+    instruction_table_insert(&table, "add", 2, 1);
+    instruction_table_insert(&table, "sub", 2, 2);
+    instruction_table_insert(&table, "stop", 15, 0);
 
-    node = instruction_table_get(&table, "ADD");
-    if (node && strcmp(node->op_name, "ADD") == 0)
+    node = instruction_table_get(&table, "add");
+    if (node && strcmp(node->op_name, "add") == 0 && (node = instruction_table_get(&table, "stop")) != NULL &&
+        strcmp(node->op_name, "stop") == 0)
         log_test("Test_instruction_table_insert_get", TEST_PASS, "Instruction retrieved correctly.");
     else
         log_test("Test_instruction_table_insert_get", TEST_FAIL, "Instruction retrieval failed.");
 
+    /* a name that isn't an instruction has no slot */
+    if (instruction_table_insert(&table, "ADD", 2, 1) == INVALID_RETURN && !instruction_table_get(&table, "ADD"))
+        log_test("Test_instruction_table_unknown", TEST_PASS, "Unknown instruction names are rejected.");
+    else
+        log_test("Test_instruction_table_unknown", TEST_FAIL, "An unknown instruction name was inserted.");
+
     instruction_table_remove(&table, "ADD");
-    if (!instruction_table_get(&table, "ADD"))
+    instruction_table_remove(&table, "add");
+    if (!instruction_table_get(&table, "add"))
         log_test("Test_instruction_table_remove", TEST_PASS, "Instruction removed successfully.");
     else
         log_test("Test_instruction_table_remove", TEST_FAIL, "Instruction removal failed.");
@@ -260,8 +337,9 @@ void test_label_table()
     log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
     log_out(__FILE__,__LINE__, "Starting Test - Label Table Functions in label_table.h\n");
 
-    label_table_create(&table);
+    label_table_create(&table, NULL);
 
+    /* the label table keeps its own copy of the names and frees them on destroy */
     label_table_add(&table, "start", 0x1000, LABELTYPE_CODE);
     label_table_add(&table, "var1", 0x2000, LABELTYPE_DATA);
 
@@ -275,3 +353,284 @@ void test_label_table()
     log_out(__FILE__,__LINE__, "Done - Testing Label Table Functions\n");
     log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
 }
+
+
+/* =======================
+   Test: Label Table Index
+   ======================= */
+void test_label_table_index()
+{
+    LabelTable table;
+    char name[MAX_LABEL_LENGTH];
+    int i, failed = 0;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Label Table Name/Address Index in label_table.h\n");
+
+    label_table_create(&table, NULL);
+
+    /* enough labels to force the table and its indexes to grow several times */
+    for (i = 0; i < 1000; i++)
+    {
+        sprintf(name, "L%d", i);
+        label_table_add(&table, name, 100 + i, LABELTYPE_CODE);
+    }
+    for (i = 0; i < 1000 && !failed; i++)
+    {
+        sprintf(name, "L%d", i);
+        failed = label_table_search(&table, name) != i || label_table_search_by_address(&table, 100 + i) != i;
+    }
+    if (!failed && label_table_search(&table, "MISSING") == INVALID_RETURN)
+        log_test("Test_label_table_index_search", TEST_PASS, "Every label found by name and by address.");
+    else
+        log_test("Test_label_table_index_search", TEST_FAIL, "Indexed search returned a wrong label.");
+
+    /* externs/entries share address 0, a search by address must return the first one added */
+    label_table_add(&table, "EXT1", 0, LABELTYPE_EXTERN);
+    label_table_add(&table, "EXT2", 0, LABELTYPE_EXTERN);
+    label_table_add(&table, "ENT1", 0, LABELTYPE_ENTRY);
+    if (label_table_search_by_address(&table, 0) == label_table_search(&table, "EXT1"))
+        log_test("Test_label_table_index_shared_address", TEST_PASS, "First label with a shared address returned.");
+    else
+        log_test("Test_label_table_index_shared_address", TEST_FAIL, "Wrong label returned for a shared address.");
+
+    /* moving labels must keep both the old and the new address chains in order */
+    label_table_set_address(&table, label_table_search(&table, "EXT1"), 5000);
+    label_table_set_node_by_name(&table, "ENT1", 5000, LABELTYPE_ENTRY);
+    if (label_table_search_by_address(&table, 0) == label_table_search(&table, "EXT2") &&
+        label_table_search_by_address(&table, 5000) == label_table_search(&table, "EXT1"))
+        log_test("Test_label_table_index_set_address", TEST_PASS, "Address index updated after moving labels.");
+    else
+        log_test("Test_label_table_index_set_address", TEST_FAIL, "Address index is stale after moving labels.");
+
+    /* every move leaves the slot of the old address behind, the index is rebuilt before it fills up */
+    failed = 0;
+    for (i = 0; i < 20000 && !failed; i++)
+    {
+        label_table_set_address(&table, i % 1000, 10000 + i);
+        failed = table.address_used > table.slot_count / 4 * 3;
+    }
+    for (i = 19000; i < 20000 && !failed; i++)
+        failed = label_table_search_by_address(&table, 10000 + i) != i % 1000;
+    if (!failed && label_table_search_by_address(&table, 100) == INVALID_RETURN)
+        log_test("Test_label_table_index_moves", TEST_PASS, "Slots of old addresses reclaimed after many moves.");
+    else
+        log_test("Test_label_table_index_moves", TEST_FAIL, "Address index filled up or went stale after many moves.");
+
+    label_table_destroy(&table);
+    log_out(__FILE__,__LINE__, "Done - Testing Label Table Index\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+
+/* =======================
+   Test: Keyword Classifier
+   ======================= */
+void test_keyword_classifier()
+{
+    Keyword keyword;
+    const char* line = "jsr r7,.string LOOP";
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Keyword Classifier in keyword.h\n");
+
+    if (classify_keyword("sub", 3, &keyword) == KEYWORD_INSTRUCTION && keyword.opcode == 2 && keyword.funct == 2 &&
+        classify_keyword("STOP", 4, &keyword) == KEYWORD_INSTRUCTION && keyword.opcode == 15 && keyword.index == 15)
+        log_test("Test_keyword_instruction", TEST_PASS, "Instructions classified with their opcode and funct.");
+    else
+        log_test("Test_keyword_instruction", TEST_FAIL, "Instruction classified wrong.");
+
+    if (classify_keyword(".extern", 7, &keyword) == KEYWORD_DIRECTIVE && keyword.directive == DIRECTIVE_TYPE_EXTERN &&
+        classify_keyword("data", 4, &keyword) == KEYWORD_DIRECTIVE && keyword.directive == (DirectiveType)INVALID_RETURN &&
+        classify_keyword(".DATA", 5, NULL) == KEYWORD_NONE)
+        log_test("Test_keyword_directive", TEST_PASS, "Directives classified with their type.");
+    else
+        log_test("Test_keyword_directive", TEST_FAIL, "Directive classified wrong.");
+
+    if (classify_keyword("r5", 2, &keyword) == KEYWORD_REGISTER && keyword.reg == 5 &&
+        classify_keyword("r8", 2, NULL) == KEYWORD_NONE && classify_keyword("R1", 2, NULL) == KEYWORD_NONE)
+        log_test("Test_keyword_register", TEST_PASS, "Registers r0-r7 classified with their number.");
+    else
+        log_test("Test_keyword_register", TEST_FAIL, "Register classified wrong.");
+
+    /* words inside a line are classified in place, without a null terminator */
+    if (classify_keyword(line, 3, NULL) == KEYWORD_INSTRUCTION && classify_keyword(line + 4, 2, NULL) == KEYWORD_REGISTER &&
+        classify_keyword(line + 7, 7, NULL) == KEYWORD_DIRECTIVE && classify_keyword(line + 15, 4, NULL) == KEYWORD_NONE &&
+        classify_keyword(line, 0, NULL) == KEYWORD_NONE)
+        log_test("Test_keyword_in_place", TEST_PASS, "Words classified in place inside a line.");
+    else
+        log_test("Test_keyword_in_place", TEST_FAIL, "Word inside a line classified wrong.");
+
+    log_out(__FILE__,__LINE__, "Done - Testing Keyword Classifier\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+
+/* =======================
+   Test: ISA Description
+   ======================= */
+void test_isa()
+{
+    int i, failed = 0;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - ISA Description in isa.h\n");
+
+    /* every instruction must be found by its own name, at its own index */
+    for (i = 0; i < ISA_INSTRUCTION_COUNT && !failed; i++)
+        failed = isa_lookup(isa_instructions[i].name, strlen(isa_instructions[i].name)) != &isa_instructions[i];
+    if (!failed && isa_lookup("MOV", 3) == NULL && isa_lookup("stops", 5) == NULL)
+        log_test("Test_isa_lookup", TEST_PASS, "Every instruction looked up by its name.");
+    else
+        log_test("Test_isa_lookup", TEST_FAIL, "Instruction lookup returned a wrong instruction.");
+
+    if (isa_instructions[ISA_LEA].operands == TWO_OPERANDS_INSTRUCTION &&
+        isa_instructions[ISA_LEA].src_modes == MODE_DIRECT &&
+        (isa_instructions[ISA_JSR].dest_modes & MODE_RELATIVE) &&
+        !(isa_instructions[ISA_MOV].dest_modes & MODE_IMMEDIATE) &&
+        isa_instructions[ISA_STOP].operands == NO_OPERANDS_INSTRUCTION && isa_instructions[ISA_STOP].opcode == 15)
+        log_test("Test_isa_addressing_modes", TEST_PASS, "Operand counts and addressing modes as in the ISA.");
+    else
+        log_test("Test_isa_addressing_modes", TEST_FAIL, "Wrong operand count or addressing modes.");
+
+    /* a template is legal exactly where the addressing modes masks allow the operands */
+    failed = 0;
+    for (i = 0; i < ISA_INSTRUCTION_COUNT && !failed; i++)
+    {
+        const IsaInstruction* instruction = &isa_instructions[i];
+        int src, dest;
+        for (src = 0; src < OPERAND_SLOTS; src++)
+        {
+            for (dest = 0; dest < OPERAND_SLOTS; dest++)
+            {
+                int src_legal   = (src == OPERAND_NONE) ? instruction->operands < TWO_OPERANDS_INSTRUCTION :
+                    instruction->operands == TWO_OPERANDS_INSTRUCTION && (instruction->src_modes & ISA_MODE(src));
+                int dest_legal  = (dest == OPERAND_NONE) ? instruction->operands == NO_OPERANDS_INSTRUCTION :
+                    (instruction->dest_modes & ISA_MODE(dest)) != 0;
+                if ((instruction_template(instruction, src, dest) != WORD_TEMPLATE_ILLEGAL) != (src_legal && dest_legal))
+                    failed = 1;
+            }
+        }
+    }
+    if (!failed &&
+        instruction_template(&isa_instructions[ISA_ADD], OPERAND_TYPE_IMMEDIATE, OPERAND_TYPE_DIRECT) == 0x08080c &&
+        (instruction_template(&isa_instructions[ISA_MOV], OPERAND_TYPE_REGISTER, OPERAND_TYPE_REGISTER) |
+            WORD_SRC_REGISTER(1) | WORD_DEST_REGISTER(2)) == 0x033a04 &&
+        instruction_template(&isa_instructions[ISA_JMP], OPERAND_NONE, OPERAND_TYPE_RELATIVE) == 0x24100c &&
+        instruction_template(&isa_instructions[ISA_STOP], OPERAND_NONE, OPERAND_NONE) == 0x3c0004 &&
+        instruction_template(&isa_instructions[ISA_MOV], OPERAND_TYPE_FIRST, OPERAND_TYPE_DIRECT) == WORD_TEMPLATE_ILLEGAL)
+        log_test("Test_isa_templates", TEST_PASS, "Encoding templates match the ISA.");
+    else
+        log_test("Test_isa_templates", TEST_FAIL, "Wrong encoding template or legality.");
+
+    log_out(__FILE__,__LINE__, "Done - Testing ISA Description\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+
+/* =======================
+   Test: Arena Allocator
+   ======================= */
+void test_arena()
+{
+    Arena arena;
+    LabelTable table;
+    char name[MAX_LABEL_LENGTH];
+    char* big;
+    size_t blocks;
+    int i, failed = 0;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Arena Allocator in arena.h\n");
+
+    /* small blocks, so the labels span several of them */
+    arena_init(&arena, 64);
+    label_table_create(&table, &arena);
+    for (i = 0; i < 100; i++)
+    {
+        sprintf(name, "L%d", i);
+        label_table_add(&table, name, 100 + i, LABELTYPE_CODE);
+    }
+    for (i = 0; i < 100 && !failed; i++)
+    {
+        sprintf(name, "L%d", i);
+        failed = label_table_search(&table, name) != i || ((size_t)table.labels[i].name % sizeof(void*)) != 0;
+    }
+    if (!failed && arena.allocations == 100 && arena.blocks > 1)
+        log_test("Test_arena_alloc", TEST_PASS, "Labels copied into aligned arena memory.");
+    else
+        log_test("Test_arena_alloc", TEST_FAIL, "Arena allocations are wrong or misaligned.");
+    label_table_destroy(&table);
+
+    /* an allocation larger than a block gets a block of its own */
+    big = arena_calloc(&arena, 1, 1000);
+    if (big != NULL && big[0] == 0 && big[999] == 0)
+        log_test("Test_arena_large_alloc", TEST_PASS, "Large allocation served and zeroed.");
+    else
+        log_test("Test_arena_large_alloc", TEST_FAIL, "Large allocation failed.");
+
+    /* a reset releases everything, the next job reuses the blocks */
+    blocks = arena.blocks;
+    arena_reset(&arena);
+    for (i = 0; i < 100; i++)
+        arena_strdup(&arena, "reused");
+    if (arena.bytes_used > 0 && arena.allocations == 100 && arena.blocks == blocks)
+        log_test("Test_arena_reset", TEST_PASS, "Reset arena reused its blocks.");
+    else
+        log_test("Test_arena_reset", TEST_FAIL, "Reset arena allocated new blocks.");
+
+    arena_destroy(&arena);
+    if (arena.blocks == 0 && arena.first == NULL)
+        log_test("Test_arena_destroy", TEST_PASS, "Every block freed.");
+    else
+        log_test("Test_arena_destroy", TEST_FAIL, "Blocks left after destroy.");
+
+    log_out(__FILE__,__LINE__, "Done - Testing Arena Allocator\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+
+/* =======================
+   Test: Fix-up List
+   ======================= */
+void test_fixup_list()
+{
+    FixupList list;
+    const Fixup* fixup;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Fix-up List in fixup_list.h\n");
+
+    fixup_list_init(&list, NULL);
+    fixup_list_add(&list, 101, "LIST", 4);
+    fixup_list_add(&list, 104, "&LOOP", 5);
+    fixup_list_add(&list, 107, "LOOP, r2", 4);   /* only the label characters are stored */
+    fixup_list_add(&list, 103, "LIST", 4);       /* out of order, kept sorted by address */
+
+    if (list.count == 4 && list.symbol_count == 2 &&
+        list.data[0].address == 101 && list.data[1].address == 103 && list.data[3].address == 107 &&
+        list.data[0].symbol == list.data[1].symbol && list.data[2].symbol == list.data[3].symbol)
+        log_test("Test_fixup_list_add", TEST_PASS, "Fix-ups sorted by address, every label stored once.");
+    else
+        log_test("Test_fixup_list_add", TEST_FAIL, "Fix-ups out of order or labels stored twice.");
+
+    fixup = fixup_list_find(&list, 104);
+    if (fixup != NULL && fixup->kind == FIXUP_RELATIVE && strcmp(list.symbols[fixup->symbol].name, "LOOP") == 0 &&
+        fixup_list_find(&list, 101)->kind == FIXUP_DIRECT && fixup_list_find(&list, 102) == NULL)
+        log_test("Test_fixup_list_find", TEST_PASS, "Relative reference found without its '&'.");
+    else
+        log_test("Test_fixup_list_find", TEST_FAIL, "Wrong fix-up found for an address.");
+
+    /* a single pass drops the fix-ups of the words it wrote, the symbols are kept */
+    fixup_list_release(&list, 104);
+    if (list.count == 2 && list.data[0].address == 104 && fixup_list_find(&list, 101) == NULL &&
+        fixup_list_find_symbol(&list, "LIST", 4) == 0 && fixup_list_find_symbol(&list, "LOOP, r2", 4) == 1 &&
+        fixup_list_find_symbol(&list, "MAIN", 4) == INVALID_RETURN)
+        log_test("Test_fixup_list_release", TEST_PASS, "Released fix-ups dropped, symbols still found.");
+    else
+        log_test("Test_fixup_list_release", TEST_FAIL, "Wrong fix-ups released or symbols lost.");
+
+    fixup_list_destroy(&list);
+    log_out(__FILE__,__LINE__, "Done - Testing Fix-up List\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
@@ -39,5 +39,10 @@ void log_test(const char* test_name, TestResultType result, const char* details)
            timestamp, test_name, test_result_to_string(result), details ? details : "N/A");
 }
 
+/* Returns the processor time in milliseconds since 'start', for the benchmarks */
+double elapsed_ms(clock_t start)
+{
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
 
 #endif
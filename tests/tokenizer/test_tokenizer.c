@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../test_framework.h"
+#include "../../src/logger.h"
+#include "../../src/tokenizer.h"
+#include "../../src/label_table.h"
+#include "../../src/instruction_table.h"
+#include "../../src/binary_table.h"
+#include "../../src/fixup_list.h"
+#include "../../src/asm_context.h"
+#include "../../src/common.h"
+
+void test_next_token();
+void test_token_prefixes();
+void test_label_table_search_n();
+void test_instruction_table_get_n();
+void test_binary_node_add_label();
+void test_first_pass_tokens();
+
+int main()
+{
+    test_next_token();
+    test_token_prefixes();
+    test_label_table_search_n();
+    test_instruction_table_get_n();
+    test_binary_node_add_label();
+    test_first_pass_tokens();
+    return 0;
+}
+
+/* Checks the characters and the kind of a token */
+static int token_is(const Token* token, const char* text, TokenKind kind)
+{
+    return token->length == (int)strlen(text) && strncmp(token->text, text, token->length) == 0 &&
+        token->kind == kind;
+}
+
+/* =======================
+   Test: next_token
+   ======================= */
+void test_next_token()
+{
+    const char* line = "  MAIN: mov #-5 ,r3 &LOOP \"ab\" .data\n";
+    const char* expected[] = { "MAIN:", "mov", "#-5", ",r3", "&LOOP", "\"ab\"", ".data" };
+    TokenKind kinds[] = { TOKEN_KIND_WORD, TOKEN_KIND_WORD, TOKEN_KIND_IMMEDIATE, TOKEN_KIND_COMMA,
+        TOKEN_KIND_RELATIVE, TOKEN_KIND_STRING, TOKEN_KIND_DIRECTIVE };
+    Token token;
+    int position = 0;
+    int count = 0;
+    int failed = 0;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Tokenizer Functions in tokenizer.h\n");
+
+    while ((position = next_token(line, position, &token)) != INVALID_RETURN)
+    {
+        if (count >= 7 || !token_is(&token, expected[count], kinds[count]) || token.end != position ||
+            token.text < line || token.text + token.length > line + strlen(line))
+            failed = 1;
+        count++;
+    }
+    if (!failed && count == 7)
+        log_test("Test_next_token_kinds", TEST_PASS, "Every token read in place with its kind.");
+    else
+        log_test("Test_next_token_kinds", TEST_FAIL, "Wrong token, kind or position.");
+
+    if (token.length == 0 && token.end == INVALID_RETURN &&
+        next_token("   \t\n", 0, &token) == INVALID_RETURN && token.length == 0 &&
+        next_token("", 0, &token) == INVALID_RETURN &&
+        next_token("mov", INVALID_RETURN, &token) == INVALID_RETURN && token.length == 0)
+        log_test("Test_next_token_empty", TEST_PASS, "No token past the end of a line or in a blank line.");
+    else
+        log_test("Test_next_token_empty", TEST_FAIL, "A token was read from an empty line.");
+
+    log_out(__FILE__,__LINE__, "Done - Testing Tokenizer Functions\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* =======================
+   Test: Prefix narrowing
+   ======================= */
+void test_token_prefixes()
+{
+    Token token;
+    int failed = 0;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Token Narrowing in tokenizer.h\n");
+
+    next_token("#-12", 0, &token);
+    token_drop_first(&token);
+    failed |= !token_is(&token, "-12", TOKEN_KIND_WORD) || token_to_int(&token) != -12;
+
+    next_token("&LOOP", 0, &token);
+    token_drop_first(&token);
+    failed |= !token_is(&token, "LOOP", TOKEN_KIND_WORD) || token_is_label(&token) != VALID_RETURN;
+
+    next_token("r7", 0, &token);
+    failed |= token_is_register(&token) != VALID_RETURN;
+    token_drop_first(&token);
+    failed |= !token_is(&token, "7", TOKEN_KIND_WORD) || token_to_int(&token) != 7;
+    if (!failed)
+        log_test("Test_token_drop_prefix", TEST_PASS, "'#', '&' and 'r' dropped in place.");
+    else
+        log_test("Test_token_drop_prefix", TEST_FAIL, "Wrong token after dropping its prefix.");
+
+    failed = 0;
+    next_token("\"abc\"", 0, &token);
+    token_drop_first(&token);
+    token_drop_last(&token);
+    failed |= !token_is(&token, "abc", TOKEN_KIND_WORD);
+
+    next_token("MAIN: mov", 0, &token);
+    failed |= token_last_char(&token) != COLON;
+    token_drop_last(&token);
+    failed |= !token_is(&token, "MAIN", TOKEN_KIND_WORD) || !token_equals(&token, "MAIN") ||
+        token_equals(&token, "MAIN:") || token_equals(&token, "MAI");
+    if (!failed)
+        log_test("Test_token_drop_quotes_colon", TEST_PASS, "Quotes and the label ':' dropped in place.");
+    else
+        log_test("Test_token_drop_quotes_colon", TEST_FAIL, "Wrong token after dropping quotes or ':'.");
+
+    failed = 0;
+    next_token("#", 0, &token);
+    token_drop_first(&token);
+    failed |= token.length != 0 || token.kind != TOKEN_KIND_WORD || token_last_char(&token) != NULL_TERMINATOR;
+    token_drop_first(&token);
+    token_drop_last(&token);
+    failed |= token.length != 0;
+    next_token("&#5", 0, &token);
+    token_drop_first(&token);
+    failed |= token.kind != TOKEN_KIND_IMMEDIATE;
+    if (!failed)
+        log_test("Test_token_drop_empty", TEST_PASS, "A bare prefix narrows to an empty token and stays empty.");
+    else
+        log_test("Test_token_drop_empty", TEST_FAIL, "Narrowing a bare prefix went past the token.");
+
+    log_out(__FILE__,__LINE__, "Done - Testing Token Narrowing\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* =======================
+   Test: label_table_search_n
+   ======================= */
+void test_label_table_search_n()
+{
+    /* not null terminated, the lookups must stop at the length */
+    char names[] = { 'M', 'A', 'I', 'N', 'L', 'O', 'O', 'P' };
+    LabelTable table;
+    int main_index;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Length-Bounded Label Search in label_table.h\n");
+
+    label_table_create(&table, NULL);
+    label_table_add_n(&table, names, 4, 100, LABELTYPE_CODE);
+    label_table_add_n(&table, names + 4, 4, 107, LABELTYPE_DATA);
+    main_index = label_table_search(&table, "MAIN");
+
+    if (main_index >= 0 && label_table_search_n(&table, names, 4) == main_index &&
+        label_table_search_n(&table, names + 4, 4) == label_table_search(&table, "LOOP") &&
+        strcmp(table.labels[main_index].name, "MAIN") == 0)
+        log_test("Test_label_table_search_n", TEST_PASS, "Labels found by a slice of a longer buffer.");
+    else
+        log_test("Test_label_table_search_n", TEST_FAIL, "Label not found by its slice.");
+
+    if (label_table_search_n(&table, names, 3) == INVALID_RETURN &&
+        label_table_search_n(&table, names, 5) == INVALID_RETURN &&
+        label_table_search_n(&table, names, 8) == INVALID_RETURN &&
+        label_table_search_n(&table, names + 4, 0) == INVALID_RETURN)
+        log_test("Test_label_table_search_n_prefix", TEST_PASS, "Prefixes and longer slices aren't matched.");
+    else
+        log_test("Test_label_table_search_n_prefix", TEST_FAIL, "A slice matched a label of another length.");
+
+    label_table_destroy(&table);
+    log_out(__FILE__,__LINE__, "Done - Testing Length-Bounded Label Search\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* =======================
+   Test: instruction_table_get_n
+   ======================= */
+void test_instruction_table_get_n()
+{
+    char names[] = { 'm', 'o', 'v', 's', 't', 'o', 'p', 'p' };
+    InstructionTable table;
+    InstructionNode* node;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Length-Bounded Instruction Lookup in instruction_table.h\n");
+
+    instruction_table_create(&table);
+    instruction_table_insert(&table, "mov", 0, 0);
+    instruction_table_insert(&table, "stop", 15, 0);
+
+    node = instruction_table_get_n(&table, names, 3);
+    if (node != NULL && strcmp(node->op_name, "mov") == 0 &&
+        (node = instruction_table_get_n(&table, names + 3, 4)) != NULL && node->op_code == 15)
+        log_test("Test_instruction_table_get_n", TEST_PASS, "Instructions found by a slice of a longer buffer.");
+    else
+        log_test("Test_instruction_table_get_n", TEST_FAIL, "Instruction not found by its slice.");
+
+    if (instruction_table_get_n(&table, names, 2) == NULL &&
+        instruction_table_get_n(&table, names + 3, 5) == NULL &&
+        instruction_table_get_n(&table, names, 0) == NULL &&
+        instruction_table_get_n(&table, names, sizeof(names)) == NULL)
+        log_test("Test_instruction_table_get_n_length", TEST_PASS, "Slices of other lengths aren't matched.");
+    else
+        log_test("Test_instruction_table_get_n_length", TEST_FAIL, "A slice matched an instruction of another length.");
+
+    if (instruction_table_get_n(&table, "MOV", 3) == NULL && instruction_table_get_n(&table, "Stop", 4) == NULL)
+        log_test("Test_instruction_table_get_n_case", TEST_PASS, "Upper case names aren't instructions.");
+    else
+        log_test("Test_instruction_table_get_n_case", TEST_FAIL, "An upper case name was found.");
+
+    instruction_table_destroy(&table);
+    log_out(__FILE__,__LINE__, "Done - Testing Length-Bounded Instruction Lookup\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* =======================
+   Test: binary_node_add_label
+   ======================= */
+void test_binary_node_add_label()
+{
+    const char* line = "jmp &LOOP, LIST";
+    BinaryTable* table;
+    Fixup* relative;
+    Fixup* direct;
+    int symbol;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - Label Words in binary_table.h\n");
+
+    table = binary_table_create(4, NULL);
+    /* the labels are slices of the line, followed by more characters */
+    binary_node_add_label(table, 101, NODE_TEXT_LABEL_DISTANCE, line + 4, 5);
+    binary_node_add_label(table, 102, NODE_TEXT_LABEL_ADDRESS, line + 11, 4);
+
+    relative = fixup_list_find(&table->fixups, 101);
+    direct = fixup_list_find(&table->fixups, 102);
+    symbol = fixup_list_find_symbol(&table->fixups, "LOOP", 4);
+    if (binary_table_search(table, 101) >= 0 && binary_table_search(table, 102) >= 0 &&
+        relative != NULL && relative->kind == FIXUP_RELATIVE && (int)relative->symbol == symbol &&
+        strcmp(table->fixups.symbols[relative->symbol].name, "LOOP") == 0 &&
+        direct != NULL && direct->kind == FIXUP_DIRECT &&
+        strcmp(table->fixups.symbols[direct->symbol].name, "LIST") == 0)
+        log_test("Test_binary_node_add_label", TEST_PASS, "Label words added with their fix-ups, '&' dropped.");
+    else
+        log_test("Test_binary_node_add_label", TEST_FAIL, "Wrong node or fix-up for a label word.");
+
+    /* a word that can't be added records no fix-up */
+    binary_node_add_label(table, 101, NODE_TEXT_LABEL_ADDRESS, "MAIN", 4);
+    if (table->fixups.count == 2 && fixup_list_find_symbol(&table->fixups, "MAIN", 4) == INVALID_RETURN)
+        log_test("Test_binary_node_add_label_taken", TEST_PASS, "No fix-up for an address that is taken.");
+    else
+        log_test("Test_binary_node_add_label_taken", TEST_FAIL, "A fix-up was recorded for a taken address.");
+
+    binary_table_destroy(table);
+    log_out(__FILE__,__LINE__, "Done - Testing Label Words\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}
+
+/* Assembles a source into memory, returns its result and whether it reported an error */
+static int assemble_source(const char* source, int* reported)
+{
+    FILE* err = tmpfile();
+    AsmContext* context = asm_context_create(NULL, NULL, err);
+    AsmOutput output;
+    int flag;
+
+    flag = asm_context_assemble_buffer(context, "tokens", source, strlen(source), &output);
+    asm_output_free(&output);
+    asm_context_destroy(context);
+    *reported = ftell(err) > 0;
+    fclose(err);
+    return flag;
+}
+
+/* =======================
+   Test: Lines the first pass used to crash on
+   ======================= */
+void test_first_pass_tokens()
+{
+    int reported;
+
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n");
+    log_out(__FILE__,__LINE__, "Starting Test - First-Pass Tokens in first_pass.h\n");
+
+    if (assemble_source("MAIN: MOV r1, r2\nstop\n", &reported) == INVALID_RETURN && reported)
+        log_test("Test_first_pass_upper_case", TEST_PASS, "An upper case mnemonic is reported, not assembled.");
+    else
+        log_test("Test_first_pass_upper_case", TEST_FAIL, "An upper case mnemonic wasn't reported.");
+
+    if (assemble_source("mov r1, r2\nEND:\n", &reported) == INVALID_RETURN && reported &&
+        assemble_source("END:", &reported) == INVALID_RETURN && reported)
+        log_test("Test_first_pass_bare_label", TEST_PASS, "A label with nothing after it is reported once.");
+    else
+        log_test("Test_first_pass_bare_label", TEST_FAIL, "A label with nothing after it wasn't reported.");
+
+    if (assemble_source("MAIN:   mov #-5, r3\nLOOP:   jmp &LOOP\nstop\n", &reported) == VALID_RETURN && !reported)
+        log_test("Test_first_pass_valid", TEST_PASS, "Prefixed operands assembled without errors.");
+    else
+        log_test("Test_first_pass_valid", TEST_FAIL, "Valid operands were reported.");
+
+    log_out(__FILE__,__LINE__, "Done - Testing First-Pass Tokens\n");
+    log_out(__FILE__,__LINE__, "#---------------------------------------------------------#\n\n");
+}